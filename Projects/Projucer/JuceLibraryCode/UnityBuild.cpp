@@ -20,6 +20,8 @@
 #include "../../Source/Core/Audio/Monitoring/SpectrumAnalyzer.cpp"
 #include "../../Source/Core/Audio/Transport/PlayerThread.cpp"
 #include "../../Source/Core/Audio/Transport/RendererThread.cpp"
+#include "../../Source/Core/Audio/Transport/RenderSettings.cpp"
+#include "../../Source/Core/Audio/Transport/BatchRenderer.cpp"
 #include "../../Source/Core/Audio/Transport/Transport.cpp"
 #include "../../Source/Core/Audio/AudioCore.cpp"
 #include "../../Source/Core/Configuration/Models/Arpeggiator.cpp"
@@ -103,6 +105,7 @@
 #include "../../Source/Core/VCS/DiffLogic/ProjectInfoDiffLogic.cpp"
 #include "../../Source/Core/VCS/DiffLogic/ProjectTimelineDiffLogic.cpp"
 #include "../../Source/Core/VCS/Delta.cpp"
+#include "../../Source/Core/VCS/DeltaDataPool.cpp"
 #include "../../Source/Core/VCS/Diff.cpp"
 #include "../../Source/Core/VCS/Head.cpp"
 #include "../../Source/Core/VCS/RemoteCache.cpp"
@@ -254,6 +257,7 @@
 #include "../../Source/UI/Sequencer/PatternRoll/ClipComponents/DummyClipComponent.cpp"
 #include "../../Source/UI/Sequencer/PatternRoll/PatternRoll.cpp"
 #include "../../Source/UI/Sequencer/PianoRoll/NoteComponent.cpp"
+#include "../../Source/UI/Sequencer/PianoRoll/NoteComponentsIndex.cpp"
 #include "../../Source/UI/Sequencer/PianoRoll/NoteResizerLeft.cpp"
 #include "../../Source/UI/Sequencer/PianoRoll/NoteResizerRight.cpp"
 #include "../../Source/UI/Sequencer/PianoRoll/PianoRoll.cpp"
@@ -268,6 +272,7 @@
 #include "../../Source/UI/Sequencer/MiniMaps/LevelsMap/LevelsMapScroller.cpp"
 #include "../../Source/UI/Sequencer/MiniMaps/LevelsMap/VelocityProjectMap.cpp"
 #include "../../Source/UI/Sequencer/MiniMaps/PianoMap/PianoProjectMap.cpp"
+#include "../../Source/UI/Sequencer/MiniMaps/PianoMap/PianoMapTilesCache.cpp"
 #include "../../Source/UI/Sequencer/MiniMaps/PianoMap/ProjectMapScroller.cpp"
 #include "../../Source/UI/Sequencer/MiniMaps/PianoMap/ProjectMapScrollerScreen.cpp"
 #include "../../Source/UI/Sequencer/MiniMaps/TimeSignaturesMap/TimeSignatureLargeComponent.cpp"
@@ -35,6 +35,7 @@
 #include "Workspace.h"
 #include "RootNode.h"
 #include "SerializablePluginDescription.h"
+#include "BatchRenderer.h"
 
 //===----------------------------------------------------------------------===//
 // Window
@@ -440,7 +441,11 @@ bool App::isOpenGLRendererEnabled() noexcept
 void App::initialise(const String &commandLine)
 {
     this->runMode = App::NORMAL;
-    if (commandLine.isNotEmpty() &&
+    if (BatchRenderer::isBatchRenderCommand(commandLine))
+    {
+        this->runMode = App::BATCH_RENDER;
+    }
+    else if (commandLine.isNotEmpty() &&
         DocumentHelpers::getTempSlot(commandLine).existsAsFile())
     {
         this->runMode = App::PLUGIN_CHECK;
@@ -496,6 +501,29 @@ void App::initialise(const String &commandLine)
         this->checkPlugin(commandLine);
         this->quit();
     }
+    else if (this->runMode == App::BATCH_RENDER)
+    {
+#if JUCE_MAC
+        Process::setDockIconVisible(false);
+#endif
+
+        this->config.reset(new class Config());
+        this->config->initResources();
+
+        // projects still create their pages, although those are never shown
+        UniquePointer<HelioTheme> helioTheme(new HelioTheme());
+        helioTheme->initResources();
+        helioTheme->initColours(this->config->getColourSchemes()->getCurrent());
+
+        this->theme.reset(helioTheme.release());
+        LookAndFeel::setDefaultLookAndFeel(this->theme.get());
+
+        this->workspace.reset(new class Workspace());
+        this->workspace->initAudioCoreOnly();
+
+        // will quit when done
+        this->batchRenderer.reset(new BatchRenderer(commandLine));
+    }
 }
 
 void App::shutdown()
@@ -528,6 +556,18 @@ void App::shutdown()
                 
         Logger::setCurrentLogger(nullptr);
     }
+    else if (this->runMode == App::BATCH_RENDER)
+    {
+        // projects go first, then the instruments they use
+        this->batchRenderer = nullptr;
+        this->workspace = nullptr;
+
+        this->theme = nullptr;
+        this->config = nullptr;
+
+        Icons::clearPrerenderedCache();
+        Icons::clearBuiltInImages();
+    }
 }
 
 const String App::getApplicationName()
@@ -536,6 +576,10 @@ const String App::getApplicationName()
     {
         return "Helio Plugin Check";
     }
+    else if (this->runMode == App::BATCH_RENDER)
+    {
+        return "Helio Batch Render";
+    }
 
     return "Helio";
 }
@@ -103,6 +103,7 @@ private:
     UniquePointer<class Workspace> workspace;
     UniquePointer<class MainWindow> window;
     UniquePointer<class Network> network;
+    UniquePointer<class BatchRenderer> batchRenderer;
 
 private:
     
@@ -112,7 +113,8 @@ private:
     enum RunMode
     {
         NORMAL,
-        PLUGIN_CHECK
+        PLUGIN_CHECK,
+        BATCH_RENDER
     };
 
     App::RunMode runMode;
@@ -27,7 +27,8 @@ const int Instrument::midiChannelNumber = 0x1000;
 Instrument::Instrument(AudioPluginFormatManager &formatManager, const String &name) :
     formatManager(formatManager),
     instrumentName(name),
-    instrumentId()
+    instrumentId(),
+    isLoadingNodes(false)
 {
     this->processorGraph.reset(new AudioProcessorGraph());
     this->audioCallback.setProcessor(this->processorGraph.get());
@@ -82,13 +83,20 @@ bool Instrument::isValid() const noexcept
     return this->instrumentName.isNotEmpty();
 }
 
+bool Instrument::isLoading() const noexcept
+{
+    return this->isLoadingNodes;
+}
+
 void Instrument::initializeFrom(const PluginDescription &pluginDescription, InitializationCallback initCallback)
 {
     this->processorGraph->clear();
+    this->isLoadingNodes = true;
 
     this->addNodeAsync(pluginDescription, 0.5f, 0.5f, 
         [initCallback, this](AudioProcessorGraph::Node::Ptr instrument)
         {
+            this->isLoadingNodes = false;
             if (instrument == nullptr) { return; }
 
             InternalPluginFormat f;
@@ -517,8 +525,11 @@ void Instrument::deserialize(const ValueTree &tree)
         nodesToDeserialize.add(e);
     }
 
+    this->isLoadingNodes = true;
     this->deserializeNodesAsync(nodesToDeserialize, [this, connectionDescriptions]()
     {
+        this->isLoadingNodes = false;
+
         for (const auto &connectionInfo : connectionDescriptions)
         {
             this->addConnection(AudioProcessorGraph::NodeID(connectionInfo.sourceNodeId),
@@ -675,6 +686,7 @@ void Instrument::AudioCallback::audioDeviceIOCallback(const float** const inputC
 
     this->incomingMidi.clear();
     this->messageCollector.removeNextBlockOfMessages(this->incomingMidi, numSamples);
+    this->messageScheduler.removeNextBlockOfMessages(this->incomingMidi, numSamples);
     int totalNumChans = 0;
 
     if (numInputChannels > numOutputChannels)
@@ -750,6 +762,7 @@ void Instrument::AudioCallback::audioDeviceAboutToStart(AudioIODevice* const dev
     this->numOutputChans = numChansOut;
 
     this->messageCollector.reset(sampleRate);
+    this->messageScheduler.reset(sampleRate, blockSize);
     this->channels.calloc(jmax(numChansIn, numChansOut) + 2);
 
     if (this->processor != nullptr)
@@ -778,6 +791,7 @@ void Instrument::AudioCallback::audioDeviceStopped()
     this->blockSize = 0;
     this->isPrepared = false;
     this->tempBuffer.setSize(1, 1);
+    this->messageScheduler.reset(0.0, 0);
 }
 
 void Instrument::AudioCallback::handleIncomingMidiMessage(MidiInput *, const MidiMessage &message)
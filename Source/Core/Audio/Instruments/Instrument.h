@@ -21,6 +21,8 @@ class AudioCore;
 class FilterInGraph;
 class Instrument;
 
+#include "MidiMessageScheduler.h"
+
 class Instrument final :
     public Serializable,
     public ChangeBroadcaster // notifies InstrumentEditorPanel
@@ -37,6 +39,10 @@ public:
     String getIdAndHash() const;
     bool isValid() const noexcept;
 
+    // plugins are created asynchronously, so the graph is
+    // not complete until all of the nodes are loaded
+    bool isLoading() const noexcept;
+
     using InitializationCallback = Function<void(Instrument *)>;
 
     void initializeFrom(const PluginDescription &pluginDescription, InitializationCallback initCallback);
@@ -50,6 +56,7 @@ public:
 
         void setProcessor(AudioProcessor *processor);
         MidiMessageCollector &getMidiMessageCollector() noexcept { return messageCollector; }
+        MidiMessageScheduler &getMidiMessageScheduler() noexcept { return messageScheduler; }
 
         void audioDeviceIOCallback(const float **, int, float **, int, int) override;
         void audioDeviceAboutToStart(AudioIODevice *) override;
@@ -70,7 +77,8 @@ public:
         AudioBuffer<float> tempBuffer;
 
         MidiBuffer incomingMidi;
-        MidiMessageCollector messageCollector;
+        MidiMessageCollector messageCollector; // live input and previews
+        MidiMessageScheduler messageScheduler; // playback
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioCallback)
     };
@@ -159,6 +167,7 @@ private:
     AudioPluginFormatManager &formatManager;
     Instrument::AudioCallback audioCallback;
     UniquePointer<AudioProcessorGraph> processorGraph;
+    bool isLoadingNodes;
 
     ValueTree serializeNode(AudioProcessorGraph::Node::Ptr node) const;
 
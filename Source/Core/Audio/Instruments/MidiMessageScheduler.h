@@ -0,0 +1,295 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+/*
+    A look-ahead queue of midi messages for the instrument's audio callback.
+
+    Messages are time-stamped in seconds, using the same clock as MidiMessageCollector,
+    i.e. Time::getMillisecondCounterHiRes() * 0.001, but they are expected to be
+    scheduled a block or two ahead of time. Each message is then placed at its exact
+    sample position within the block it falls into, instead of being spread over
+    the next block together with whatever came in since the last callback.
+
+    The time of each block is derived from the number of samples processed so far,
+    so that the audio thread's wakeup jitter doesn't affect the timing of the notes;
+    the anchor is slowly adjusted to follow the system clock, and is reset if
+    the callbacks go too far off (e.g. after an xrun).
+
+    The queue is a preallocated ring buffer, so that nothing is ever allocated
+    or shifted while holding the lock, and the audio thread only try-locks it:
+    if a player is scheduling right now, the due messages are played in the
+    next block. With no device running, or with the queue full, new messages
+    are dropped (and counted in the stats) instead of piling up.
+*/
+
+class MidiMessageScheduler final
+{
+public:
+
+    MidiMessageScheduler()
+    {
+        this->messages.resize(MidiMessageScheduler::capacity);
+    }
+
+    // The distribution of the timing errors of all scheduled messages,
+    // i.e. how far from the requested time they have been played
+    struct Stats final
+    {
+        static constexpr int numBuckets = 6;
+
+        // errors of up to one sample, 1 ms, 2 ms, 5 ms, 10 ms, and more
+        static double getBucketLimitMs(int bucket, double sampleRate) noexcept
+        {
+            static const double limitsMs[] = { 0.0, 1.0, 2.0, 5.0, 10.0 };
+            return (bucket == 0) ? (1000.0 / sampleRate) : limitsMs[bucket];
+        }
+
+        int numMessages = 0;
+        int numDropped = 0;
+        int buckets[numBuckets] = {};
+        double totalErrorMs = 0.0;
+        double maxErrorMs = 0.0;
+        double sampleRate = 0.0;
+
+        String toString() const
+        {
+            String result;
+            result << this->numMessages << " messages, timing error mean "
+                << String(this->numMessages > 0 ? this->totalErrorMs / this->numMessages : 0.0, 3)
+                << " ms, max " << String(this->maxErrorMs, 3) << " ms, distribution:";
+
+            for (int i = 0; i < numBuckets; ++i)
+            {
+                result << ((i < numBuckets - 1) ?
+                    (" <" + String(getBucketLimitMs(i, this->sampleRate), 3) + "ms: ") : " more: ")
+                    << this->buckets[i];
+            }
+
+            result << ", dropped: " << this->numDropped;
+            return result;
+        }
+    };
+
+    //===------------------------------------------------------------------===//
+    // Called by the players
+    //===------------------------------------------------------------------===//
+
+    // How much ahead of time the messages should be scheduled
+    double getLookAheadMs() const noexcept
+    {
+        const SpinLock::ScopedLockType lock(this->messagesLock);
+        return (this->sampleRate > 0.0) ?
+            (2.0 * this->blockSize * 1000.0 / this->sampleRate) : 0.0;
+    }
+
+    // Owner is used to cancel own scheduled messages,
+    // without touching the ones scheduled by others
+    void scheduleMessage(const MidiMessage &message, const void *owner)
+    {
+        const SpinLock::ScopedLockType lock(this->messagesLock);
+
+        if (this->sampleRate <= 0.0 || this->numPending == MidiMessageScheduler::capacity)
+        {
+            this->stats.numDropped++;
+            return;
+        }
+
+        // messages mostly come in order, so this is typically the end,
+        // otherwise the later ones are moved one slot further
+        int index = this->numPending;
+        while (index > 0 &&
+            this->getPending(index - 1).message.getTimeStamp() > message.getTimeStamp())
+        {
+            this->getPending(index) = this->getPending(index - 1);
+            --index;
+        }
+
+        auto &scheduled = this->getPending(index);
+        scheduled.message = message;
+        scheduled.owner = owner;
+        this->numPending++;
+    }
+
+    // Note-offs are kept, since their note-ons might have been played already,
+    // and the owner doesn't track the notes which are released in the queue
+    void cancelScheduledMessages(const void *owner)
+    {
+        const SpinLock::ScopedLockType lock(this->messagesLock);
+
+        int numKept = 0;
+        for (int i = 0; i < this->numPending; ++i)
+        {
+            const auto &scheduled = this->getPending(i);
+            if (scheduled.owner != owner || scheduled.message.isNoteOff())
+            {
+                if (numKept != i)
+                {
+                    this->getPending(numKept) = scheduled;
+                }
+
+                numKept++;
+            }
+        }
+
+        this->numPending = numKept;
+    }
+
+    Stats getStats() const
+    {
+        const SpinLock::ScopedLockType lock(this->messagesLock);
+        return this->stats;
+    }
+
+    void resetStats()
+    {
+        const SpinLock::ScopedLockType lock(this->messagesLock);
+        this->stats = {};
+        this->stats.sampleRate = this->sampleRate;
+    }
+
+    //===------------------------------------------------------------------===//
+    // Called by the audio callback
+    //===------------------------------------------------------------------===//
+
+    // Drops all pending messages, which would be stale by the time the device restarts
+    void reset(double newSampleRate, int newBlockSize)
+    {
+        const SpinLock::ScopedLockType lock(this->messagesLock);
+        this->firstPending = 0;
+        this->numPending = 0;
+        this->sampleRate = newSampleRate;
+        this->blockSize = newBlockSize;
+        this->hasAnchor = false;
+        this->stats.sampleRate = newSampleRate;
+    }
+
+    // The sample rate and the timing anchor are only changed by reset(),
+    // which is never called concurrently with this, so they need no locking
+    void removeNextBlockOfMessages(MidiBuffer &destBuffer, int numSamples)
+    {
+        const double nowSec = Time::getMillisecondCounterHiRes() * 0.001;
+
+        const double sampleRate = this->sampleRate;
+        if (sampleRate <= 0.0)
+        {
+            return;
+        }
+
+        const double blockDurationSec = numSamples / sampleRate;
+
+        double blockStartSec = this->anchorSec + this->samplesSinceAnchor / sampleRate;
+        const double driftSec = nowSec - blockStartSec;
+
+        if (!this->hasAnchor || std::abs(driftSec) > blockDurationSec * 4.0)
+        {
+            this->anchorSec = nowSec;
+            this->samplesSinceAnchor = 0;
+            this->hasAnchor = true;
+            blockStartSec = nowSec;
+        }
+        else
+        {
+            // follow the system clock, but slowly enough not to introduce any jitter
+            this->anchorSec += driftSec * 0.01;
+        }
+
+        this->samplesSinceAnchor += numSamples;
+
+        // never wait for the players here
+        const SpinLock::ScopedTryLockType lock(this->messagesLock);
+        if (!lock.isLocked())
+        {
+            return;
+        }
+
+        const double blockEndSec = blockStartSec + blockDurationSec;
+        while (this->numPending > 0)
+        {
+            const auto &scheduled = this->getPending(0);
+            const double timeStampSec = scheduled.message.getTimeStamp();
+            if (timeStampSec >= blockEndSec)
+            {
+                break;
+            }
+
+            const int samplePosition = jlimit(0, numSamples - 1,
+                roundToInt((timeStampSec - blockStartSec) * sampleRate));
+
+            destBuffer.addEvent(scheduled.message, samplePosition);
+
+            this->updateStats(blockStartSec + samplePosition / sampleRate - timeStampSec);
+            this->firstPending = (this->firstPending + 1) & (MidiMessageScheduler::capacity - 1);
+            this->numPending--;
+        }
+    }
+
+private:
+
+    // the error is within half a sample for the messages scheduled in time,
+    // and the late ones are played at the beginning of the block
+    void updateStats(double errorSec) noexcept
+    {
+        const double errorMs = std::abs(errorSec) * 1000.0;
+
+        int bucket = 0;
+        while (bucket < Stats::numBuckets - 1 &&
+            errorMs >= Stats::getBucketLimitMs(bucket, this->stats.sampleRate))
+        {
+            ++bucket;
+        }
+
+        this->stats.numMessages++;
+        this->stats.buckets[bucket]++;
+        this->stats.totalErrorMs += errorMs;
+        this->stats.maxErrorMs = jmax(this->stats.maxErrorMs, errorMs);
+    }
+
+    struct ScheduledMessage final
+    {
+        MidiMessage message;
+        const void *owner = nullptr;
+    };
+
+    // the look-ahead is just a couple of blocks, so this is plenty;
+    // has to be a power of two for the index wrapping
+    static constexpr int capacity = 1024;
+
+    ScheduledMessage &getPending(int index) noexcept
+    {
+        return this->messages.getReference((this->firstPending + index) & (MidiMessageScheduler::capacity - 1));
+    }
+
+    // a ring buffer sorted by time stamps, allocated once
+    Array<ScheduledMessage> messages;
+    int firstPending = 0;
+    int numPending = 0;
+    SpinLock messagesLock;
+
+    double sampleRate = 0.0;
+    int blockSize = 0;
+
+    bool hasAnchor = false;
+    double anchorSec = 0.0;
+    int64 samplesSinceAnchor = 0;
+
+    Stats stats;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiMessageScheduler)
+};
@@ -0,0 +1,343 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "BatchRenderer.h"
+#include "ProjectNode.h"
+#include "Transport.h"
+#include "Workspace.h"
+#include "AudioCore.h"
+#include "Config.h"
+#include "SerializationKeys.h"
+
+#define BATCH_RENDER_COMMAND "--render"
+#define BATCH_RENDER_FORMAT_OPTION "--format="
+#define BATCH_RENDER_BENCHMARK_OPTION "--benchmark"
+
+#define BATCH_RENDER_POLL_MS 100
+
+// Instruments' plugins are loaded asynchronously,
+// but something must be really wrong if it takes that long
+#define BATCH_RENDER_LOAD_TIMEOUT_MS 60000
+
+static StringArray getBatchRenderArguments(const String &commandLine)
+{
+    StringArray arguments;
+    for (const auto &token : StringArray::fromTokens(commandLine, true))
+    {
+        if (token.isNotEmpty())
+        {
+            arguments.add(token.unquoted());
+        }
+    }
+
+    return arguments;
+}
+
+BatchRenderer::BatchRenderer(const String &commandLine) :
+    outputExtension("wav"),
+    isBenchmark(false),
+    hasLoadedProjects(false),
+    numFailedRenders(0),
+    totalRenderedSeconds(0.0),
+    loadStartTimeMs(Time::getMillisecondCounterHiRes()),
+    batchStartTimeMs(0.0)
+{
+    for (const auto &argument : getBatchRenderArguments(commandLine))
+    {
+        if (argument == BATCH_RENDER_COMMAND)
+        {
+            continue;
+        }
+        else if (argument.startsWith(BATCH_RENDER_FORMAT_OPTION))
+        {
+            this->outputExtension = argument.fromFirstOccurrenceOf(BATCH_RENDER_FORMAT_OPTION, false, false);
+        }
+        else if (argument == BATCH_RENDER_BENCHMARK_OPTION)
+        {
+            this->isBenchmark = true;
+        }
+        else
+        {
+            this->projectPaths.add(argument);
+        }
+    }
+
+    App::Config().load(&this->renderSettings, Serialization::Config::lastUsedRenderSettings);
+
+    this->startTimer(BATCH_RENDER_POLL_MS);
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    this->stopTimer();
+
+    // project destructors will stop the unfinished renders
+    this->runningJobs.clear();
+    this->pendingJobs.clear();
+}
+
+bool BatchRenderer::isBatchRenderCommand(const String &commandLine)
+{
+    return getBatchRenderArguments(commandLine).contains(BATCH_RENDER_COMMAND);
+}
+
+void BatchRenderer::timerCallback()
+{
+    if (!this->hasLoadedProjects)
+    {
+        // the graphs get their sample rate from the device, nothing to render without it
+        const auto *device = App::Workspace().getAudioCore().getDevice().getCurrentAudioDevice();
+        if (device == nullptr || device->getCurrentSampleRate() <= 0.0)
+        {
+            Logger::writeToLog("No audio device available to render with");
+            this->cancelBatch();
+            return;
+        }
+
+        if (!this->areInstrumentsReady())
+        {
+            if (Time::getMillisecondCounterHiRes() - this->loadStartTimeMs > BATCH_RENDER_LOAD_TIMEOUT_MS)
+            {
+                Logger::writeToLog("Timed out waiting for the instruments to load");
+                this->cancelBatch();
+            }
+
+            return;
+        }
+
+        this->loadProjects();
+        this->hasLoadedProjects = true;
+        this->batchStartTimeMs = Time::getMillisecondCounterHiRes();
+    }
+
+    this->checkRunningRenders();
+    this->startPendingRenders();
+
+    if (this->pendingJobs.isEmpty() && this->runningJobs.isEmpty())
+    {
+        this->stopTimer();
+        this->finishBatch();
+    }
+}
+
+bool BatchRenderer::areInstrumentsReady() const
+{
+    for (const auto *instrument : App::Workspace().getAudioCore().getInstruments())
+    {
+        if (instrument->isLoading() ||
+            instrument->getProcessorGraph()->getSampleRate() <= 0.0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void BatchRenderer::loadProjects()
+{
+    // nothing is played here, and when the render thread is done,
+    // it awakes the audio core, which would re-prepare instruments
+    // with the device settings while other projects are still rendering
+    App::Workspace().getAudioCore().getDevice().closeAudioDevice();
+
+    const auto validExtension = "." + this->outputExtension.toLowerCase();
+    if (validExtension != ".wav" && validExtension != ".flac")
+    {
+        Logger::writeToLog("Unsupported render format: " + this->outputExtension);
+        this->numFailedRenders = this->projectPaths.size();
+        return;
+    }
+
+    for (const auto &path : this->projectPaths)
+    {
+        const File file(File::getCurrentWorkingDirectory().getChildFile(path));
+        if (!file.existsAsFile())
+        {
+            Logger::writeToLog("Project not found: " + path);
+            this->numFailedRenders++;
+            continue;
+        }
+
+        if (!this->isBenchmark)
+        {
+            this->addRenderJob(file, this->renderSettings, file.withFileExtension(validExtension));
+            continue;
+        }
+
+        for (const int blockSize : { 512, 1024, 2048, 4096, 8192 })
+        {
+            for (const bool parallel : { false, true })
+            {
+                RenderSettings settings(this->renderSettings);
+                settings.setBlockSize(blockSize);
+                settings.setParallelProcessing(parallel);
+                this->addRenderJob(file, settings, File::createTempFile(validExtension));
+            }
+        }
+    }
+}
+
+void BatchRenderer::addRenderJob(const File &projectFile,
+    const RenderSettings &settings, const File &outputFile)
+{
+    UniquePointer<ProjectNode> project(new ProjectNode(projectFile));
+    if (!project->getDocument()->load(projectFile.getFullPathName()))
+    {
+        Logger::writeToLog("Failed to load project: " + projectFile.getFullPathName());
+        this->numFailedRenders++;
+        return;
+    }
+
+    auto *job = new RenderJob();
+    job->instruments = project->getTransport().getPlaybackInstruments();
+    job->settings = settings;
+    job->outputFile = outputFile;
+    job->startTimeMs = 0.0;
+    job->project.reset(project.release());
+    this->pendingJobs.add(job);
+}
+
+bool BatchRenderer::canStartRender(const RenderJob &job) const
+{
+    // benchmark renders should not compete for the cores
+    const int maxRunningJobs = this->isBenchmark ? 1 : SystemStats::getNumCpus();
+    if (this->runningJobs.size() >= maxRunningJobs)
+    {
+        return false;
+    }
+
+    for (const auto *runningJob : this->runningJobs)
+    {
+        for (auto *instrument : job.instruments)
+        {
+            if (runningJob->instruments.contains(instrument))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void BatchRenderer::startPendingRenders()
+{
+    for (int i = 0; i < this->pendingJobs.size();)
+    {
+        auto *job = this->pendingJobs.getUnchecked(i);
+        if (!this->canStartRender(*job))
+        {
+            ++i;
+            continue;
+        }
+
+        auto &transport = job->project->getTransport();
+        job->startTimeMs = Time::getMillisecondCounterHiRes();
+        transport.startRender(job->outputFile.getFullPathName(), job->settings);
+
+        if (!transport.isRendering())
+        {
+            Logger::writeToLog((transport.hasRenderFailed() ?
+                "Instruments are not prepared to render: " : "Nothing to render: ") +
+                job->project->getName());
+            this->numFailedRenders++;
+            this->pendingJobs.remove(i, true);
+            continue;
+        }
+
+        this->runningJobs.add(this->pendingJobs.removeAndReturn(i));
+    }
+}
+
+void BatchRenderer::checkRunningRenders()
+{
+    for (int i = this->runningJobs.size(); i --> 0; )
+    {
+        const auto *job = this->runningJobs.getUnchecked(i);
+        const auto &transport = job->project->getTransport();
+        if (transport.isRendering())
+        {
+            continue;
+        }
+
+        if (transport.hasRenderFailed())
+        {
+            Logger::writeToLog("Failed to write: " + job->outputFile.getFullPathName());
+            this->numFailedRenders++;
+        }
+        else
+        {
+            const double renderTimeMs = Time::getMillisecondCounterHiRes() - job->startTimeMs;
+            this->reportRender(*job, renderTimeMs);
+        }
+
+        if (this->isBenchmark)
+        {
+            job->outputFile.deleteFile();
+        }
+
+        this->runningJobs.remove(i, true);
+    }
+}
+
+void BatchRenderer::reportRender(const RenderJob &job, double renderTimeMs)
+{
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    UniquePointer<AudioFormatReader> reader(formatManager.createReaderFor(job.outputFile));
+    if (reader == nullptr || reader->lengthInSamples == 0 || reader->sampleRate <= 0.0)
+    {
+        Logger::writeToLog("Failed to render: " + job.outputFile.getFullPathName());
+        this->numFailedRenders++;
+        return;
+    }
+
+    const double renderedSeconds = double(reader->lengthInSamples) / reader->sampleRate;
+    this->totalRenderedSeconds += renderedSeconds;
+
+    const String renderedFile = this->isBenchmark ?
+        job.project->getDocument()->getFullPath() : job.outputFile.getFullPathName();
+
+    Logger::writeToLog("Rendered " + renderedFile + ": " +
+        String(renderedSeconds, 2) + " seconds in " + String(renderTimeMs / 1000.0, 2) +
+        ", instruments: " + String(job.instruments.size()) +
+        ", block size: " + String(job.settings.getBlockSize()) +
+        (job.settings.shouldProcessInParallel() ? ", parallel" : ", serial") +
+        ", realtime factor: " + String(renderedSeconds / (renderTimeMs / 1000.0), 2));
+}
+
+void BatchRenderer::cancelBatch()
+{
+    this->stopTimer();
+    this->numFailedRenders = this->projectPaths.size();
+    this->batchStartTimeMs = this->loadStartTimeMs;
+    this->finishBatch();
+}
+
+void BatchRenderer::finishBatch()
+{
+    const double batchTimeMs = Time::getMillisecondCounterHiRes() - this->batchStartTimeMs;
+    Logger::writeToLog("Rendered " + String(this->totalRenderedSeconds, 2) + " seconds in " +
+        String(batchTimeMs / 1000.0, 2) + ", " + String(this->numFailedRenders) + " failed");
+
+    JUCEApplication::getInstance()->setApplicationReturnValue(this->numFailedRenders > 0 ? 1 : 0);
+    JUCEApplication::quit();
+}
@@ -0,0 +1,92 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+class ProjectNode;
+class Instrument;
+
+#include "RenderSettings.h"
+
+/*
+    Non-GUI run mode which renders the given projects and quits, e.g.:
+    Helio --render [--format=flac] project1.helio project2.helio
+
+    Each file is rendered next to the project, using the last used render settings.
+    Projects are rendered in parallel as long as they don't share instruments,
+    since a processor graph cannot render two streams at once.
+
+    With --benchmark, each project is rendered into a temporary file with
+    each of the benchmarked block sizes, with the serial and the parallel
+    instruments processing, one render at a time, and the realtime factor
+    of each render is logged along with the number of instruments and the
+    block size; pass the projects using different numbers of instruments
+    to see how the parallel processing scales.
+*/
+
+class BatchRenderer final : private Timer
+{
+public:
+
+    explicit BatchRenderer(const String &commandLine);
+    ~BatchRenderer() override;
+
+    static bool isBatchRenderCommand(const String &commandLine);
+
+private:
+
+    void timerCallback() override;
+
+    bool areInstrumentsReady() const;
+    void loadProjects();
+    void startPendingRenders();
+    void checkRunningRenders();
+    void cancelBatch();
+    void finishBatch();
+
+    struct RenderJob final
+    {
+        UniquePointer<ProjectNode> project;
+        Array<Instrument *> instruments;
+        RenderSettings settings;
+        File outputFile;
+        double startTimeMs;
+    };
+
+    void addRenderJob(const File &projectFile,
+        const RenderSettings &settings, const File &outputFile);
+
+    bool canStartRender(const RenderJob &job) const;
+    void reportRender(const RenderJob &job, double renderTimeMs);
+
+    StringArray projectPaths;
+    String outputExtension;
+    RenderSettings renderSettings;
+    bool isBenchmark;
+
+    OwnedArray<RenderJob> pendingJobs;
+    OwnedArray<RenderJob> runningJobs;
+
+    bool hasLoadedProjects;
+    int numFailedRenders;
+    double totalRenderedSeconds;
+    double loadStartTimeMs;
+    double batchStartTimeMs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchRenderer)
+};
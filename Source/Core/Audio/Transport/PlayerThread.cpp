@@ -25,56 +25,167 @@
 
 PlayerThread::PlayerThread(Transport &transport) :
     Thread("PlayerThread"),
-    transport(transport) {}
+    transport(transport),
+    commandsFifo(commandsQueueSize),
+    lastCommandId(0),
+    playingCommandId(0),
+    lastStartLatencyMs(0.0)
+{
+    this->startThread(10);
+}
 
 PlayerThread::~PlayerThread()
 {
+    this->signalThreadShouldExit();
+    this->notify();
     this->stopThread(MINIMUM_STOP_CHECK_TIME_MS * 2);
 }
 
 //===----------------------------------------------------------------------===//
-// Thread
+// Commands
 //===----------------------------------------------------------------------===//
 
+void PlayerThread::startPlayback(bool shouldBroadcastTransportEvents)
+{
+    this->startPlayback(this->transport.getSeekPosition(), 1.0,
+        false, shouldBroadcastTransportEvents);
+}
+
 void PlayerThread::startPlayback(double start, double end,
     bool shouldLoop, bool shouldBroadcastTransportEvents)
 {
-    this->broadcastMode = shouldBroadcastTransportEvents;
-    this->loopedMode = shouldLoop;
-    this->absStartPosition = jlimit(0.0, 1.0, start);
-    this->absEndPosition = jlimit(0.0, 1.0, end);
-    this->startThread(10);
+    const int id = ++this->lastCommandId;
+    this->playingCommandId = id;
+    this->pushCommand({ PlaybackCommand::Type::Play, id,
+        jlimit(0.0, 1.0, start), jlimit(0.0, 1.0, end),
+        shouldLoop, shouldBroadcastTransportEvents,
+        Time::getMillisecondCounterHiRes() });
+}
+
+void PlayerThread::stopPlayback()
+{
+    const int id = ++this->lastCommandId;
+    this->playingCommandId = 0;
+    this->pushCommand({ PlaybackCommand::Type::Stop, id,
+        0.0, 0.0, false, false, Time::getMillisecondCounterHiRes() });
+}
+
+bool PlayerThread::isPlaying() const noexcept
+{
+    return this->playingCommandId.get() != 0;
+}
+
+double PlayerThread::getLastStartLatencyMs() const noexcept
+{
+    return this->lastStartLatencyMs.get();
+}
+
+void PlayerThread::pushCommand(const PlaybackCommand &command)
+{
+    // the playback thread drains the queue as soon as it's notified,
+    // so it's only full if that thread is somehow stuck for a while
+    while (this->commandsFifo.getFreeSpace() == 0)
+    {
+        this->notify();
+        Thread::yield();
+    }
+
+    int start1, size1, start2, size2;
+    this->commandsFifo.prepareToWrite(1, start1, size1, start2, size2);
+    jassert(size1 == 1);
+    this->commands[start1] = command;
+    this->commandsFifo.finishedWrite(1);
+
+    this->notify();
+}
+
+// Only the latest command matters, e.g. stop followed by play is just play
+bool PlayerThread::popLatestCommand(PlaybackCommand &outCommand)
+{
+    bool hasCommand = false;
+    while (this->commandsFifo.getNumReady() > 0)
+    {
+        int start1, size1, start2, size2;
+        this->commandsFifo.prepareToRead(1, start1, size1, start2, size2);
+        jassert(size1 == 1);
+        outCommand = this->commands[start1];
+        this->commandsFifo.finishedRead(1);
+        hasCommand = true;
+    }
+
+    return hasCommand;
+}
+
+bool PlayerThread::hasPendingCommands() const noexcept
+{
+    return this->commandsFifo.getNumReady() > 0;
 }
 
+//===----------------------------------------------------------------------===//
+// Thread
+//===----------------------------------------------------------------------===//
+
 void PlayerThread::run()
+{
+    while (!this->threadShouldExit())
+    {
+        PlaybackCommand command;
+        if (!this->popLatestCommand(command))
+        {
+            this->wait(-1);
+            continue;
+        }
+
+        if (command.type == PlaybackCommand::Type::Play)
+        {
+            this->play(command);
+        }
+    }
+}
+
+void PlayerThread::play(const PlaybackCommand &command)
 {
     ProjectSequences sequences = this->transport.getPlaybackCache();
     Array<Instrument *> uniqueInstruments(sequences.getUniqueInstruments());
     
-    double nextEventTimeDelta = 0.0;
-    
-    double totalTimeMs = 0.0;
-    double tempoAtTheEndOfTrack = 0.0;
-    this->transport.calcTimeAndTempoAt(1.0, totalTimeMs, tempoAtTheEndOfTrack);
+    const auto tempoMap = this->transport.getTempoMap();
+
+    const double totalTime = this->transport.getTotalTime();
+    const double startPositionInTime = command.absStartPosition * totalTime;
+    const double endPositionInTime = command.absEndPosition * totalTime;
     
-    double currentTimeMs = 0.0;
-    double msPerQuarter = 0.0;
-    this->transport.calcTimeAndTempoAt(this->absStartPosition, currentTimeMs, msPerQuarter);
+    const double totalTimeMs = tempoMap->getTimeAt(totalTime);
+    const double startTimeMs = tempoMap->getTimeAt(startPositionInTime);
+    const double endTimeMs = tempoMap->getTimeAt(endPositionInTime);
+    double msPerQuarter = tempoMap->getTempoAt(startPositionInTime);
+
+    // Messages are scheduled a couple of audio blocks ahead of time,
+    // so that each instrument's callback can place them at exact sample positions
+    double lookAheadMs = 0.0;
+    for (auto *instrument : uniqueInstruments)
+    {
+        auto &scheduler = instrument->getProcessorPlayer().getMidiMessageScheduler();
+        lookAheadMs = jmax(lookAheadMs, scheduler.getLookAheadMs());
+        scheduler.resetStats();
+    }
+
+    // The system time at which the playback time would be zero;
+    // all events are scheduled relative to it, so that the timing errors
+    // don't accumulate, and it only moves forward when the loop rewinds
+    double zeroTimeMs = Time::getMillisecondCounterHiRes() + lookAheadMs - startTimeMs;
+
+    // i.e. when the start position is heard
+    this->lastStartLatencyMs = zeroTimeMs + startTimeMs - command.requestTimeMs;
     
-    if (this->broadcastMode)
+    if (command.broadcastMode)
     {
         this->transport.broadcastTempoChanged(msPerQuarter);
     }
     
-    const double totalTime = this->transport.getTotalTime();
-    const double startPositionInTime = this->absStartPosition * totalTime;
-    const double endPositionInTime = this->absEndPosition * totalTime;
-    
     sequences.seekToTime(startPositionInTime);
-    double prevTimeStamp = startPositionInTime;
-    if (this->broadcastMode)
+    if (command.broadcastMode)
     {
-        this->transport.broadcastSeek(prevTimeStamp / totalTime, currentTimeMs, totalTimeMs);
+        this->transport.broadcastSeek(startPositionInTime / totalTime, startTimeMs, totalTimeMs);
     }
 
     // This hack is here to keep track of still playing events
@@ -83,53 +194,95 @@ void PlayerThread::run()
     {
         int key;
         int channel;
-        MidiMessageCollector *listener;
+        MidiMessageScheduler *scheduler;
     };
     // (some plugins just don't understand allNotesOff message)
     Array<HoldingNote> holdingNotes;
     
     // Some shorthands:
-    auto sendMidiStart = [&uniqueInstruments]()
+    auto getSystemTimeSec = [&zeroTimeMs](double timeMs)
+    {
+        return (zeroTimeMs + timeMs) * 0.001;
+    };
+
+    auto scheduleForEverybody = [this, &uniqueInstruments](const MidiMessage &message)
     {
-        for (auto &instrument : uniqueInstruments)
+        for (auto *instrument : uniqueInstruments)
         {
-            MidiMessage startPlayback(MidiMessage::midiStart());
-            startPlayback.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.001);
-            instrument->getProcessorPlayer().getMidiMessageCollector().addMessageToQueue(startPlayback);
+            instrument->getProcessorPlayer().getMidiMessageScheduler().scheduleMessage(message, this);
         }
     };
 
-    auto sendHoldingNotesOffAndMidiStop = [&holdingNotes, &uniqueInstruments]()
+    auto sendHoldingNotesOffAndMidiStop = [this, &holdingNotes, &uniqueInstruments, &scheduleForEverybody]()
     {
+        // the messages not yet played are not needed anymore, except for the note-offs,
+        // which are no longer in the holding notes, but might still be in the queue
+        for (auto *instrument : uniqueInstruments)
+        {
+            instrument->getProcessorPlayer().getMidiMessageScheduler().cancelScheduledMessages(this);
+        }
+
+        const double nowSec = Time::getMillisecondCounterHiRes() * 0.001;
+
         for (const auto &holding : holdingNotes)
         {
             MidiMessage noteOff(MidiMessage::noteOff(holding.channel, holding.key, 0.f));
-            noteOff.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.001);
-            holding.listener->addMessageToQueue(noteOff);
+            noteOff.setTimeStamp(nowSec);
+            holding.scheduler->scheduleMessage(noteOff, this);
         }
         
         MidiMessage stopPlayback(MidiMessage::midiStop());
-        stopPlayback.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.001);
-        
-        for (auto &instrument : uniqueInstruments)
+        stopPlayback.setTimeStamp(nowSec);
+        scheduleForEverybody(stopPlayback);
+
+#if DEBUG
+        for (auto *instrument : uniqueInstruments)
         {
-            instrument->getProcessorPlayer().getMidiMessageCollector().addMessageToQueue(stopPlayback);
+            const auto stats = instrument->getProcessorPlayer().getMidiMessageScheduler().getStats();
+            DBG("Playback timing for " + instrument->getName() + ": " + stats.toString());
         }
-        
-        // Wait until all plugins process the messages in their queues
-        Thread::sleep(50);
+#endif
     };
-    
-    auto sendTempoChangeToEverybody = [&uniqueInstruments](const MidiMessage &tempoEvent)
+
+    // Waits until it's time to schedule the events at the given playback time,
+    // returns false as soon as there's a new command, or the thread should exit
+    auto waitUntil = [this, &getSystemTimeSec](double timeMs, double aheadMs)
     {
-        for (auto &instrument : uniqueInstruments)
+        while (!this->threadShouldExit() && !this->hasPendingCommands())
         {
-            instrument->getProcessorPlayer().getMidiMessageCollector().addMessageToQueue(tempoEvent);
+            const double remainingMs = getSystemTimeSec(timeMs) * 1000.0 -
+                aheadMs - Time::getMillisecondCounterHiRes();
+
+            if (remainingMs <= 0.0)
+            {
+                return true;
+            }
+
+            this->wait(jlimit(1, MINIMUM_STOP_CHECK_TIME_MS, int(remainingMs)));
         }
+
+        return false;
     };
-    
+
+    double lastBroadcastTimeMs = startTimeMs;
+
+    auto rewind = [&]()
+    {
+        zeroTimeMs += (endTimeMs - startTimeMs);
+        lastBroadcastTimeMs = startTimeMs;
+        sequences.seekToTime(startPositionInTime);
+        msPerQuarter = tempoMap->getTempoAt(startPositionInTime);
+        if (command.broadcastMode)
+        {
+            this->transport.broadcastTempoChanged(msPerQuarter);
+            this->transport.broadcastSeek(startPositionInTime / totalTime, startTimeMs, totalTimeMs);
+        }
+    };
+
     // And here we go.
-    sendMidiStart();
+    MidiMessage startPlayback(MidiMessage::midiStart());
+    startPlayback.setTimeStamp(getSystemTimeSec(startTimeMs));
+    scheduleForEverybody(startPlayback);
     
     while (1)
     {
@@ -138,39 +291,32 @@ void PlayerThread::run()
         // Handle playback from the last event to the end of track:
         if (!sequences.getNextMessage(wrapper))
         {
-            nextEventTimeDelta = msPerQuarter * (endPositionInTime - prevTimeStamp);
-            const uint32 targetTime = Time::getMillisecondCounter() + uint32(nextEventTimeDelta);
-
-            // Give thread a chance to exit by checking at least once a, say, second
-            while (nextEventTimeDelta > MINIMUM_STOP_CHECK_TIME_MS)
+            // in the looped mode, the next round is scheduled ahead as usual,
+            // otherwise just let the scheduled messages play till the end
+            if (!waitUntil(endTimeMs, command.loopedMode ? lookAheadMs : 0.0))
             {
-                nextEventTimeDelta -= MINIMUM_STOP_CHECK_TIME_MS;
-                Thread::sleep(MINIMUM_STOP_CHECK_TIME_MS);
-                if (this->threadShouldExit())
-                {
-                    sendHoldingNotesOffAndMidiStop();
-                    return;
-                }
+                sendHoldingNotesOffAndMidiStop();
+                return;
             }
 
-            Time::waitForMillisecondCounter(targetTime);
-
-            if (this->loopedMode)
+            if (command.loopedMode)
             {
-                sequences.seekToTime(startPositionInTime);
-                prevTimeStamp = startPositionInTime;
-                if (this->broadcastMode)
-                {
-                    this->transport.broadcastSeek(prevTimeStamp / totalTime, currentTimeMs, totalTimeMs);
-                }
+                rewind();
                 continue;
             }
             else
             {
                 sendHoldingNotesOffAndMidiStop();
+
+                // only if nobody has started or stopped the playback in the meantime
+                if (!this->playingCommandId.compareAndSetBool(0, command.id))
+                {
+                    return;
+                }
+
                 this->transport.allNotesControllersAndSoundOff();
 
-                if (this->broadcastMode)
+                if (command.broadcastMode)
                 {
                     this->transport.seekToPosition(this->transport.getSeekPosition());
                     this->transport.broadcastStop();
@@ -180,81 +326,63 @@ void PlayerThread::run()
         }
 
         const bool shouldRewind =
-            (this->loopedMode &&
+            (command.loopedMode &&
             (wrapper.message.getTimeStamp() > endPositionInTime));
 
         const double nextEventTimeStamp =
             shouldRewind ? endPositionInTime : wrapper.message.getTimeStamp();
 
-        nextEventTimeDelta = msPerQuarter * (nextEventTimeStamp - prevTimeStamp);
-        currentTimeMs += nextEventTimeDelta;
-        prevTimeStamp = nextEventTimeStamp;
+        const double nextEventTimeMs = tempoMap->getTimeAt(nextEventTimeStamp);
 
-        // Zero-delay check (we're playing a chord or so)
-        if (uint32(nextEventTimeDelta) != 0)
+        if (!waitUntil(nextEventTimeMs, lookAheadMs))
         {
-            const uint32 targetTime = Time::getMillisecondCounter() + uint32(nextEventTimeDelta);
-            while (nextEventTimeDelta > MINIMUM_STOP_CHECK_TIME_MS)
-            {
-                nextEventTimeDelta -= MINIMUM_STOP_CHECK_TIME_MS;
-                Thread::sleep(MINIMUM_STOP_CHECK_TIME_MS);
-                if (this->threadShouldExit())
-                {
-                    sendHoldingNotesOffAndMidiStop();
-                    return;
-                }
-            }
-
-            Time::waitForMillisecondCounter(targetTime);
+            sendHoldingNotesOffAndMidiStop();
+            return;
+        }
 
-            if (this->threadShouldExit())
-            {
-                sendHoldingNotesOffAndMidiStop();
-                return;
-            }
+        // Zero-delay check (we're playing a chord or so)
+        if (command.broadcastMode && nextEventTimeMs != lastBroadcastTimeMs)
+        {
+            lastBroadcastTimeMs = nextEventTimeMs;
 
-            if (this->broadcastMode)
-            {
-                this->transport.broadcastSeek(prevTimeStamp / totalTime, currentTimeMs, totalTimeMs);
-            }
+            // the event is going to be heard after the look-ahead time, not right now
+            const double currentTimeMs = jmax(startTimeMs, nextEventTimeMs - lookAheadMs);
+            this->transport.broadcastSeek(tempoMap->getBeatAt(currentTimeMs) / totalTime,
+                currentTimeMs, totalTimeMs);
         }
-        
+
         if (shouldRewind)
         {
-            sequences.seekToTime(startPositionInTime);
-            prevTimeStamp = startPositionInTime;
-            if (this->broadcastMode)
-            {
-                this->transport.broadcastSeek(prevTimeStamp / totalTime, currentTimeMs, totalTimeMs);
-            }
+            rewind();
         }
         else
         {
             const int key = wrapper.message.getNoteNumber();
             const int channel = wrapper.message.getChannel();
-            wrapper.message.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.001);
+            auto *scheduler = &wrapper.instrument->getProcessorPlayer().getMidiMessageScheduler();
+            wrapper.message.setTimeStamp(getSystemTimeSec(nextEventTimeMs));
             
             // Master tempo event is sent to everybody
             if (wrapper.message.isTempoMetaEvent())
             {
                 msPerQuarter = wrapper.message.getTempoSecondsPerQuarterNote() * 1000.f;
 
-                if (this->broadcastMode)
+                if (command.broadcastMode)
                 {
                     this->transport.broadcastTempoChanged(msPerQuarter);
                 }
 
                 // Sends this to everybody (need to do that for drum-machines) - TODO test
-                sendTempoChangeToEverybody(wrapper.message);
+                scheduleForEverybody(wrapper.message);
             }
             else
             {
-                wrapper.listener->addMessageToQueue(wrapper.message);
+                scheduler->scheduleMessage(wrapper.message, this);
             }
             
             if (wrapper.message.isNoteOn())
             {
-                holdingNotes.add({ key, channel, wrapper.listener });
+                holdingNotes.add({ key, channel, scheduler });
             }
             
             if (wrapper.message.isNoteOff())
@@ -263,7 +391,7 @@ void PlayerThread::run()
                 {
                     if (holdingNotes[i].key == key &&
                         holdingNotes[i].channel == channel &&
-                        holdingNotes[i].listener == wrapper.listener)
+                        holdingNotes[i].scheduler == scheduler)
                     {
                         holdingNotes.remove(i);
                         break;
@@ -15,31 +15,76 @@
     along with Helio. If not, see <http://www.gnu.org/licenses/>.
 */
 
+
 #pragma once
 
 #include "Transport.h"
 
-class PlayerThread final : public Thread
+/*
+    A single long-lived playback engine per transport.
+
+    The message thread only pushes commands into a lock-free queue and wakes
+    the playback thread up, so that restarting the playback on every seek or loop
+    change doesn't create or stop any threads; the playback thread interrupts
+    whatever it's playing as soon as a new command arrives.
+*/
+
+class PlayerThread final : private Thread
 {
 public:
 
     explicit PlayerThread(Transport &transport);
     ~PlayerThread() override;
 
+    //===------------------------------------------------------------------===//
+    // Called from the message thread
+    //===------------------------------------------------------------------===//
+
+    void startPlayback(bool shouldBroadcastTransportEvents = true);
     void startPlayback(double start, double end, bool shouldLoop,
         bool shouldBroadcastTransportEvents = true);
 
+    void stopPlayback();
+    bool isPlaying() const noexcept;
+
+    // The time from the last start command to the moment
+    // when its start position is heard, including the look-ahead
+    double getLastStartLatencyMs() const noexcept;
+
 private:
 
+    struct PlaybackCommand final
+    {
+        enum class Type { Play, Stop };
+
+        Type type;
+        int id;
+        double absStartPosition;
+        double absEndPosition;
+        bool loopedMode;
+        bool broadcastMode;
+        double requestTimeMs;
+    };
+
+    void pushCommand(const PlaybackCommand &command);
+    bool popLatestCommand(PlaybackCommand &outCommand);
+    bool hasPendingCommands() const noexcept;
+
     void run() override;
 
+    // Returns when the playback ends, or is interrupted by a new command
+    void play(const PlaybackCommand &command);
+
     Transport &transport;
 
-    bool broadcastMode = false;
-    bool loopedMode = false;
+    static constexpr int commandsQueueSize = 32;
+    AbstractFifo commandsFifo;
+    PlaybackCommand commands[commandsQueueSize];
+
+    Atomic<int> lastCommandId;
+    Atomic<int> playingCommandId; // zero when stopped
 
-    double absStartPosition = 0.0;
-    double absEndPosition = 1.0;
+    Atomic<double> lastStartLatencyMs;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PlayerThread)
 };
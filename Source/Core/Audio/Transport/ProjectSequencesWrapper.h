@@ -24,19 +24,58 @@ class MidiSequence;
 struct CachedMidiSequence final : public ReferenceCountedObject
 {
     MidiMessageSequence midiMessages;
-    int currentIndex;
     MidiMessageCollector *listener;
     Instrument *instrument;
     const MidiSequence *track;
 
+    // The longest note in the sequence, which limits the search
+    // for the notes sounding at some point in time, see updateSeekIndex()
+    double maxNoteLength = 0.0;
+
     using Ptr = ReferenceCountedObjectPtr<CachedMidiSequence>;
 
+    // Should be called once the sequence is filled and its pairs are matched
+    void updateSeekIndex()
+    {
+        this->maxNoteLength = 0.0;
+        for (int i = 0; i < this->midiMessages.getNumEvents(); ++i)
+        {
+            const auto *noteOnHolder = this->midiMessages.getEventPointer(i);
+            if (const auto *noteOffHolder = noteOnHolder->noteOffObject)
+            {
+                this->maxNoteLength = jmax(this->maxNoteLength,
+                    noteOffHolder->message.getTimeStamp() - noteOnHolder->message.getTimeStamp());
+            }
+        }
+    }
+
+    // Returns the index of the first event at or after the given timestamp,
+    // the events are always sorted, so this is a binary search
+    int getNextIndexAtTime(double timeStamp) const noexcept
+    {
+        int low = 0;
+        int high = this->midiMessages.getNumEvents();
+        while (low < high)
+        {
+            const int mid = (low + high) / 2;
+            if (this->midiMessages.getEventPointer(mid)->message.getTimeStamp() < timeStamp)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+
+        return low;
+    }
+
     static Ptr createFrom(Instrument *instrument, const MidiSequence *track = nullptr)
     {
         jassert(instrument != nullptr);
         CachedMidiSequence::Ptr wrapper(new CachedMidiSequence());
         wrapper->track = track;
-        wrapper->currentIndex = 0;
         wrapper->instrument = instrument;
         wrapper->listener = &instrument->getProcessorPlayer().getMidiMessageCollector();
         return wrapper;
@@ -51,6 +90,16 @@ struct CachedMidiMessage final : public ReferenceCountedObject
     using Ptr = ReferenceCountedObjectPtr<CachedMidiMessage>;
 };
 
+/*
+    A k-way merge of all cached sequences into one ordered stream of messages.
+
+    Each copy of ProjectSequences owns its playback cursor (per-sequence indices
+    and a min-heap of sequence heads), while the cached sequences themselves are
+    shared and never modified after they are added. So whoever iterates the copy,
+    i.e. the player or the renderer thread, does this without any locking,
+    and getNextMessage() costs O(log k) instead of O(k) for k sequences.
+*/
+
 class ProjectSequences final
 {
 private:
@@ -58,13 +107,36 @@ private:
     Array<Instrument *> uniqueInstruments;
     ReferenceCountedArray<CachedMidiSequence> sequences;
 
+    struct SequenceHead final
+    {
+        double timeStamp;
+        int sequenceIndex;
+
+        // the heap keeps the earliest message on top, and for the messages
+        // with equal timestamps, the one from the first added sequence wins
+        inline bool operator< (const SequenceHead &other) const noexcept
+        {
+            return (this->timeStamp > other.timeStamp) ||
+                (this->timeStamp == other.timeStamp &&
+                    this->sequenceIndex > other.sequenceIndex);
+        }
+    };
+
+    Array<int> currentIndices;
+    Array<SequenceHead> heads;
+
 public:
     
     ProjectSequences() {}
     
-    ProjectSequences(const ProjectSequences &other) :
-    sequences(other.sequences),
-    uniqueInstruments(other.uniqueInstruments) {}
+    ProjectSequences(const ProjectSequences &other)
+    {
+        const SpinLock::ScopedLockType lock(other.sequencesLock);
+        this->sequences = other.sequences;
+        this->uniqueInstruments = other.uniqueInstruments;
+        this->currentIndices = other.currentIndices;
+        this->heads = other.heads;
+    }
     
     inline Array<Instrument *> getUniqueInstruments() const noexcept
     {
@@ -79,6 +151,8 @@ public:
         {
             this->uniqueInstruments.addIfNotAlreadyThere(newWrapper->instrument);
             this->sequences.add(newWrapper);
+            this->currentIndices.add(0);
+            this->pushHead(this->sequences.size() - 1);
         }
     }
     
@@ -87,6 +161,8 @@ public:
         const SpinLock::ScopedLockType lock(this->sequencesLock);
         this->uniqueInstruments.clear();
         this->sequences.clear();
+        this->currentIndices.clear();
+        this->heads.clear();
     }
     
     inline bool isEmpty() const
@@ -151,56 +227,43 @@ public:
 
     void seekToTime(double position)
     {
-        const SpinLock::ScopedLockType lock(this->sequencesLock);
-        
         for (int i = 0; i < this->sequences.size(); ++i)
         {
             const auto wrapper = this->sequences.getUnchecked(i);
-            wrapper->currentIndex = this->getNextIndexAtTime(wrapper->midiMessages, (position - DBL_MIN));
+            this->currentIndices.setUnchecked(i,
+                wrapper->getNextIndexAtTime(position - DBL_MIN));
         }
+
+        this->rebuildHeads();
     }
     
     void seekToZeroIndexes()
     {
-        const SpinLock::ScopedLockType lock(this->sequencesLock);
-
         for (int i = 0; i < this->sequences.size(); ++i)
         {
-            this->sequences.getUnchecked(i)->currentIndex = 0;
+            this->currentIndices.setUnchecked(i, 0);
         }
+
+        this->rebuildHeads();
     }
     
     bool getNextMessage(CachedMidiMessage &target)
     {
-        const SpinLock::ScopedLockType lock(this->sequencesLock);
-
-        double minTimeStamp = DBL_MAX;
-        int targetSequenceIndex = -1;
-
-        for (int i = 0; i < this->sequences.size(); ++i)
-        {
-            const auto wrapper = this->sequences.getUnchecked(i);
-            if (wrapper->currentIndex < wrapper->midiMessages.getNumEvents())
-            {
-                MidiMessage &message = wrapper->midiMessages.getEventPointer(wrapper->currentIndex)->message;
-
-                if (message.getTimeStamp() < minTimeStamp)
-                {
-                    minTimeStamp = message.getTimeStamp();
-                    targetSequenceIndex = i;
-                }
-            }
-        }
-
-        if (targetSequenceIndex < 0)
+        if (this->heads.isEmpty())
         {
             return false;
         }
 
+        std::pop_heap(this->heads.begin(), this->heads.end());
+        const int targetSequenceIndex = this->heads.getLast().sequenceIndex;
+        this->heads.removeLast();
+
         const auto foundWrapper = this->sequences.getUnchecked(targetSequenceIndex);
-        MidiMessage &foundMessage = foundWrapper->midiMessages.getEventPointer(foundWrapper->currentIndex)->message;
-        foundWrapper->currentIndex++;
-                
+        const int foundIndex = this->currentIndices.getUnchecked(targetSequenceIndex);
+        const MidiMessage &foundMessage = foundWrapper->midiMessages.getEventPointer(foundIndex)->message;
+        this->currentIndices.setUnchecked(targetSequenceIndex, foundIndex + 1);
+        this->pushHead(targetSequenceIndex);
+
         target.message = foundMessage;
         target.listener = foundWrapper->listener;
         target.instrument = foundWrapper->instrument;
@@ -210,19 +273,25 @@ public:
     
 private:
     
-    int getNextIndexAtTime(const MidiMessageSequence &sequence, double timeStamp) const
+    void pushHead(int sequenceIndex)
     {
-        int i = 0;
-        for (; i < sequence.getNumEvents(); ++i)
+        const auto wrapper = this->sequences.getUnchecked(sequenceIndex);
+        const int index = this->currentIndices.getUnchecked(sequenceIndex);
+        if (index < wrapper->midiMessages.getNumEvents())
         {
-            const double eventTs = sequence.getEventPointer(i)->message.getTimeStamp();
-            if (eventTs >= timeStamp)
-            {
-                break;
-            }
+            const double timeStamp = wrapper->midiMessages.getEventPointer(index)->message.getTimeStamp();
+            this->heads.add({ timeStamp, sequenceIndex });
+            std::push_heap(this->heads.begin(), this->heads.end());
+        }
+    }
+
+    void rebuildHeads()
+    {
+        this->heads.clearQuick();
+        for (int i = 0; i < this->sequences.size(); ++i)
+        {
+            this->pushHead(i);
         }
-        
-        return i;
     }
 
     SpinLock instrumentsLock;
@@ -0,0 +1,120 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "RenderSettings.h"
+#include "SerializationKeys.h"
+
+#define RENDER_DEFAULT_BLOCK_SIZE 512
+#define RENDER_MIN_BLOCK_SIZE 64
+#define RENDER_MAX_BLOCK_SIZE 8192
+
+// 16 bits per sample should be enough for anybody :)
+// ..wanna fight about it? https://people.xiph.org/~xiphmont/demo/neil-young.html
+#define RENDER_DEFAULT_BIT_DEPTH 16
+
+RenderSettings::RenderSettings()
+{
+    this->reset();
+}
+
+int RenderSettings::getBlockSize() const noexcept
+{
+    return this->blockSize;
+}
+
+void RenderSettings::setBlockSize(int newBlockSize) noexcept
+{
+    this->blockSize = jlimit(RENDER_MIN_BLOCK_SIZE, RENDER_MAX_BLOCK_SIZE, newBlockSize);
+}
+
+int RenderSettings::getBitDepth() const noexcept
+{
+    return this->bitDepth;
+}
+
+void RenderSettings::setBitDepth(int newBitDepth) noexcept
+{
+    this->bitDepth = (newBitDepth >= 32) ? 32 : ((newBitDepth > 16) ? 24 : 16);
+}
+
+bool RenderSettings::isFloatOutput() const noexcept
+{
+    return this->bitDepth == 32;
+}
+
+bool RenderSettings::shouldUseDoublePrecision() const noexcept
+{
+    return this->doublePrecision;
+}
+
+void RenderSettings::setDoublePrecision(bool shouldUseDoublePrecision) noexcept
+{
+    this->doublePrecision = shouldUseDoublePrecision;
+}
+
+bool RenderSettings::shouldProcessInParallel() const noexcept
+{
+    return this->parallelProcessing;
+}
+
+void RenderSettings::setParallelProcessing(bool shouldProcessInParallel) noexcept
+{
+    this->parallelProcessing = shouldProcessInParallel;
+}
+
+//===----------------------------------------------------------------------===//
+// Serializable
+//===----------------------------------------------------------------------===//
+
+ValueTree RenderSettings::serialize() const
+{
+    using namespace Serialization;
+    ValueTree tree(Audio::renderSettings);
+    tree.setProperty(Audio::renderBlockSize, this->blockSize, nullptr);
+    tree.setProperty(Audio::renderBitDepth, this->bitDepth, nullptr);
+    tree.setProperty(Audio::renderDoublePrecision, this->doublePrecision, nullptr);
+    tree.setProperty(Audio::renderParallelProcessing, this->parallelProcessing, nullptr);
+    return tree;
+}
+
+void RenderSettings::deserialize(const ValueTree &tree)
+{
+    using namespace Serialization;
+
+    this->reset();
+
+    const auto root = tree.hasType(Audio::renderSettings) ?
+        tree : tree.getChildWithName(Audio::renderSettings);
+
+    if (root.isValid())
+    {
+        this->setBlockSize(root.getProperty(Audio::renderBlockSize, RENDER_DEFAULT_BLOCK_SIZE));
+        this->setBitDepth(root.getProperty(Audio::renderBitDepth, RENDER_DEFAULT_BIT_DEPTH));
+        this->doublePrecision = root.getProperty(Audio::renderDoublePrecision, false);
+        this->parallelProcessing = root.getProperty(Audio::renderParallelProcessing, true);
+    }
+}
+
+void RenderSettings::reset()
+{
+    this->blockSize = RENDER_DEFAULT_BLOCK_SIZE;
+    this->bitDepth = RENDER_DEFAULT_BIT_DEPTH;
+    this->doublePrecision = false;
+    this->parallelProcessing = true;
+}
@@ -0,0 +1,61 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+class RenderSettings final : public Serializable
+{
+public:
+
+    RenderSettings();
+
+    // Larger blocks reduce the per-block overhead for the non-realtime graphs,
+    // this is clamped into a range reasonable for most plugins
+    int getBlockSize() const noexcept;
+    void setBlockSize(int newBlockSize) noexcept;
+
+    // 16 or 24 bits integer output, or 32 for the floating point output;
+    // note that FLAC only supports the integer formats, so it falls back to 24
+    int getBitDepth() const noexcept;
+    void setBitDepth(int newBitDepth) noexcept;
+    bool isFloatOutput() const noexcept;
+
+    // Double precision processing is only used when all graphs support it
+    bool shouldUseDoublePrecision() const noexcept;
+    void setDoublePrecision(bool shouldUseDoublePrecision) noexcept;
+
+    bool shouldProcessInParallel() const noexcept;
+    void setParallelProcessing(bool shouldProcessInParallel) noexcept;
+
+    //===------------------------------------------------------------------===//
+    // Serializable
+    //===------------------------------------------------------------------===//
+
+    ValueTree serialize() const override;
+    void deserialize(const ValueTree &tree) override;
+    void reset() override;
+
+private:
+
+    int blockSize;
+    int bitDepth;
+    bool doublePrecision;
+    bool parallelProcessing;
+
+    JUCE_LEAK_DETECTOR(RenderSettings)
+};
@@ -22,11 +22,201 @@
 #include "Workspace.h"
 #include "AudioCore.h"
 
+// Keeps track of the time spent in actual disk writes
+// to tell them apart from the encoding done by the format writer
+class TimedOutputStream final : public OutputStream
+{
+public:
+
+    TimedOutputStream(FileOutputStream *stream, Atomic<double> &writeTimeMs) :
+        stream(stream),
+        writeTimeMs(writeTimeMs) {}
+
+    void flush() override
+    {
+        const double startMs = Time::getMillisecondCounterHiRes();
+        this->stream->flush();
+        this->writeTimeMs = this->writeTimeMs.get() + (Time::getMillisecondCounterHiRes() - startMs);
+    }
+
+    bool setPosition(int64 newPosition) override
+    {
+        return this->stream->setPosition(newPosition);
+    }
+
+    int64 getPosition() override
+    {
+        return this->stream->getPosition();
+    }
+
+    bool write(const void *dataToWrite, size_t numberOfBytes) override
+    {
+        const double startMs = Time::getMillisecondCounterHiRes();
+        const bool result = this->stream->write(dataToWrite, numberOfBytes);
+        this->writeTimeMs = this->writeTimeMs.get() + (Time::getMillisecondCounterHiRes() - startMs);
+        return result;
+    }
+
+private:
+
+    UniquePointer<FileOutputStream> stream;
+    Atomic<double> &writeTimeMs;
+
+    JUCE_DECLARE_NON_COPYABLE(TimedOutputStream)
+};
+
+// A bounded single-producer single-consumer queue of mixed blocks,
+// which are drained into the format writer by a separate thread:
+// the render thread only waits here when the encoder can't keep up
+class RenderedBlocksWriter final : public Thread
+{
+public:
+
+    RenderedBlocksWriter(AudioFormatWriter &writer, Thread &producer,
+        int numChannels, int blockSize, Atomic<double> &encodeTimeMs,
+        Atomic<double> &writeTimeMs, int numBlocks = 3) :
+        Thread("RenderedBlocksWriter"),
+        writer(writer),
+        producer(producer),
+        fifo(numBlocks),
+        failed(0),
+        encodeTimeMs(encodeTimeMs),
+        writeTimeMs(writeTimeMs)
+    {
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            this->blocks.add(new AudioSampleBuffer(numChannels, blockSize));
+        }
+    }
+
+    ~RenderedBlocksWriter() override
+    {
+        // never kill it, the format writer must outlive any write in progress
+        this->stopThread(-1);
+    }
+
+    // Returns false if the block could not be queued, either because
+    // the writer has failed, or because the render is being stopped
+    bool pushBlock(const AudioSampleBuffer &block, int numSamples)
+    {
+        while (this->fifo.getFreeSpace() == 0)
+        {
+            if (this->hasFailed() || this->producer.threadShouldExit())
+            {
+                return false;
+            }
+
+            this->blockWritten.wait(10);
+        }
+
+        if (this->hasFailed())
+        {
+            return false;
+        }
+
+        int start1, size1, start2, size2;
+        this->fifo.prepareToWrite(1, start1, size1, start2, size2);
+        jassert(size1 == 1);
+
+        auto *target = this->blocks.getUnchecked(start1);
+        target->setSize(block.getNumChannels(), numSamples, false, false, true);
+        for (int c = 0; c < block.getNumChannels(); ++c)
+        {
+            target->copyFrom(c, 0, block, c, 0, numSamples);
+        }
+
+        this->fifo.finishedWrite(1);
+        this->notify();
+        return true;
+    }
+
+    bool hasFailed() const noexcept
+    {
+        return this->failed.get() != 0;
+    }
+
+    // Writes all pending blocks and stops
+    void flushAndStop()
+    {
+        this->signalThreadShouldExit();
+        this->notify();
+        this->waitForThreadToExit(-1);
+    }
+
+private:
+
+    void run() override
+    {
+        while (true)
+        {
+            if (this->fifo.getNumReady() == 0)
+            {
+                if (this->threadShouldExit())
+                {
+                    return;
+                }
+
+                this->wait(10);
+                continue;
+            }
+
+            int start1, size1, start2, size2;
+            this->fifo.prepareToRead(1, start1, size1, start2, size2);
+            jassert(size1 == 1);
+
+            const auto *block = this->blocks.getUnchecked(start1);
+            const double writeMsBefore = this->writeTimeMs.get();
+            const double startMs = Time::getMillisecondCounterHiRes();
+
+            // the writer may fail with a full disk, give it a couple of tries,
+            // and if it still fails, stop here: the rest of the file is useless
+            bool written = false;
+            for (int attempt = 0; attempt < 3 && !written; ++attempt)
+            {
+                written = this->writer.writeFromAudioSampleBuffer(*block, 0, block->getNumSamples());
+            }
+
+            if (!written)
+            {
+                this->failed = 1;
+                this->blockWritten.signal();
+                return;
+            }
+
+            // encoding is whatever the writer did apart from the disk writes
+            const double totalMs = Time::getMillisecondCounterHiRes() - startMs;
+            const double diskMs = this->writeTimeMs.get() - writeMsBefore;
+            this->encodeTimeMs = this->encodeTimeMs.get() + (totalMs - diskMs);
+
+            this->fifo.finishedRead(1);
+            this->blockWritten.signal();
+        }
+    }
+
+    AudioFormatWriter &writer;
+    Thread &producer;
+
+    AbstractFifo fifo;
+    OwnedArray<AudioSampleBuffer> blocks;
+    WaitableEvent blockWritten;
+    Atomic<int> failed;
+
+    Atomic<double> &encodeTimeMs;
+    Atomic<double> &writeTimeMs;
+
+    JUCE_DECLARE_NON_COPYABLE(RenderedBlocksWriter)
+};
+
 RendererThread::RendererThread(Transport &parentTrasport) :
     Thread("RendererThread"),
     transport(parentTrasport),
     writer(nullptr),
-    percentsDone(0.f) {}
+    renderFailed(0),
+    percentsDone(0.f),
+    processTimeMs(0.0),
+    mixTimeMs(0.0),
+    encodeTimeMs(0.0),
+    writeTimeMs(0.0) {}
 
 RendererThread::~RendererThread()
 {
@@ -39,7 +229,18 @@ float RendererThread::getPercentsComplete() const
     return this->percentsDone;
 }
 
-void RendererThread::startRecording(const File &file)
+Transport::RenderStageTimings RendererThread::getStageTimings() const
+{
+    return { this->processTimeMs.get(), this->mixTimeMs.get(),
+        this->encodeTimeMs.get(), this->writeTimeMs.get() };
+}
+
+bool RendererThread::hasFailed() const
+{
+    return this->renderFailed.get() != 0;
+}
+
+void RendererThread::startRecording(const File &file, const RenderSettings &renderSettings)
 {
     this->transport.recacheIfNeeded();
     const ProjectSequences sequencesCache = this->transport.getPlaybackCache();
@@ -51,9 +252,20 @@ void RendererThread::startRecording(const File &file)
 
     this->stop();
 
+    this->settings = renderSettings;
+    this->outputFile = file;
+    this->renderFailed = 0;
+
     double sampleRate = sequencesCache.getSampleRate();
     int numChannels = sequencesCache.getNumOutputChannels();
 
+    // the graphs were never prepared, e.g. there's no audio device
+    if (sampleRate <= 0.0)
+    {
+        this->renderFailed = 1;
+        return;
+    }
+
     // Create an OutputStream to write to our destination file...
     file.deleteFile();
     UniquePointer<FileOutputStream> fileStream(file.createOutputStream());
@@ -64,22 +276,29 @@ void RendererThread::startRecording(const File &file)
             const ScopedWriteLock pl(this->percentsLock);
             this->percentsDone = 0.f;
         }
+
+        this->processTimeMs = 0.0;
+        this->mixTimeMs = 0.0;
+        this->encodeTimeMs = 0.0;
+        this->writeTimeMs = 0.0;
+
+        UniquePointer<OutputStream> timedStream(new TimedOutputStream(fileStream.release(), this->writeTimeMs));
         
-        // 16 bits per sample should be enough for anybody :)
-        // ..wanna fight about it? https://people.xiph.org/~xiphmont/demo/neil-young.html
-        const int bitDepth = 16;
+        // wav writer treats 32 bits as floating point samples
+        const int bitDepth = this->settings.getBitDepth();
 
         if (file.getFileExtension().endsWithIgnoreCase("wav"))
         {
             WavAudioFormat wavFormat;
             const ScopedLock sl(this->writerLock);
-            this->writer.reset(wavFormat.createWriterFor(fileStream.release(), sampleRate, numChannels, bitDepth, {}, 0));
+            this->writer.reset(wavFormat.createWriterFor(timedStream.release(), sampleRate, numChannels, bitDepth, {}, 0));
         }
         else if (file.getFileExtension().endsWithIgnoreCase("flac"))
         {
             FlacAudioFormat flacFormat;
             const ScopedLock sl(this->writerLock);
-            this->writer.reset(flacFormat.createWriterFor(fileStream.release(), sampleRate, numChannels, bitDepth, {}, 0));
+            const int flacBitDepth = jmin(bitDepth, 24); // no float samples in flac
+            this->writer.reset(flacFormat.createWriterFor(timedStream.release(), sampleRate, numChannels, flacBitDepth, {}, 0));
         }
 
         if (writer != nullptr)
@@ -97,6 +316,10 @@ void RendererThread::stop()
         this->stopThread(500);
     }
 
+    // the render thread is gone by now, but the encoder thread
+    // may still be writing the last blocks, so wait for it first
+    this->blocksWriter = nullptr;
+
     {
         const ScopedLock sl(this->writerLock);
         this->writer = nullptr;
@@ -117,7 +340,46 @@ struct RenderBuffer final
 {
     Instrument *instrument;
     AudioSampleBuffer sampleBuffer;
+    AudioBuffer<double> doubleSampleBuffer;
     MidiBuffer midiBuffer;
+    bool usesDoublePrecision;
+
+    void processBlock()
+    {
+        AudioProcessorGraph *graph = this->instrument->getProcessorGraph();
+        const ScopedLock lock(graph->getCallbackLock());
+        if (this->usesDoublePrecision)
+        {
+            graph->processBlock(this->doubleSampleBuffer, this->midiBuffer);
+        }
+        else
+        {
+            graph->processBlock(this->sampleBuffer, this->midiBuffer);
+        }
+
+        this->midiBuffer.clear();
+    }
+};
+
+class RenderBufferJob final : public ThreadPoolJob
+{
+public:
+
+    explicit RenderBufferJob(RenderBuffer &buffer) :
+        ThreadPoolJob("RenderBufferJob"),
+        buffer(buffer) {}
+
+    JobStatus runJob() override
+    {
+        this->buffer.processBlock();
+        return jobHasFinished;
+    }
+
+private:
+
+    RenderBuffer &buffer;
+
+    JUCE_DECLARE_NON_COPYABLE(RenderBufferJob)
 };
 
 void RendererThread::run()
@@ -125,21 +387,16 @@ void RendererThread::run()
     // step 0. init.
     this->transport.recacheIfNeeded();
     ProjectSequences sequences = this->transport.getPlaybackCache();
-    const int bufferSize = 512;
+    const int bufferSize = this->settings.getBlockSize();
 
     // assuming that number of channels and sample rate is equal for all instruments
     const int numOutChannels = sequences.getNumOutputChannels();
     const int numInChannels = sequences.getNumInputChannels();
     const double sampleRate = sequences.getSampleRate();
     
-    double totalTimeMs = 0.0;
-    double tempoAtTheEndOfTrack = 0.0;
-    this->transport.calcTimeAndTempoAt(1.0, totalTimeMs, tempoAtTheEndOfTrack);
-    
-    double startTimeMs = 0.0;
-    double msPerQuarter = 0.0;
-    this->transport.calcTimeAndTempoAt(0.0, startTimeMs, msPerQuarter);
-    double secPerQuarter = msPerQuarter / 1000.0;
+    const auto tempoMap = this->transport.getTempoMap();
+    const double totalTimeMs = tempoMap->getTimeAt(this->transport.getTotalTime());
+    double secPerQuarter = tempoMap->getTempoAt(0.0) / 1000.0;
 
     double currentFrame = 0.0;
     const double lastFrame = totalTimeMs / 1000.0 * sampleRate;
@@ -148,40 +405,84 @@ void RendererThread::run()
     OwnedArray<RenderBuffer> subBuffers;
     Array<Instrument *> uniqueInstruments(sequences.getUniqueInstruments());
 
+    // double precision is only used if all the graphs support it,
+    // so that all instruments are mixed down the same way
+    bool usesDoublePrecision = this->settings.shouldUseDoublePrecision();
+
     for (int i = 0; i < uniqueInstruments.size(); ++i)
     {
         Instrument *instrument = uniqueInstruments[i];
+        usesDoublePrecision = usesDoublePrecision &&
+            instrument->getProcessorGraph()->supportsDoublePrecisionProcessing();
+
         auto subBuffer = new RenderBuffer();
         subBuffer->instrument = instrument;
-        subBuffer->sampleBuffer = AudioSampleBuffer(numOutChannels, bufferSize);
         subBuffers.add(subBuffer);
         //DBG("Adding instrument: " + String(instrument->getName()));
     }
 
+    for (auto *subBuffer : subBuffers)
+    {
+        subBuffer->usesDoublePrecision = usesDoublePrecision;
+        if (usesDoublePrecision)
+        {
+            subBuffer->doubleSampleBuffer = AudioBuffer<double>(numOutChannels, bufferSize);
+        }
+        else
+        {
+            subBuffer->sampleBuffer = AudioSampleBuffer(numOutChannels, bufferSize);
+        }
+    }
+
     // step 2. release resources, prepare to play, etc.
     for (auto *subBuffer : subBuffers)
     {
         AudioProcessorGraph *graph = subBuffer->instrument->getProcessorGraph();
         graph->setPlayConfigDetails(numInChannels, numOutChannels, sampleRate, bufferSize);
         graph->releaseResources();
-        // TODO:
-        //graph->setProcessingPrecision(AudioProcessor::singlePrecision);
+        graph->setProcessingPrecision(usesDoublePrecision ?
+            AudioProcessor::doublePrecision : AudioProcessor::singlePrecision);
         graph->prepareToPlay(graph->getSampleRate(), bufferSize);
         graph->setNonRealtime(true);
     }
 
+    // step 2a. instruments don't depend on each other, so their blocks can be processed
+    // in parallel; the mixdown is still done serially and in the same order as before,
+    // so the result is exactly the same as with the single-threaded rendering
+    OwnedArray<RenderBufferJob> jobs;
+    UniquePointer<ThreadPool> workers;
+    const int numWorkers = jmin(subBuffers.size(), SystemStats::getNumCpus());
+    if (numWorkers > 1 && this->settings.shouldProcessInParallel())
+    {
+        workers.reset(new ThreadPool(numWorkers));
+        for (auto *subBuffer : subBuffers)
+        {
+            jobs.add(new RenderBufferJob(*subBuffer));
+        }
+    }
+
+    // step 2b. start the encoder thread.
+    {
+        const ScopedLock sl(this->writerLock);
+        this->blocksWriter.reset(new RenderedBlocksWriter(*this->writer, *this,
+            numOutChannels, bufferSize, this->encodeTimeMs, this->writeTimeMs));
+    }
+
+    this->blocksWriter->startThread(8);
+
     // let processor graphs call handle their async updates
     Thread::sleep(200);
 
     // step 3. render loop itself.
+
     sequences.seekToTime(0.0);
     
     CachedMidiMessage nextMessage;
     bool hasNextMessage = sequences.getNextMessage(nextMessage);
     jassert(hasNextMessage);
     
-    // TODO: add double precision rendering someday (for processor graphs who support it)
     AudioSampleBuffer mixingBuffer(numOutChannels, bufferSize);
+    AudioBuffer<double> doubleMixingBuffer(usesDoublePrecision ? numOutChannels : 0, bufferSize);
     
     double lastEventTick = 0.0;
     double prevEventTimeStamp = 0.0;
@@ -241,46 +542,75 @@ void RendererThread::run()
         }
 
         // step 3b. call processBlock for every instrument.
-        for (auto subBuffer : subBuffers)
+        double stageStartMs = Time::getMillisecondCounterHiRes();
+
+        if (workers != nullptr)
         {
-            AudioProcessorGraph *graph = subBuffer->instrument->getProcessorGraph();
+            for (auto *job : jobs)
             {
-                const ScopedLock lock(graph->getCallbackLock());
-                
-                //DBG("processBlock num midi events: " + String(subBuffer->midiBuffer.getNumEvents()));
-                graph->processBlock(subBuffer->sampleBuffer, subBuffer->midiBuffer);
-                subBuffer->midiBuffer.clear();
+                workers->addJob(job, false);
+            }
 
-                //Thread::yield();
+            for (auto *job : jobs)
+            {
+                workers->waitForJobToFinish(job, -1);
+            }
+        }
+        else
+        {
+            for (auto *subBuffer : subBuffers)
+            {
+                subBuffer->processBlock();
             }
         }
 
-        // step 3c. mix them down to the render buffer.
-        mixingBuffer.clear();
+        double stageEndMs = Time::getMillisecondCounterHiRes();
+        this->processTimeMs = this->processTimeMs.get() + (stageEndMs - stageStartMs);
+        stageStartMs = stageEndMs;
 
-        for (auto subBuffer : subBuffers)
+        // step 3c. mix them down to the render buffer.
+        if (usesDoublePrecision)
         {
-            for (int j = 0; j < numOutChannels; ++j)
+            doubleMixingBuffer.clear();
+
+            for (auto subBuffer : subBuffers)
             {
-                mixingBuffer.addFrom(j, 0,
-                    subBuffer->sampleBuffer, j, 0,
-                    bufferSize,
-                    1.0f);
+                for (int j = 0; j < numOutChannels; ++j)
+                {
+                    doubleMixingBuffer.addFrom(j, 0,
+                        subBuffer->doubleSampleBuffer, j, 0,
+                        bufferSize,
+                        1.0);
+                }
             }
-        }
 
-        // step 3d. write resulting buffer to disk.
+            mixingBuffer.makeCopyOf(doubleMixingBuffer, true);
+        }
+        else
         {
-            const ScopedLock sl(this->writerLock);
-            bool writedSuccessfullty = false;
-            
-            while (! writedSuccessfullty)
+            mixingBuffer.clear();
+
+            for (auto subBuffer : subBuffers)
             {
-                writedSuccessfullty =
-                this->writer->writeFromAudioSampleBuffer(mixingBuffer, 0, mixingBuffer.getNumSamples());
+                for (int j = 0; j < numOutChannels; ++j)
+                {
+                    mixingBuffer.addFrom(j, 0,
+                        subBuffer->sampleBuffer, j, 0,
+                        bufferSize,
+                        1.0f);
+                }
             }
         }
 
+        stageEndMs = Time::getMillisecondCounterHiRes();
+        this->mixTimeMs = this->mixTimeMs.get() + (stageEndMs - stageStartMs);
+
+        // step 3d. pass resulting buffer to the encoder thread.
+        if (!this->blocksWriter->pushBlock(mixingBuffer, bufferSize))
+        {
+            break;
+        }
+
         // step 3e. finally, update counters.
         currentFrame += bufferSize;
 
@@ -291,11 +621,20 @@ void RendererThread::run()
         }
     }
 
+    workers = nullptr;
+    this->blocksWriter->flushAndStop();
+    const bool writerFailed = this->blocksWriter->hasFailed();
+    this->blocksWriter = nullptr;
+
     // step 4. setNonRealtime false.
     for (auto subBuffer : subBuffers)
     {
         AudioProcessorGraph *graph = subBuffer->instrument->getProcessorGraph();
         graph->setNonRealtime(false);
+        if (usesDoublePrecision)
+        {
+            graph->setProcessingPrecision(AudioProcessor::singlePrecision);
+        }
     }
     
     {
@@ -303,5 +642,13 @@ void RendererThread::run()
         this->writer = nullptr;
     }
 
+    // a partially written file is no use to anybody
+    if (writerFailed)
+    {
+        DBG("Failed to write " + this->outputFile.getFullPathName());
+        this->outputFile.deleteFile();
+        this->renderFailed = 1;
+    }
+
     App::Workspace().getAudioCore().setAwake();
 }
@@ -18,6 +18,9 @@
 #pragma once
 
 #include "Transport.h"
+#include "RenderSettings.h"
+
+class RenderedBlocksWriter;
 
 class RendererThread final : private Thread
 {
@@ -28,7 +31,12 @@ public:
     
     float getPercentsComplete() const;
 
-    void startRecording(const File &file);
+    Transport::RenderStageTimings getStageTimings() const;
+
+    // True if the last render was aborted because the output could not be written
+    bool hasFailed() const;
+
+    void startRecording(const File &file, const RenderSettings &settings);
     void stop();
     bool isRecording() const;
 
@@ -46,9 +54,20 @@ private:
 
     CriticalSection writerLock;
     UniquePointer<AudioFormatWriter> writer;
+    UniquePointer<RenderedBlocksWriter> blocksWriter;
+
+    File outputFile;
+    Atomic<int> renderFailed;
+
+    RenderSettings settings;
 
     ReadWriteLock percentsLock;
     float percentsDone;
+
+    Atomic<double> processTimeMs;
+    Atomic<double> mixTimeMs;
+    Atomic<double> encodeTimeMs;
+    Atomic<double> writeTimeMs;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RendererThread)
 };
@@ -0,0 +1,159 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ProjectSequencesWrapper.h"
+
+// Default 120 BPM == 500 ms per quarter note
+#define DEFAULT_MS_PER_QUARTER 500.0
+
+/*
+    An immutable index of all tempo changes in the playback cache,
+    built once per recache and shared by the transport, player and renderer.
+
+    Positions here are the playback cache timestamps, i.e. beats relative
+    to the project's first beat. Each segment knows the time in milliseconds
+    at which it starts, so that all lookups are binary searches.
+*/
+
+class TempoMap final : public ReferenceCountedObject
+{
+public:
+
+    using Ptr = ReferenceCountedObjectPtr<TempoMap>;
+
+    TempoMap()
+    {
+        this->segments.add({ 0.0, 0.0, DEFAULT_MS_PER_QUARTER });
+    }
+
+    static Ptr createFrom(const ProjectSequences &playbackCache)
+    {
+        TempoMap::Ptr map(new TempoMap());
+
+        ProjectSequences sequences(playbackCache);
+        sequences.seekToZeroIndexes();
+
+        bool foundFirstTempoEvent = false;
+        CachedMidiMessage cached;
+
+        while (sequences.getNextMessage(cached))
+        {
+            if (!cached.message.isTempoMetaEvent())
+            {
+                continue;
+            }
+
+            const double beat = cached.message.getTimeStamp();
+            const double msPerQuarter = cached.message.getTempoSecondsPerQuarterNote() * 1000.0;
+            auto &last = map->segments.getReference(map->segments.size() - 1);
+
+            // the first tempo event sets the tempo all the way before it,
+            // and the later of the simultaneous tempo events wins
+            if (!foundFirstTempoEvent || beat <= last.startBeat)
+            {
+                last.msPerQuarter = msPerQuarter;
+                foundFirstTempoEvent = true;
+                continue;
+            }
+
+            const double startMs = last.startMs + last.msPerQuarter * (beat - last.startBeat);
+            map->segments.add({ beat, startMs, msPerQuarter });
+        }
+
+        return map;
+    }
+
+    inline double getTimeAt(double beat) const noexcept
+    {
+        const auto &segment = this->segments.getReference(this->findSegmentByBeat(beat));
+        return segment.startMs + segment.msPerQuarter * (beat - segment.startBeat);
+    }
+
+    inline double getTempoAt(double beat) const noexcept
+    {
+        return this->segments.getReference(this->findSegmentByBeat(beat)).msPerQuarter;
+    }
+
+    inline double getBeatAt(double timeMs) const noexcept
+    {
+        const auto &segment = this->segments.getReference(this->findSegmentByTime(timeMs));
+        return segment.startBeat + (timeMs - segment.startMs) / segment.msPerQuarter;
+    }
+
+    inline int getNumTempoSegments() const noexcept
+    {
+        return this->segments.size();
+    }
+
+private:
+
+    struct TempoSegment final
+    {
+        double startBeat;
+        double startMs;
+        double msPerQuarter;
+    };
+
+    // sorted both by startBeat and by startMs, never empty
+    Array<TempoSegment> segments;
+
+    // returns the last segment starting at or before the given beat,
+    // or the first one, if the beat precedes it
+    int findSegmentByBeat(double beat) const noexcept
+    {
+        int low = 1;
+        int high = this->segments.size();
+        while (low < high)
+        {
+            const int mid = (low + high) / 2;
+            if (this->segments.getReference(mid).startBeat <= beat)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+
+        return low - 1;
+    }
+
+    int findSegmentByTime(double timeMs) const noexcept
+    {
+        int low = 1;
+        int high = this->segments.size();
+        while (low < high)
+        {
+            const int mid = (low + high) / 2;
+            if (this->segments.getReference(mid).startMs <= timeMs)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+
+        return low - 1;
+    }
+
+    JUCE_LEAK_DETECTOR(TempoMap)
+};
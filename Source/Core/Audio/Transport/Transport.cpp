@@ -20,6 +20,7 @@
 #include "OrchestraPit.h"
 #include "PlayerThread.h"
 #include "RendererThread.h"
+#include "RenderSettings.h"
 #include "MidiSequence.h"
 #include "MidiEvent.h"
 #include "MidiTrack.h"
@@ -29,7 +30,6 @@
 #include "AudioCore.h"
 #include "HybridRoll.h"
 #include "SerializationKeys.h"
-#include "PlayerThreadPool.h"
 
 #define TIME_NOW (Time::getMillisecondCounterHiRes() * 0.001)
 #define SOUND_SLEEP_DELAY_MS (10000)
@@ -41,11 +41,15 @@ Transport::Transport(OrchestraPit &orchestraPit, SleepTimer &sleepTimer) :
     trackStartMs(0.0),
     trackEndMs(0.0),
     sequencesAreOutdated(true),
+    tempoMapIsOutdated(true),
+    cachedWithSoloClips(false),
+    cachedWithOffset(0.0),
     totalTime(500.0 * 8.0),
     projectFirstBeat(0.f),
     projectLastBeat(DEFAULT_NUM_BARS * BEATS_PER_BAR)
 {
-    this->player.reset(new PlayerThreadPool(*this));
+    this->tempoMap = new TempoMap();
+    this->player.reset(new PlayerThread(*this));
     this->renderer.reset(new RendererThread(*this));
     this->orchestra.addOrchestraListener(this);
 }
@@ -148,9 +152,15 @@ void Transport::probeSoundAt(double absTrackPosition, const MidiSequence *limitT
     
     for (const auto &seq : sequencesToProbe)
     {
-        for (int j = 0; j < seq->midiMessages.getNumEvents(); ++j)
+        // only the notes starting no earlier than the longest note before the target can sound there
+        const int firstIndex = seq->getNextIndexAtTime(targetFlatTime - seq->maxNoteLength);
+        for (int j = firstIndex; j < seq->midiMessages.getNumEvents(); ++j)
         {
             auto *noteOnHolder = seq->midiMessages.getEventPointer(j);
+            if (noteOnHolder->message.getTimeStamp() > targetFlatTime)
+            {
+                break;
+            }
             
             if (auto *noteOffHolder = noteOnHolder->noteOffObject)
             {
@@ -183,6 +193,7 @@ void Transport::probeSequence(const MidiMessageSequence &sequence)
     auto cached = CachedMidiSequence::createFrom(instrument);
     cached->midiMessages = MidiMessageSequence(sequence);
     cached->midiMessages.addTimeToMessages(startPositionInTime);
+    cached->updateSeekIndex();
 
     this->playbackCache.addWrapper(cached);
 
@@ -247,7 +258,12 @@ bool Transport::isPlaying() const
     return this->player->isPlaying();
 }
 
-void Transport::startRender(const String &fileName)
+double Transport::getPlaybackStartLatencyMs() const
+{
+    return this->player->getLastStartLatencyMs();
+}
+
+void Transport::startRender(const String &fileName, const RenderSettings &settings)
 {
     if (this->renderer->isRecording())
     {
@@ -257,7 +273,7 @@ void Transport::startRender(const String &fileName)
     this->sleepTimer.setCanSleepAfter(0);
 
     File file(File::getCurrentWorkingDirectory().getChildFile(fileName));
-    this->renderer->startRecording(file);
+    this->renderer->startRecording(file, settings);
 }
 
 void Transport::stopRender()
@@ -277,11 +293,21 @@ bool Transport::isRendering() const
     return this->renderer->isRecording();
 }
 
+bool Transport::hasRenderFailed() const
+{
+    return this->renderer->hasFailed();
+}
+
 float Transport::getRenderingPercentsComplete() const
 {
     return this->renderer->getPercentsComplete();
 }
 
+Transport::RenderStageTimings Transport::getRenderingStageTimings() const
+{
+    return this->renderer->getStageTimings();
+}
+
 //===----------------------------------------------------------------------===//
 // Sending messages at real-time
 //===----------------------------------------------------------------------===//
@@ -455,8 +481,8 @@ void Transport::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &ne
     // todo stop playback only if the event is in future
     // and getTrackControllerNumber == 0 (not an automation)
     this->stopPlayback();
+    this->setTrackOutdated(newEvent.getSequence()->getTrackId());
     updateLengthAndTimeIfNeeded((&newEvent));
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onAddMidiEvent(const MidiEvent &event)
@@ -464,38 +490,38 @@ void Transport::onAddMidiEvent(const MidiEvent &event)
     // todo stop playback only if the event is in future
     // and getTrackControllerNumber == 0 (not an automation)
     this->stopPlayback();
+    this->setTrackOutdated(event.getSequence()->getTrackId());
     updateLengthAndTimeIfNeeded((&event));
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onRemoveMidiEvent(const MidiEvent &event) {}
 void Transport::onPostRemoveMidiEvent(MidiSequence *const sequence)
 {
     this->stopPlayback();
+    this->setTrackOutdated(sequence->getTrackId());
     updateLengthAndTimeIfNeeded(sequence->getTrack());
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onAddClip(const Clip &clip)
 {
     this->stopPlayback();
+    this->setTrackOutdated(clip.getTrackId());
     updateLengthAndTimeIfNeeded((&clip));
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onChangeClip(const Clip &oldClip, const Clip &newClip)
 {
     this->stopPlayback();
+    this->setTrackOutdated(newClip.getTrackId());
     updateLengthAndTimeIfNeeded((&newClip));
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onRemoveClip(const Clip &clip) {}
 void Transport::onPostRemoveClip(Pattern *const pattern)
 {
     this->stopPlayback();
+    this->setTrackOutdated(pattern->getTrackId());
     updateLengthAndTimeIfNeeded(pattern->getTrack());
-    this->sequencesAreOutdated = true;
 }
 
 void Transport::onChangeTrackProperties(MidiTrack *const track)
@@ -506,7 +532,7 @@ void Transport::onChangeTrackProperties(MidiTrack *const track)
         this->linksCache[trackId]->getInstrumentId() != track->getTrackInstrumentId())
     {
         this->stopPlayback();
-        this->sequencesAreOutdated = true;
+        this->setTrackOutdated(trackId);
         this->updateLinkForTrack(track);
     }
 }
@@ -531,7 +557,7 @@ void Transport::onAddTrack(MidiTrack *const track)
 {
     this->stopPlayback();
     
-    this->sequencesAreOutdated = true;
+    this->setTrackOutdated(track->getTrackId());
     this->tracksCache.addIfNotAlreadyThere(track);
     this->updateLinkForTrack(track);
 }
@@ -540,7 +566,13 @@ void Transport::onRemoveTrack(MidiTrack *const track)
 {
     this->stopPlayback();
     
-    this->sequencesAreOutdated = true;
+    this->setTrackOutdated(track->getTrackId());
+    this->trackSequencesCache.erase(track->getTrackId());
+    if (track->getTrackControllerNumber() == MidiTrack::tempoController)
+    {
+        this->tempoMapIsOutdated = true;
+    }
+
     this->tracksCache.removeAllInstancesOf(track);
     this->removeLinkForTrack(track);
 }
@@ -588,49 +620,33 @@ void Transport::calcTimeAndTempoAt(const double targetAbsPosition,
                                    double &outTimeMs, double &outTempo)
 {
     this->recacheIfNeeded();
-    this->playbackCache.seekToZeroIndexes();
-    
+    const auto tempoMap = this->getTempoMap();
     const double targetTime = targetAbsPosition * this->getTotalTime();
-    
-    outTimeMs = 0.0;
-    outTempo = 500.0; // default 120 BPM
-    
-    double prevTimestamp = 0.0;
-    double nextEventTimeDelta = 0.0;
-    bool foundFirstTempoEvent = false;
-    
-    CachedMidiMessage cached;
-    
-    while (this->playbackCache.getNextMessage(cached))
+    outTimeMs = tempoMap->getTimeAt(targetTime);
+    outTempo = tempoMap->getTempoAt(targetTime);
+}
+
+double Transport::calcPositionAtTime(const double timeMs)
+{
+    this->recacheIfNeeded();
+    const double totalTime = this->getTotalTime();
+    if (totalTime == 0.0)
     {
-        const double nextAbsPosition = cached.message.getTimeStamp() / this->getTotalTime();
-        
-        // first tempo event sets the tempo all the way before it
-        if (nextAbsPosition > targetAbsPosition && foundFirstTempoEvent) { break; }
-        
-        nextEventTimeDelta = outTempo * (cached.message.getTimeStamp() - prevTimestamp);
-        outTimeMs += nextEventTimeDelta;
-        prevTimestamp = cached.message.getTimeStamp();
-        
-        if (cached.message.isTempoMetaEvent())
-        {
-            outTempo = cached.message.getTempoSecondsPerQuarterNote() * 1000.f;
-            foundFirstTempoEvent = true;
-        }
+        return 0.0;
     }
-    
-    nextEventTimeDelta = outTempo * (targetTime - prevTimestamp);
-    outTimeMs += nextEventTimeDelta;
+
+    return this->getTempoMap()->getBeatAt(timeMs) / totalTime;
 }
 
 MidiMessage Transport::findFirstTempoEvent()
 {
     this->recacheIfNeeded();
-    this->playbackCache.seekToZeroIndexes();
+    auto sequences(this->getPlaybackCache());
+    sequences.seekToZeroIndexes();
     
     CachedMidiMessage wrapper;
     
-    while (this->playbackCache.getNextMessage(wrapper))
+    while (sequences.getNextMessage(wrapper))
     {
         if (wrapper.message.isTempoMetaEvent())
         {
@@ -642,33 +658,63 @@ MidiMessage Transport::findFirstTempoEvent()
     return MidiMessage::tempoMetaEvent(500 * 1000);
 }
 
+Array<Instrument *> Transport::getPlaybackInstruments()
+{
+    this->recacheIfNeeded();
+    return this->getPlaybackCache().getUniqueInstruments();
+}
+
 //===----------------------------------------------------------------------===//
 // Playback cache management
 //===----------------------------------------------------------------------===//
 
+void Transport::setTrackOutdated(const String &trackId)
+{
+    this->outdatedTracks.insert(trackId);
+}
+
 void Transport::recacheIfNeeded()
 {
-    if (this->sequencesAreOutdated)
+    if (!this->sequencesAreOutdated && this->outdatedTracks.empty())
     {
-        this->playbackCache.clear();
-        static Clip noTransform;
-        const double offset = -this->trackStartMs.get();
+        return;
+    }
+
+    static Clip noTransform;
+    const double offset = -this->trackStartMs.get();
 
-        // Find solo clips, if any
-        bool hasSoloClips = false;
-        for (const auto *track : this->tracksCache)
+    // Find solo clips, if any
+    bool hasSoloClips = false;
+    for (const auto *track : this->tracksCache)
+    {
+        if (track->getPattern() != nullptr &&
+            track->getPattern()->hasSoloClips())
         {
-            if (track->getPattern() != nullptr &&
-                track->getPattern()->hasSoloClips())
-            {
-                hasSoloClips = true;
-                break;
-            }
+            hasSoloClips = true;
+            break;
         }
+    }
+
+    // Both solo mode and the offset affect every track's export
+    if (this->sequencesAreOutdated ||
+        hasSoloClips != this->cachedWithSoloClips ||
+        offset != this->cachedWithOffset)
+    {
+        this->trackSequencesCache.clear();
+        this->cachedWithSoloClips = hasSoloClips;
+        this->cachedWithOffset = offset;
+        this->tempoMapIsOutdated = true;
+    }
 
-        for (const auto *track : this->tracksCache)
+    this->playbackCache.clear();
+
+    for (const auto *track : this->tracksCache)
+    {
+        const auto &trackId = track->getTrackId();
+        if (!this->trackSequencesCache.contains(trackId) ||
+            this->outdatedTracks.contains(trackId))
         {
-            const auto instrument = this->linksCache[track->getTrackId()];
+            const auto instrument = this->linksCache[trackId];
             auto cached = CachedMidiSequence::createFrom(instrument, track->getSequence());
 
             if (track->getPattern() != nullptr)
@@ -683,11 +729,28 @@ void Transport::recacheIfNeeded()
                 cached->track->exportMidi(cached->midiMessages, noTransform, hasSoloClips, offset, 1.0);
             }
 
-            this->playbackCache.addWrapper(cached);
+            cached->updateSeekIndex();
+            this->trackSequencesCache[trackId] = cached;
+
+            if (track->getTrackControllerNumber() == MidiTrack::tempoController)
+            {
+                this->tempoMapIsOutdated = true;
+            }
         }
-        
-        this->sequencesAreOutdated = false;
+
+        this->playbackCache.addWrapper(this->trackSequencesCache[trackId]);
     }
+
+    if (this->tempoMapIsOutdated)
+    {
+        TempoMap::Ptr newTempoMap(TempoMap::createFrom(this->playbackCache));
+        const SpinLock::ScopedLockType l(this->sequencesLock);
+        this->tempoMap = newTempoMap;
+    }
+
+    this->outdatedTracks.clear();
+    this->tempoMapIsOutdated = false;
+    this->sequencesAreOutdated = false;
 }
 
 ProjectSequences Transport::getPlaybackCache()
@@ -696,6 +759,12 @@ ProjectSequences Transport::getPlaybackCache()
     return this->playbackCache;
 }
 
+TempoMap::Ptr Transport::getTempoMap()
+{
+    const SpinLock::ScopedLockType l(this->sequencesLock);
+    return this->tempoMap;
+}
+
 void Transport::updateLinkForTrack(const MidiTrack *track)
 {
     const Array<Instrument *> instruments = this->orchestra.getInstruments();
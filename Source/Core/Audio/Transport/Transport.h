@@ -20,11 +20,12 @@
 class SleepTimer;
 class OrchestraPit;
 class PlayerThread;
-class PlayerThreadPool;
 class RendererThread;
+class RenderSettings;
 
 #include "TransportListener.h"
 #include "ProjectSequencesWrapper.h"
+#include "TempoMap.h"
 #include "ProjectListener.h"
 #include "OrchestraListener.h"
 #include "Instrument.h"
@@ -64,17 +65,41 @@ public:
     void stopPlayback();
     void toggleStatStopPlayback();
 
-    void startRender(const String &filename);
+    // How long it took the last playback start to be heard, in milliseconds,
+    // from the start request to the first played position, including the look-ahead
+    double getPlaybackStartLatencyMs() const;
+
+    void startRender(const String &filename, const RenderSettings &settings);
     bool isRendering() const;
+    bool hasRenderFailed() const;
     void stopRender();
     
     float getRenderingPercentsComplete() const;
+
+    // Cumulative time spent in each render stage, in milliseconds;
+    // encoding and writing are done by a separate thread,
+    // so that instruments processing doesn't wait for the disk
+    struct RenderStageTimings final
+    {
+        double processMs;
+        double mixMs;
+        double encodeMs;
+        double writeMs;
+    };
+
+    RenderStageTimings getRenderingStageTimings() const;
     
     void calcTimeAndTempoAt(const double absPosition,
         double &outTimeMs, double &outTempo);
 
+    double calcPositionAtTime(const double timeMs);
+
     MidiMessage findFirstTempoEvent();
 
+    // Instruments which are actually used in playback,
+    // e.g. to see if two projects can be rendered at the same time
+    Array<Instrument *> getPlaybackInstruments();
+
     //===------------------------------------------------------------------===//
     // Sending messages in real-time
     //===------------------------------------------------------------------===//
@@ -147,7 +172,7 @@ private:
     OrchestraPit &orchestra;
     SleepTimer &sleepTimer;
 
-    UniquePointer<PlayerThreadPool> player;
+    UniquePointer<PlayerThread> player;
     UniquePointer<RendererThread> renderer;
 
     friend class RendererThread;
@@ -156,11 +181,26 @@ private:
 private:
 
     ProjectSequences getPlaybackCache();
+    TempoMap::Ptr getTempoMap();
     void recacheIfNeeded();
     
     SpinLock sequencesLock;
     ProjectSequences playbackCache;
+    TempoMap::Ptr tempoMap;
+
+    // sequencesAreOutdated means that all tracks should be re-exported,
+    // otherwise only the tracks listed in outdatedTracks are updated
     bool sequencesAreOutdated;
+    bool tempoMapIsOutdated;
+    FlatHashSet<String, StringHash> outdatedTracks;
+
+    // cached sequences are <track id : sequence>, they are never modified
+    // once created, since the playback threads might still use them
+    FlatHashMap<String, CachedMidiSequence::Ptr, StringHash> trackSequencesCache;
+    bool cachedWithSoloClips;
+    double cachedWithOffset;
+
+    void setTrackOutdated(const String &trackId);
     
     // linksCache is <track id : instrument>
     mutable Array<const MidiTrack *> tracksCache;
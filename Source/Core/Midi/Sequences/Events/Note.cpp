@@ -37,6 +37,17 @@ Note::Note(WeakReference<MidiSequence> owner, const Note &parametersToCopy) noex
     velocity(parametersToCopy.velocity),
     tuplet(parametersToCopy.tuplet) {}
 
+Note::Note(const Id &idVal, float beatVal, Key keyVal,
+    float lengthVal, float velocityVal, Tuplet tupletVal) noexcept :
+    MidiEvent(nullptr, Type::Note, beatVal),
+    key(keyVal),
+    length(lengthVal),
+    velocity(velocityVal),
+    tuplet(tupletVal)
+{
+    this->id = idVal;
+}
+
 void Note::exportMessages(MidiMessageSequence &outSequence, const Clip &clip,
     double timeOffset, double timeFactor) const noexcept
 {
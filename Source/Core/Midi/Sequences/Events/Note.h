@@ -41,6 +41,10 @@ public:
          int keyVal = MIDDLE_C, float beatVal = 0.f,
          float lengthVal = 1.f, float velocityVal = 1.f) noexcept;
 
+    // Doesn't create new id, only used to restore the notes stored in undo history
+    Note(const Id &idVal, float beatVal, Key keyVal,
+        float lengthVal, float velocityVal, Tuplet tupletVal) noexcept;
+
     void exportMessages(MidiMessageSequence &outSequence, const Clip &clip,
         double timeOffset, double timeFactor) const noexcept override;
     
@@ -41,5 +41,5 @@ void Autosaver::changeListenerCallback(ChangeBroadcaster *source)
 void Autosaver::timerCallback()
 {
     this->stopTimer();
-    this->documentOwner.getDocument()->save();
+    this->documentOwner.getDocument()->saveInBackground();
 }
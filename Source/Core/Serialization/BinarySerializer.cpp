@@ -17,20 +17,300 @@
 
 #include "Common.h"
 #include "BinarySerializer.h"
+#include "SerializationKeys.h"
 
 static const char *kHelioHeaderV2String = "Helio2::";
 static const uint64 kHelioHeaderV2 = ByteOrder::littleEndianInt64(kHelioHeaderV2String);
 
+static const char *kHelioHeaderV3String = "Helio3::";
+static const uint64 kHelioHeaderV3 = ByteOrder::littleEndianInt64(kHelioHeaderV3String);
+
+//===----------------------------------------------------------------------===//
+// Helio3 format
+//===----------------------------------------------------------------------===//
+
+/*
+    V2 format is just a header followed by one monolithic ValueTree stream;
+    V3 splits the tree into independently compressed chunks: the root node,
+    each of its direct children (project info, timeline, undo stack, etc.),
+    and each tree node (i.e. each track, track group and version control),
+    so that any chunk could be read without decoding the others.
+
+    The layout is:
+        int64 header
+        int32 number of chunks
+        table of contents: int64 offset, int32 compressed size, int32 raw size
+        compressed chunks, the first one is the root
+
+    In a chunk's tree, each child that goes to the separate chunk
+    is replaced by a placeholder node with that chunk's index.
+*/
+
+static const Identifier kChunkRef = "chunkRef";
+static const Identifier kChunkIndex = "index";
+
+struct ChunkInfo final
+{
+    int64 offset;
+    int compressedSize;
+    int rawSize;
+};
+
+static const int64 kChunkInfoSize = sizeof(int64) + sizeof(int) * 2;
+
+static inline bool isSeparateChunk(const ValueTree &node, bool isParentRoot)
+{
+    return isParentRoot || node.hasType(Serialization::Core::treeNode);
+}
+
+static void writeChunks(const ValueTree &node, bool isRoot, Array<MemoryBlock> &outRawChunks)
+{
+    const int chunkIndex = outRawChunks.size();
+    outRawChunks.add(MemoryBlock());
+
+    // this mirrors ValueTree::writeToStream, except that the children
+    // which go to the separate chunks are replaced with placeholders;
+    // the rest of the children are written as they are, without copying
+    MemoryOutputStream out;
+    out.writeString(node.getType().toString());
+    out.writeCompressedInt(node.getNumProperties());
+    for (int i = 0; i < node.getNumProperties(); ++i)
+    {
+        const auto propertyName = node.getPropertyName(i);
+        out.writeString(propertyName.toString());
+        node.getProperty(propertyName).writeToStream(out);
+    }
+
+    out.writeCompressedInt(node.getNumChildren());
+    for (const auto &child : node)
+    {
+        if (isSeparateChunk(child, isRoot))
+        {
+            ValueTree chunkRef(kChunkRef);
+            chunkRef.setProperty(kChunkIndex, outRawChunks.size(), nullptr);
+            chunkRef.writeToStream(out);
+            writeChunks(child, false, outRawChunks);
+        }
+        else
+        {
+            child.writeToStream(out);
+        }
+    }
+
+    outRawChunks.getReference(chunkIndex) = out.getMemoryBlock();
+}
+
+static ValueTree readChunk(int chunkIndex, const MemoryBlock &file, const Array<ChunkInfo> &chunks)
+{
+    const auto &chunk = chunks.getReference(chunkIndex);
+    if (chunk.offset < 0 || chunk.compressedSize < 0 || chunk.rawSize < 0 ||
+        chunk.offset + chunk.compressedSize > int64(file.getSize()))
+    {
+        jassertfalse;
+        return {};
+    }
+
+    MemoryInputStream compressedStream(static_cast<const char *>(file.getData()) + chunk.offset,
+        size_t(chunk.compressedSize), false);
+
+    GZIPDecompressorInputStream decompressedStream(compressedStream);
+    MemoryBlock rawData(size_t(chunk.rawSize));
+    if (decompressedStream.read(rawData.getData(), chunk.rawSize) != chunk.rawSize)
+    {
+        jassertfalse;
+        return {};
+    }
+
+    auto tree = ValueTree::readFromData(rawData.getData(), rawData.getSize());
+
+    for (int i = 0; i < tree.getNumChildren(); ++i)
+    {
+        const auto child = tree.getChild(i);
+        if (child.hasType(kChunkRef))
+        {
+            // chunks are written depth-first, so the children always go after the parent
+            const int childIndex = child.getProperty(kChunkIndex, -1);
+            jassert(childIndex > chunkIndex && childIndex < chunks.size());
+            tree.removeChild(i, nullptr);
+            if (childIndex > chunkIndex && childIndex < chunks.size())
+            {
+                tree.addChild(readChunk(childIndex, file, chunks), i, nullptr);
+            }
+        }
+    }
+
+    return tree;
+}
+
+// 64-bit FNV-1a, only used to detect the chunks which haven't changed since the last save
+static uint64 getChunkHash(const MemoryBlock &data) noexcept
+{
+    uint64 hash = 14695981039346656037ull;
+    const auto *bytes = static_cast<const uint8 *>(data.getData());
+    for (size_t i = 0; i < data.getSize(); ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// Compression is the most expensive part of saving, while most of the chunks
+// (e.g. the tracks which were not edited, or the version control history)
+// are the same between saves; so the compressed chunks of the last save
+// of each target file are kept and reused, and only the chunks that have changed
+// are compressed again; only a few most recently saved files are cached. The hash is only used for the lookup, the raw data
+// is kept as well and compared byte by byte, so a collision can't corrupt the file.
+struct CompressedChunk final
+{
+    MemoryBlock rawData;
+    MemoryBlock compressedData;
+};
+
+using CompressedChunks = FlatHashMap<String, CompressedChunk, StringHash>;
+
+struct CompressedChunksCache final
+{
+    CriticalSection lock;
+    FlatHashMap<String, CompressedChunks, StringHash> files;
+    StringArray recentFiles; // the most recently saved one is the last
+};
+
+static CompressedChunksCache &getCompressedChunksCache()
+{
+    static CompressedChunksCache cache;
+    return cache;
+}
+
+static void compressChunks(const Array<MemoryBlock> &rawChunks,
+    Array<MemoryBlock> &outCompressedChunks, const String &cacheKey)
+{
+    auto &cache = getCompressedChunksCache();
+
+    // the previous save of this file, if any
+    CompressedChunks lastSavedChunks;
+
+    {
+        const ScopedLock lock(cache.lock);
+        const auto found = cache.files.find(cacheKey);
+        if (found != cache.files.end())
+        {
+            lastSavedChunks.swap(found.value());
+        }
+    }
+
+    CompressedChunks newSavedChunks;
+    newSavedChunks.reserve(rawChunks.size());
+
+    for (const auto &rawChunk : rawChunks)
+    {
+        const String key = String::toHexString(int64(getChunkHash(rawChunk))) +
+            "-" + String::toHexString(int64(rawChunk.getSize()));
+
+        MemoryBlock compressedChunk;
+
+        const auto found = lastSavedChunks.find(key);
+        if (found != lastSavedChunks.end() && found->second.rawData == rawChunk)
+        {
+            compressedChunk = found->second.compressedData;
+        }
+        else
+        {
+            MemoryOutputStream compressedStream(compressedChunk, false);
+            GZIPCompressorOutputStream compressor(compressedStream);
+            compressor.write(rawChunk.getData(), rawChunk.getSize());
+            compressor.flush();
+        }
+
+        newSavedChunks[key] = { rawChunk, compressedChunk };
+        outCompressedChunks.add(compressedChunk);
+    }
+
+    static const int maxNumCachedFiles = 4;
+
+    const ScopedLock lock(cache.lock);
+    cache.files[cacheKey].swap(newSavedChunks);
+    cache.recentFiles.removeString(cacheKey);
+    cache.recentFiles.add(cacheKey);
+
+    while (cache.recentFiles.size() > maxNumCachedFiles)
+    {
+        cache.files.erase(cache.recentFiles[0]);
+        cache.recentFiles.remove(0);
+    }
+}
+
+static Result saveChunked(OutputStream &out, const ValueTree &tree, const String &cacheKey)
+{
+    Array<MemoryBlock> rawChunks;
+    writeChunks(tree, true, rawChunks);
+
+    Array<MemoryBlock> compressedChunks;
+    compressChunks(rawChunks, compressedChunks, cacheKey);
+
+    out.writeInt64(kHelioHeaderV3);
+    out.writeInt(compressedChunks.size());
+
+    int64 offset = sizeof(int64) + sizeof(int) + compressedChunks.size() * kChunkInfoSize;
+    for (int i = 0; i < compressedChunks.size(); ++i)
+    {
+        out.writeInt64(offset);
+        out.writeInt(int(compressedChunks.getReference(i).getSize()));
+        out.writeInt(int(rawChunks.getReference(i).getSize()));
+        offset += compressedChunks.getReference(i).getSize();
+    }
+
+    for (const auto &compressedChunk : compressedChunks)
+    {
+        if (!out.write(compressedChunk.getData(), compressedChunk.getSize()))
+        {
+            return Result::fail("Failed to save");
+        }
+    }
+
+    return Result::ok();
+}
+
+static Result loadChunked(MemoryInputStream &in, const MemoryBlock &file, ValueTree &tree)
+{
+    const int numChunks = in.readInt();
+    if (numChunks <= 0 || in.getNumBytesRemaining() < numChunks * kChunkInfoSize)
+    {
+        return Result::fail("Failed to load");
+    }
+
+    Array<ChunkInfo> chunks;
+    chunks.resize(numChunks);
+    for (auto &chunk : chunks)
+    {
+        chunk.offset = in.readInt64();
+        chunk.compressedSize = in.readInt();
+        chunk.rawSize = in.readInt();
+    }
+
+    tree = readChunk(0, file, chunks);
+    return tree.isValid() ? Result::ok() : Result::fail("Failed to load");
+}
+
+//===----------------------------------------------------------------------===//
+// BinarySerializer
+//===----------------------------------------------------------------------===//
+
 Result BinarySerializer::saveToFile(File file, const ValueTree &tree) const
+{
+    return this->saveToTemporaryFile(file, file, tree);
+}
+
+Result BinarySerializer::saveToTemporaryFile(File file, const File &targetFile, const ValueTree &tree) const
 {
     FileOutputStream fileStream(file);
     if (fileStream.openedOk())
     {
         fileStream.setPosition(0);
         fileStream.truncate();
-        fileStream.writeInt64(kHelioHeaderV2);
-        tree.writeToStream(fileStream);
-        return Result::ok();
+        // temporary files have random names, so the cache is keyed by the target
+        return saveChunked(fileStream, tree, targetFile.getFullPathName());
     }
 
     return Result::fail("Failed to save");
@@ -50,7 +330,11 @@ Result BinarySerializer::loadFromFile(const File &file, ValueTree &tree) const
     {
         MemoryInputStream inputStream(mb, false);
         const auto magicNumber = static_cast<uint64>(inputStream.readInt64());
-        if (magicNumber == kHelioHeaderV2)
+        if (magicNumber == kHelioHeaderV3)
+        {
+            return loadChunked(inputStream, mb, tree);
+        }
+        else if (magicNumber == kHelioHeaderV2)
         {
             tree = ValueTree::readFromStream(inputStream);
             return Result::ok();
@@ -88,5 +372,6 @@ bool BinarySerializer::supportsFileWithExtension(const String &extension) const
 
 bool BinarySerializer::supportsFileWithHeader(const String &header) const
 {
-    return header.startsWith(kHelioHeaderV2String);
+    return header.startsWith(kHelioHeaderV3String) ||
+        header.startsWith(kHelioHeaderV2String);
 }
@@ -24,6 +24,7 @@ class BinarySerializer final : public Serializer
 public:
 
     Result saveToFile(File file, const ValueTree &tree) const override;
+    Result saveToTemporaryFile(File file, const File &targetFile, const ValueTree &tree) const override;
     Result loadFromFile(const File &file, ValueTree &tree) const override;
 
     Result saveToString(String &string, const ValueTree &tree) const override;
@@ -21,6 +21,49 @@
 #include "DocumentHelpers.h"
 #include "MainLayout.h"
 
+class Document::BackgroundSaveThread final : public Thread
+{
+public:
+
+    BackgroundSaveThread(Document &document, const File &file, Function<bool()> saveFunction) :
+        Thread("Document saving"),
+        document(&document),
+        file(file),
+        saveFunction(saveFunction) {}
+
+    ~BackgroundSaveThread() override
+    {
+        this->stopThread(-1);
+    }
+
+private:
+
+    void run() override
+    {
+        const bool savedOk = this->saveFunction();
+
+        // not using the blocking callbackOnMessageThread here,
+        // because the message thread might be waiting for this one to finish;
+        // the save function is released on the message thread later, when the thread
+        // is deleted, since it may hold the trees which are still used there:
+        WeakReference<Document> document(this->document);
+        const File file(this->file);
+        MessageManager::callAsync([document, file, savedOk]()
+        {
+            if (document != nullptr)
+            {
+                document->onBackgroundSaveFinished(file, savedOk);
+            }
+        });
+    }
+
+    const WeakReference<Document> document;
+    const File file;
+    Function<bool()> saveFunction;
+
+    JUCE_DECLARE_NON_COPYABLE(BackgroundSaveThread)
+};
+
 Document::Document(DocumentOwner &documentOwner,
     const String &defaultName,
     const String &defaultExtension) :
@@ -51,6 +94,7 @@ Document::Document(DocumentOwner &documentOwner, const File &existingFile) :
 
 Document::~Document()
 {
+    this->waitForBackgroundSave();
     this->owner.removeChangeListener(this);
 }
 
@@ -111,6 +155,63 @@ void Document::forceSave()
     }
 }
 
+void Document::saveInBackground()
+{
+    if (!this->hasChanges || this->workingFile.getFullPathName().isEmpty())
+    {
+        return;
+    }
+
+    // the previous save has to finish first, so that it never overwrites the newer data
+    this->waitForBackgroundSave();
+
+    auto saveFunction = this->owner.onDocumentSaveInBackground(this->workingFile);
+    if (saveFunction == nullptr)
+    {
+        this->internalSave(this->workingFile);
+        return;
+    }
+
+    // any change made from now on will mark the document as changed again
+    this->hasChanges = false;
+
+    this->backgroundSaveThread.reset(new BackgroundSaveThread(*this,
+        this->workingFile, saveFunction));
+
+    this->backgroundSaveThread->startThread(3);
+}
+
+void Document::waitForBackgroundSave()
+{
+    if (this->backgroundSaveThread != nullptr)
+    {
+        this->backgroundSaveThread->waitForThreadToExit(-1);
+        this->backgroundSaveThread = nullptr;
+    }
+}
+
+void Document::onBackgroundSaveFinished(const File &file, bool savedOk)
+{
+    // release the saved data here, unless the thread is still exiting
+    if (this->backgroundSaveThread != nullptr &&
+        !this->backgroundSaveThread->isThreadRunning())
+    {
+        this->backgroundSaveThread = nullptr;
+    }
+
+    if (savedOk)
+    {
+        File savedFile(file);
+        this->owner.onDocumentDidSave(savedFile);
+        DBG("Document saved in background: " + file.getFullPathName());
+    }
+    else
+    {
+        this->hasChanges = true;
+        DBG("Document save failed: " + file.getFullPathName());
+    }
+}
+
 void Document::saveAs()
 {
 #if HELIO_DESKTOP
@@ -263,6 +364,8 @@ bool Document::internalSave(File result)
         return false;
     }
 
+    this->waitForBackgroundSave();
+
     const bool savedOk = this->owner.onDocumentSave(result);
 
     if (savedOk)
@@ -47,6 +47,7 @@ public:
 
     void save();
     void forceSave();
+    void saveInBackground(); // used by autosaver
     void saveAs();
     void exportAs(const String &exportExtension,
                   const String &defaultFilename = "");
@@ -65,6 +66,8 @@ public:
 protected:
 
     bool internalSave(File result);
+    void waitForBackgroundSave();
+    void onBackgroundSaveFinished(const File &file, bool savedOk);
     bool internalLoad(File result);
     bool fileHasBeenModified() const;
 
@@ -84,5 +87,9 @@ protected:
 
 private:
 
+    class BackgroundSaveThread;
+    UniquePointer<BackgroundSaveThread> backgroundSaveThread;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(Document)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Document)
 };
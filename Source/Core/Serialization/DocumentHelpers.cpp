@@ -252,6 +252,43 @@ ValueTree DocumentHelpers::load(const String &string)
 
 }
 
+int64 DocumentHelpers::estimateSizeInBytes(const ValueTree &tree)
+{
+    if (!tree.isValid())
+    {
+        return 0;
+    }
+
+    // a rough guess of what the node and each of its properties cost,
+    // not including the strings and the binary data they refer to
+    static const int64 nodeOverhead = 96;
+    static const int64 propertyOverhead = 32;
+
+    int64 result = nodeOverhead;
+
+    for (int i = 0; i < tree.getNumProperties(); ++i)
+    {
+        const auto &value = tree.getProperty(tree.getPropertyName(i));
+        result += propertyOverhead;
+
+        if (value.isString())
+        {
+            result += value.toString().getNumBytesAsUTF8();
+        }
+        else if (auto *data = value.getBinaryData())
+        {
+            result += data->getSize();
+        }
+    }
+
+    for (const auto &child : tree)
+    {
+        result += DocumentHelpers::estimateSizeInBytes(child);
+    }
+
+    return result;
+}
+
 static File createTempFileForSaving(const File &parentDirectory, String name, const String& suffix)
 {
     return parentDirectory.getNonexistentChildFile(name, suffix, false);
@@ -40,6 +40,9 @@ public:
     static ValueTree load(const File &file);
     static ValueTree load(const String &string);
 
+    // Roughly how much memory the tree holds, e.g. for the undo history limits
+    static int64 estimateSizeInBytes(const ValueTree &tree);
+
     template<typename T>
     static ValueTree load(const File &file)
     {
@@ -54,7 +57,7 @@ public:
     {
         T serializer;
         TempDocument tempDoc(file);
-        if (serializer.saveToFile(tempDoc.getFile(), tree).wasOk())
+        if (serializer.saveToTemporaryFile(tempDoc.getFile(), file, tree).wasOk())
         {
             return tempDoc.overwriteTargetFileWithTemporary();
         }
@@ -68,7 +71,7 @@ public:
         T serializer;
         TempDocument tempDoc(file);
         const auto treeNode(serializable.serialize());
-        if (serializer.saveToFile(tempDoc.getFile(), treeNode).wasOk())
+        if (serializer.saveToTemporaryFile(tempDoc.getFile(), file, treeNode).wasOk())
         {
             return tempDoc.overwriteTargetFileWithTemporary();
         }
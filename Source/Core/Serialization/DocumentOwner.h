@@ -44,6 +44,11 @@ protected:
     virtual void onDocumentDidLoad(File &file) {}
     virtual bool onDocumentSave(File &file) = 0;
     virtual void onDocumentDidSave(File &file) {}
+
+    // an owner can prepare the data to be saved on the message thread,
+    // and return the function which writes it on a background thread;
+    // returning nullptr means falling back to the synchronous onDocumentSave
+    virtual Function<bool()> onDocumentSaveInBackground(File &file) { return nullptr; }
     virtual void onDocumentImport(File &file) = 0;
     virtual bool onDocumentExport(File &file) = 0;
 
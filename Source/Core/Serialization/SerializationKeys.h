@@ -137,6 +137,12 @@ namespace Serialization
         static const Identifier transport = "transport";
         static const Identifier transportSeekPosition = "seekPosition";
 
+        static const Identifier renderSettings = "renderSettings";
+        static const Identifier renderBlockSize = "blockSize";
+        static const Identifier renderBitDepth = "bitDepth";
+        static const Identifier renderDoublePrecision = "doublePrecision";
+        static const Identifier renderParallelProcessing = "parallelProcessing";
+
         static const Identifier audioPlugin = "pluginSettings";
 
         static const Identifier plugin = "plugin";
@@ -183,6 +189,7 @@ namespace Serialization
         static const Identifier lastUsedScale = "lastUsedScale";
         static const Identifier lastUpdatesInfo = "lastUpdatesInfo";
         static const Identifier lastUsedFont = "lastUsedFont";
+        static const Identifier lastUsedRenderSettings = "lastUsedRenderSettings";
 
         static const Identifier openGLState = "openGL";
         static const Identifier enabledState = "enabled";
@@ -424,6 +431,10 @@ namespace Serialization
         static const Identifier packItem = "record";
         static const Identifier packItemDeltaId = "deltaId";
 
+        static const Identifier deltaPool = "deltaPool";
+        static const Identifier deltaPoolItem = "blob";
+        static const Identifier deltaPoolItemKey = "key";
+
         static const Identifier remoteCache = "remoteCache";
         static const Identifier remoteCacheSyncTime = "lastSync";
         static const Identifier remoteRevision = "revision";
@@ -451,6 +462,7 @@ namespace Serialization
         static const Identifier deltaName = "name";
         static const Identifier deltaIntParam = "intParam";
         static const Identifier deltaStringParam = "stringParam";
+        static const Identifier deltaDataKey = "dataKey";
         static const Identifier deltaTypeId = "type";
 
         static const Identifier headStateDelta = "headState";
@@ -615,6 +627,7 @@ namespace Serialization
     {
         static const Identifier undoStack = "undoStack";
         static const Identifier transaction = "transaction";
+        static const Identifier transactionSize = "size";
 
         static const Identifier name = "name";
         static const Identifier xPath = "path";
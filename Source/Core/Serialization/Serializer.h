@@ -26,6 +26,13 @@ public:
     virtual ~Serializer() {}
 
     virtual Result saveToFile(File file, const ValueTree &tree) const = 0;
+
+    // Saves to a temporary file, which is going to replace the target file
+    // afterwards; serializers may use the target to identify the document
+    virtual Result saveToTemporaryFile(File file, const File &targetFile, const ValueTree &tree) const
+    {
+        return this->saveToFile(file, tree);
+    }
     virtual Result loadFromFile(const File &file, ValueTree &tree) const = 0;
 
     virtual Result saveToString(String &string, const ValueTree &tree) const = 0;
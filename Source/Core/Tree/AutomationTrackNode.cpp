@@ -125,6 +125,7 @@ VCS::DiffLogic *AutomationTrackNode::getDiffLogic() const
 
 void AutomationTrackNode::resetStateTo(const VCS::TrackedItem &newState)
 {
+    this->resetSerializationCache();
     using namespace Serialization::VCS;
     for (int i = 0; i < newState.getNumDeltas(); ++i)
     {
@@ -165,6 +166,11 @@ void AutomationTrackNode::resetStateTo(const VCS::TrackedItem &newState)
 
 ValueTree AutomationTrackNode::serialize() const
 {
+    if (this->serializationCache.isValid())
+    {
+        return this->getSerializationCache();
+    }
+
     ValueTree tree(Serialization::Core::treeNode);
 
     this->serializeVCSUuid(tree);
@@ -179,12 +185,14 @@ ValueTree AutomationTrackNode::serialize() const
 
     TreeNodeSerializer::serializeChildren(*this, tree);
 
+    this->serializationCache = tree;
     return tree;
 }
 
 void AutomationTrackNode::deserialize(const ValueTree &tree)
 {
     this->reset();
+    this->resetSerializationCache();
 
     this->deserializeVCSUuid(tree);
     this->deserializeTrackProperties(tree);
@@ -73,6 +73,7 @@ void MidiTrackNode::safeRename(const String &newName, bool sendNotifications)
 
 void MidiTrackNode::importMidi(const MidiMessageSequence &sequence, short timeFormat)
 {
+    this->resetSerializationCache();
     this->sequence->importMidi(sequence, timeFormat);
 }
 
@@ -103,6 +104,7 @@ void MidiTrackNode::resetClipsDelta(const ValueTree &state)
     jassert(state.hasType(Serialization::VCS::PatternDeltas::clipsAdded));
 
     //this->reset();
+    this->resetSerializationCache();
     this->getPattern()->reset();
 
     Pattern *pattern = this->getPattern();
@@ -126,6 +128,7 @@ const String &MidiTrackNode::getTrackId() const noexcept
 void MidiTrackNode::setTrackId(const String &val)
 {
     this->id = val;
+    this->resetSerializationCache();
 }
 
 String MidiTrackNode::getTrackName() const noexcept
@@ -158,6 +161,7 @@ void MidiTrackNode::setTrackColour(const Colour &val, bool sendNotifications)
     if (this->colour != val)
     {
         this->colour = val;
+        this->resetSerializationCache();
         if (sendNotifications)
         {
             this->dispatchChangeTrackProperties();
@@ -176,6 +180,7 @@ void MidiTrackNode::setTrackInstrumentId(const String &val, bool sendNotificatio
     if (this->instrumentId != val)
     {
         this->instrumentId = val;
+        this->resetSerializationCache();
         if (sendNotifications)
         {
             this->dispatchChangeTrackProperties();
@@ -195,6 +200,7 @@ void MidiTrackNode::setTrackControllerNumber(int val, bool sendNotifications)
     if (this->controllerNumber != val)
     {
         this->controllerNumber = val;
+        this->resetSerializationCache();
         if (sendNotifications)
         {
             this->dispatchChangeTrackProperties();
@@ -247,6 +253,8 @@ void MidiTrackNode::setXPath(const String &path, bool sendNotifications)
     {
         return;
     }
+
+    this->resetSerializationCache();
     
     // Split path and move the item into a target place in a tree
     // If no matching groups found, create them
@@ -336,6 +344,7 @@ void MidiTrackNode::setXPath(const String &path, bool sendNotifications)
 
 void MidiTrackNode::dispatchChangeEvent(const MidiEvent &oldEvent, const MidiEvent &newEvent)
 {
+    this->resetSerializationCache();
     if (this->lastFoundParent != nullptr)
     {
         this->lastFoundParent->broadcastChangeEvent(oldEvent, newEvent);
@@ -344,6 +353,7 @@ void MidiTrackNode::dispatchChangeEvent(const MidiEvent &oldEvent, const MidiEve
 
 void MidiTrackNode::dispatchAddEvent(const MidiEvent &event)
 {
+    this->resetSerializationCache();
     if (this->lastFoundParent != nullptr)
     {
         this->lastFoundParent->broadcastAddEvent(event);
@@ -352,6 +362,7 @@ void MidiTrackNode::dispatchAddEvent(const MidiEvent &event)
 
 void MidiTrackNode::dispatchRemoveEvent(const MidiEvent &event)
 {
+    this->resetSerializationCache();
     if (this->lastFoundParent != nullptr)
     {
         this->lastFoundParent->broadcastRemoveEvent(event);
@@ -360,6 +371,7 @@ void MidiTrackNode::dispatchRemoveEvent(const MidiEvent &event)
 
 void MidiTrackNode::dispatchPostRemoveEvent(MidiSequence *const layer)
 {
+    this->resetSerializationCache();
     jassert(layer == this->sequence.get());
     if (this->lastFoundParent != nullptr)
     {
@@ -369,6 +381,7 @@ void MidiTrackNode::dispatchPostRemoveEvent(MidiSequence *const layer)
 
 void MidiTrackNode::dispatchChangeTrackProperties()
 {
+    this->resetSerializationCache();
     if (this->lastFoundParent != nullptr)
     {
         this->lastFoundParent->broadcastChangeTrackProperties(this);
@@ -385,6 +398,7 @@ void MidiTrackNode::dispatchChangeProjectBeatRange()
 
 void MidiTrackNode::dispatchAddClip(const Clip &clip)
 {
+    this->resetSerializationCache();
     if (this->lastFoundParent != nullptr)
     {
         this->lastFoundParent->broadcastAddClip(clip);
@@ -393,6 +407,7 @@ void MidiTrackNode::dispatchAddClip(const Clip &clip)
 
 void MidiTrackNode::dispatchChangeClip(const Clip &oldClip, const Clip &newClip)
 {
+    this->resetSerializationCache();
     if (this->lastFoundParent != nullptr)
     {
         this->lastFoundParent->broadcastChangeClip(oldClip, newClip);
@@ -401,6 +416,7 @@ void MidiTrackNode::dispatchChangeClip(const Clip &oldClip, const Clip &newClip)
 
 void MidiTrackNode::dispatchRemoveClip(const Clip &clip)
 {
+    this->resetSerializationCache();
     if (this->lastFoundParent != nullptr)
     {
         this->lastFoundParent->broadcastRemoveClip(clip);
@@ -409,6 +425,7 @@ void MidiTrackNode::dispatchRemoveClip(const Clip &clip)
 
 void MidiTrackNode::dispatchPostRemoveClip(Pattern *const pattern)
 {
+    this->resetSerializationCache();
     jassert(pattern == this->pattern.get());
     if (this->lastFoundParent != nullptr)
     {
@@ -422,6 +439,23 @@ ProjectNode *MidiTrackNode::getProject() const noexcept
     return this->lastFoundParent;
 }
 
+//===----------------------------------------------------------------------===//
+// Serialization cache
+//===----------------------------------------------------------------------===//
+
+ValueTree MidiTrackNode::getSerializationCache() const
+{
+    // a tree cannot have two parents, so if the previous save
+    // is still holding the cached tree, it has to be copied:
+    return this->serializationCache.getParent().isValid() ?
+        this->serializationCache.createCopy() : this->serializationCache;
+}
+
+void MidiTrackNode::resetSerializationCache() noexcept
+{
+    this->serializationCache = {};
+}
+
 //===----------------------------------------------------------------------===//
 // Add to tree and remove from tree callbacks
 //===----------------------------------------------------------------------===//
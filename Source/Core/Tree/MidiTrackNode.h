@@ -134,5 +134,14 @@ protected:
 
     String instrumentId;
     int controllerNumber;
-    
+
+protected:
+
+    // the serialized track is kept between the saves and is dropped on any change,
+    // so that saving a project only re-serializes the tracks edited since the last save;
+    // the cached tree itself is never modified, the background save may be reading it
+    ValueTree getSerializationCache() const;
+    void resetSerializationCache() noexcept;
+    mutable ValueTree serializationCache;
+
 };
@@ -131,6 +131,7 @@ VCS::DiffLogic *PianoTrackNode::getDiffLogic() const
 
 void PianoTrackNode::resetStateTo(const VCS::TrackedItem &newState)
 {
+    this->resetSerializationCache();
     using namespace Serialization::VCS;
     for (int i = 0; i < newState.getNumDeltas(); ++i)
     {
@@ -170,6 +171,11 @@ void PianoTrackNode::resetStateTo(const VCS::TrackedItem &newState)
 
 ValueTree PianoTrackNode::serialize() const
 {
+    if (this->serializationCache.isValid())
+    {
+        return this->getSerializationCache();
+    }
+
     ValueTree tree(Serialization::Core::treeNode);
 
     this->serializeVCSUuid(tree);
@@ -184,12 +190,14 @@ ValueTree PianoTrackNode::serialize() const
 
     TreeNodeSerializer::serializeChildren(*this, tree);
 
+    this->serializationCache = tree;
     return tree;
 }
 
 void PianoTrackNode::deserialize(const ValueTree &tree)
 {
     this->reset();
+    this->resetSerializationCache();
 
     this->deserializeVCSUuid(tree);
     this->deserializeTrackProperties(tree);
@@ -754,6 +754,21 @@ bool ProjectNode::onDocumentSave(File &file)
     return DocumentHelpers::save<BinarySerializer>(file, projectNode);
 }
 
+Function<bool()> ProjectNode::onDocumentSaveInBackground(File &file)
+{
+    // tracks and vcs keep their serialized trees between saves, so this part
+    // only re-serializes what has changed since the last save,
+    // and the rest (i.e. compressing and writing) is done in background:
+    const auto projectNode(this->save());
+    return [file, projectNode]()
+    {
+#if DEBUG
+        DocumentHelpers::save<XmlSerializer>(file.withFileExtension("xml"), projectNode);
+#endif
+        return DocumentHelpers::save<BinarySerializer>(file, projectNode);
+    };
+}
+
 void ProjectNode::onDocumentImport(File &file)
 {
     if (file.hasFileExtension("mid") || file.hasFileExtension("midi"))
@@ -179,6 +179,7 @@ protected:
     bool onDocumentLoad(File &file) override;
     void onDocumentDidLoad(File &file) override;
     bool onDocumentSave(File &file) override;
+    Function<bool()> onDocumentSaveInBackground(File &file) override;
     void onDocumentImport(File &file) override;
     bool onDocumentExport(File &file) override;
 
@@ -269,7 +269,7 @@ void VersionControlNode::initVCS()
     {
         this->vcs.reset(new VersionControl(*parentProject));
         this->vcs->addChangeListener(parentProject);
-        parentProject->addChangeListener(this->vcs.get());
+        parentProject->addListener(this->vcs.get());
     }
 }
 
@@ -278,7 +278,7 @@ void VersionControlNode::shutdownVCS()
     auto *parentProject = this->findParentOfType<ProjectNode>();
     if (parentProject != nullptr && this->vcs != nullptr)
     {
-        parentProject->removeChangeListener(this->vcs.get());
+        parentProject->removeListener(this->vcs.get());
         this->vcs->removeChangeListener(parentProject);
     }
 }
@@ -20,6 +20,7 @@
 #include "MidiTrackSource.h"
 #include "AutomationTrackNode.h"
 #include "SerializationKeys.h"
+#include "DocumentHelpers.h"
 
 //===----------------------------------------------------------------------===//
 // Insert
@@ -65,7 +66,8 @@ bool AutomationTrackInsertAction::undo()
 
 int AutomationTrackInsertAction::getSizeInUnits()
 {
-    return this->trackName.length();
+    return int(sizeof(AutomationTrackInsertAction) +
+        DocumentHelpers::estimateSizeInBytes(this->trackState));
 }
 
 ValueTree AutomationTrackInsertAction::serialize() const
@@ -103,15 +105,13 @@ AutomationTrackRemoveAction::AutomationTrackRemoveAction(MidiTrackSource &source
     WeakReference<TreeNode> parentTreeItem, const String &trackId) noexcept :
     UndoAction(source),
     parentTreeItem(parentTreeItem),
-    trackId(trackId),
-    numEvents(0) {}
+    trackId(trackId) {}
 
 bool AutomationTrackRemoveAction::perform()
 {
     if (AutomationTrackNode *treeItem =
         this->source.findTrackById<AutomationTrackNode>(this->trackId))
     {
-        this->numEvents = treeItem->getSequence()->size();
         this->serializedTreeItem = treeItem->serialize();
         this->trackName = treeItem->getTrackName();
         return this->parentTreeItem->deleteItem(treeItem, true);
@@ -138,10 +138,11 @@ int AutomationTrackRemoveAction::getSizeInUnits()
 {
     if (this->serializedTreeItem.isValid())
     {
-        return (this->numEvents * sizeof(MidiEvent));
+        return int(sizeof(AutomationTrackRemoveAction) +
+            DocumentHelpers::estimateSizeInBytes(this->serializedTreeItem));
     }
     
-    return 1;
+    return int(sizeof(AutomationTrackRemoveAction));
 }
 
 ValueTree AutomationTrackRemoveAction::serialize() const
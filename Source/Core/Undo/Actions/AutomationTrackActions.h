@@ -88,7 +88,6 @@ private:
     WeakReference<TreeNode> parentTreeItem;
 
     String trackId;
-    int numEvents = 0;
     
     ValueTree serializedTreeItem;
     String trackName;
@@ -56,7 +56,7 @@ bool NoteInsertAction::undo()
 
 int NoteInsertAction::getSizeInUnits()
 {
-    return sizeof(Note);
+    return sizeof(NoteInsertAction);
 }
 
 ValueTree NoteInsertAction::serialize() const
@@ -113,7 +113,7 @@ bool NoteRemoveAction::undo()
 
 int NoteRemoveAction::getSizeInUnits()
 {
-    return sizeof(Note);
+    return sizeof(NoteRemoveAction);
 }
 
 ValueTree NoteRemoveAction::serialize() const
@@ -174,7 +174,7 @@ bool NoteChangeAction::undo()
 
 int NoteChangeAction::getSizeInUnits()
 {
-    return sizeof(Note) * 2;
+    return sizeof(NoteChangeAction);
 }
 
 UndoAction *NoteChangeAction::createCoalescedAction(UndoAction *nextAction)
@@ -236,6 +236,67 @@ void NoteChangeAction::reset()
     this->trackId.clear();
 }
 
+//===----------------------------------------------------------------------===//
+// Compact note parameters
+//===----------------------------------------------------------------------===//
+
+// The note ids are interned, so that all the actions referring to the same
+// note share a single string; the pool drops the unused ones by itself
+static String internNoteId(const Note::Id &id)
+{
+    static StringPool noteIdsPool;
+    return noteIdsPool.getPooledString(id);
+}
+
+enum NoteField : uint8
+{
+    NoteBeat = 1 << 0,
+    NoteKey = 1 << 1,
+    NoteLength = 1 << 2,
+    NoteVelocity = 1 << 3,
+    NoteTuplet = 1 << 4
+};
+
+PackedNote::PackedNote(const Note &note) noexcept :
+    id(internNoteId(note.getId())),
+    beat(note.getBeat()),
+    length(note.getLength()),
+    velocity(note.getVelocity()),
+    key(int16(note.getKey())),
+    tuplet(note.getTuplet()) {}
+
+Note PackedNote::unpack() const noexcept
+{
+    return Note(this->id, this->beat, this->key,
+        this->length, this->velocity, this->tuplet);
+}
+
+uint8 PackedNote::getChangedFields(const PackedNote &other) const noexcept
+{
+    uint8 fields = 0;
+    fields |= (this->beat != other.beat) ? NoteBeat : 0;
+    fields |= (this->key != other.key) ? NoteKey : 0;
+    fields |= (this->length != other.length) ? NoteLength : 0;
+    fields |= (this->velocity != other.velocity) ? NoteVelocity : 0;
+    fields |= (this->tuplet != other.tuplet) ? NoteTuplet : 0;
+    return fields;
+}
+
+static void packNoteParameters(const Array<Note> &notes, Array<PackedNote> &outPacked)
+{
+    outPacked.ensureStorageAllocated(notes.size());
+    for (const auto &note : notes)
+    {
+        outPacked.add(PackedNote(note));
+    }
+}
+
+static int getPackedNotesSize(const Array<PackedNote> &notes) noexcept
+{
+    // the ids are shared, so only the pointers are counted here
+    return int(sizeof(PackedNote)) * notes.size();
+}
+
 //===----------------------------------------------------------------------===//
 // Insert Group
 //===----------------------------------------------------------------------===//
@@ -245,7 +306,8 @@ NotesGroupInsertAction::NotesGroupInsertAction(MidiTrackSource &source,
     UndoAction(source),
     trackId(trackId)
 {
-    this->notes.swapWith(target);
+    packNoteParameters(target, this->notes);
+    target.clearQuick();
 }
 
 bool NotesGroupInsertAction::perform()
@@ -253,7 +315,8 @@ bool NotesGroupInsertAction::perform()
     if (PianoSequence *sequence =
         this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
     {
-        return sequence->insertGroup(this->notes, false);
+        auto notes = this->unpackNotes();
+        return sequence->insertGroup(notes, false);
     }
     
     return false;
@@ -264,7 +327,8 @@ bool NotesGroupInsertAction::undo()
     if (PianoSequence *sequence =
         this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
     {
-        return sequence->removeGroup(this->notes, false);
+        auto notes = this->unpackNotes();
+        return sequence->removeGroup(notes, false);
     }
     
     return false;
@@ -272,7 +336,19 @@ bool NotesGroupInsertAction::undo()
 
 int NotesGroupInsertAction::getSizeInUnits()
 {
-    return (sizeof(Note) * this->notes.size());
+    return int(sizeof(NotesGroupInsertAction)) + getPackedNotesSize(this->notes);
+}
+
+Array<Note> NotesGroupInsertAction::unpackNotes() const
+{
+    Array<Note> result;
+    result.ensureStorageAllocated(this->notes.size());
+    for (const auto &note : this->notes)
+    {
+        result.add(note.unpack());
+    }
+
+    return result;
 }
 
 ValueTree NotesGroupInsertAction::serialize() const
@@ -282,7 +358,7 @@ ValueTree NotesGroupInsertAction::serialize() const
     
     for (int i = 0; i < this->notes.size(); ++i)
     {
-        tree.appendChild(this->notes.getUnchecked(i).serialize(), nullptr);
+        tree.appendChild(this->notes.getReference(i).unpack().serialize(), nullptr);
     }
     
     return tree;
@@ -292,12 +368,13 @@ void NotesGroupInsertAction::deserialize(const ValueTree &tree)
 {
     this->reset();
     this->trackId = tree.getProperty(Serialization::Undo::trackId);
+    this->notes.ensureStorageAllocated(tree.getNumChildren());
     
     for (const auto &props : tree)
     {
         Note n;
         n.deserialize(props);
-        this->notes.add(n);
+        this->notes.add(PackedNote(n));
     }
 }
 
@@ -316,7 +393,8 @@ NotesGroupRemoveAction::NotesGroupRemoveAction(MidiTrackSource &source,
     UndoAction(source),
     trackId(trackId)
 {
-    this->notes.swapWith(target);
+    packNoteParameters(target, this->notes);
+    target.clearQuick();
 }
 
 bool NotesGroupRemoveAction::perform()
@@ -324,7 +402,8 @@ bool NotesGroupRemoveAction::perform()
     if (PianoSequence *sequence =
         this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
     {
-        return sequence->removeGroup(this->notes, false);
+        auto notes = this->unpackNotes();
+        return sequence->removeGroup(notes, false);
     }
     
     return false;
@@ -335,7 +414,8 @@ bool NotesGroupRemoveAction::undo()
     if (PianoSequence *sequence =
         this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
     {
-        return sequence->insertGroup(this->notes, false);
+        auto notes = this->unpackNotes();
+        return sequence->insertGroup(notes, false);
     }
     
     return false;
@@ -343,7 +423,19 @@ bool NotesGroupRemoveAction::undo()
 
 int NotesGroupRemoveAction::getSizeInUnits()
 {
-    return (sizeof(Note) * this->notes.size());
+    return int(sizeof(NotesGroupRemoveAction)) + getPackedNotesSize(this->notes);
+}
+
+Array<Note> NotesGroupRemoveAction::unpackNotes() const
+{
+    Array<Note> result;
+    result.ensureStorageAllocated(this->notes.size());
+    for (const auto &note : this->notes)
+    {
+        result.add(note.unpack());
+    }
+
+    return result;
 }
 
 ValueTree NotesGroupRemoveAction::serialize() const
@@ -353,7 +445,7 @@ ValueTree NotesGroupRemoveAction::serialize() const
     
     for (int i = 0; i < this->notes.size(); ++i)
     {
-        tree.appendChild(this->notes.getUnchecked(i).serialize(), nullptr);
+        tree.appendChild(this->notes.getReference(i).unpack().serialize(), nullptr);
     }
     
     return tree;
@@ -363,12 +455,13 @@ void NotesGroupRemoveAction::deserialize(const ValueTree &tree)
 {
     this->reset();
     this->trackId = tree.getProperty(Serialization::Undo::trackId);
+    this->notes.ensureStorageAllocated(tree.getNumChildren());
     
     for (const auto &props : tree)
     {
         Note n;
         n.deserialize(props);
-        this->notes.add(n);
+        this->notes.add(PackedNote(n));
     }
 }
 
@@ -387,8 +480,9 @@ NotesGroupChangeAction::NotesGroupChangeAction(MidiTrackSource &source,
     UndoAction(source),
     trackId(trackId)
 {
-    this->notesBefore.swapWith(state1);
-    this->notesAfter.swapWith(state2);
+    this->packNotes(state1, state2);
+    state1.clearQuick();
+    state2.clearQuick();
 }
 
 bool NotesGroupChangeAction::perform()
@@ -396,7 +490,9 @@ bool NotesGroupChangeAction::perform()
     if (PianoSequence *sequence =
         this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
     {
-        return sequence->changeGroup(this->notesBefore, this->notesAfter, false);
+        Array<Note> notesBefore, notesAfter;
+        this->unpackNotes(notesBefore, notesAfter);
+        return sequence->changeGroup(notesBefore, notesAfter, false);
     }
     
     return false;
@@ -407,16 +503,64 @@ bool NotesGroupChangeAction::undo()
     if (PianoSequence *sequence =
         this->source.findSequenceByTrackId<PianoSequence>(this->trackId))
     {
-        return sequence->changeGroup(this->notesAfter, this->notesBefore, false);
+        Array<Note> notesBefore, notesAfter;
+        this->unpackNotes(notesBefore, notesAfter);
+        return sequence->changeGroup(notesAfter, notesBefore, false);
     }
     
     return false;
 }
 
+void NotesGroupChangeAction::packNotes(const Array<Note> &before, const Array<Note> &after)
+{
+    jassert(before.size() == after.size());
+    packNoteParameters(before, this->notesBefore);
+
+    MemoryOutputStream delta(this->notesDelta, false);
+    for (int i = 0; i < this->notesBefore.size(); ++i)
+    {
+        const auto &packedBefore = this->notesBefore.getReference(i);
+        const PackedNote packedAfter(after.getReference(i));
+        jassert(packedBefore.id == packedAfter.id);
+
+        const auto fields = packedBefore.getChangedFields(packedAfter);
+        delta.writeByte(char(fields));
+        if (fields & NoteBeat) { delta.writeFloat(packedAfter.beat); }
+        if (fields & NoteKey) { delta.writeShort(packedAfter.key); }
+        if (fields & NoteLength) { delta.writeFloat(packedAfter.length); }
+        if (fields & NoteVelocity) { delta.writeFloat(packedAfter.velocity); }
+        if (fields & NoteTuplet) { delta.writeByte(char(packedAfter.tuplet)); }
+    }
+
+    delta.flush();
+}
+
 int NotesGroupChangeAction::getSizeInUnits()
 {
-    return (sizeof(Note) * this->notesBefore.size()) +
-        (sizeof(Note) * this->notesAfter.size());
+    return int(sizeof(NotesGroupChangeAction)) +
+        getPackedNotesSize(this->notesBefore) +
+        int(this->notesDelta.getSize());
+}
+
+void NotesGroupChangeAction::unpackNotes(Array<Note> &outBefore, Array<Note> &outAfter) const
+{
+    outBefore.ensureStorageAllocated(this->notesBefore.size());
+    outAfter.ensureStorageAllocated(this->notesBefore.size());
+
+    MemoryInputStream delta(this->notesDelta, false);
+    for (const auto &before : this->notesBefore)
+    {
+        PackedNote after(before);
+        const auto fields = uint8(delta.readByte());
+        if (fields & NoteBeat) { after.beat = delta.readFloat(); }
+        if (fields & NoteKey) { after.key = delta.readShort(); }
+        if (fields & NoteLength) { after.length = delta.readFloat(); }
+        if (fields & NoteVelocity) { after.velocity = delta.readFloat(); }
+        if (fields & NoteTuplet) { after.tuplet = Note::Tuplet(delta.readByte()); }
+
+        outBefore.add(before.unpack());
+        outAfter.add(after.unpack());
+    }
 }
 
 UndoAction *NotesGroupChangeAction::createCoalescedAction(UndoAction *nextAction)
@@ -432,22 +576,27 @@ UndoAction *NotesGroupChangeAction::createCoalescedAction(UndoAction *nextAction
                 return nullptr;
             }
             
-            if (this->notesBefore.size() != nextChanger->notesAfter.size())
+            if (this->notesBefore.size() != nextChanger->notesBefore.size())
             {
                 return nullptr;
             }
             
             for (int i = 0; i < this->notesBefore.size(); ++i)
             {
-                if (this->notesBefore.getUnchecked(i).getId() !=
-                    nextChanger->notesAfter.getUnchecked(i).getId())
+                if (this->notesBefore.getReference(i).id !=
+                    nextChanger->notesBefore.getReference(i).id)
                 {
                     return nullptr;
                 }
             }
             
+            Array<Note> notesBefore, notesAfter, unused;
+            this->unpackNotes(notesBefore, unused);
+            unused.clearQuick();
+            nextChanger->unpackNotes(unused, notesAfter);
+
             return new NotesGroupChangeAction(this->source,
-                this->trackId, this->notesBefore, nextChanger->notesAfter);
+                this->trackId, notesBefore, notesAfter);
         }
     }
 
@@ -466,15 +615,18 @@ ValueTree NotesGroupChangeAction::serialize() const
     
     ValueTree groupBeforeChild(Serialization::Undo::groupBefore);
     ValueTree groupAfterChild(Serialization::Undo::groupAfter);
+
+    Array<Note> notesBefore, notesAfter;
+    this->unpackNotes(notesBefore, notesAfter);
     
-    for (int i = 0; i < this->notesBefore.size(); ++i)
+    for (int i = 0; i < notesBefore.size(); ++i)
     {
-        groupBeforeChild.appendChild(this->notesBefore.getUnchecked(i).serialize(), nullptr);
+        groupBeforeChild.appendChild(notesBefore.getUnchecked(i).serialize(), nullptr);
     }
     
-    for (int i = 0; i < this->notesAfter.size(); ++i)
+    for (int i = 0; i < notesAfter.size(); ++i)
     {
-        groupAfterChild.appendChild(this->notesAfter.getUnchecked(i).serialize(), nullptr);
+        groupAfterChild.appendChild(notesAfter.getUnchecked(i).serialize(), nullptr);
     }
     
     tree.appendChild(groupBeforeChild, nullptr);
@@ -492,24 +644,32 @@ void NotesGroupChangeAction::deserialize(const ValueTree &tree)
     const auto groupBeforeChild = tree.getChildWithName(Serialization::Undo::groupBefore);
     const auto groupAfterChild = tree.getChildWithName(Serialization::Undo::groupAfter);
 
+    Array<Note> notesBefore, notesAfter;
+
     for (const auto &props : groupBeforeChild)
     {
         Note n;
         n.deserialize(props);
-        this->notesBefore.add(n);
+        notesBefore.add(n);
     }
 
     for (const auto &props : groupAfterChild)
     {
         Note n;
         n.deserialize(props);
-        this->notesAfter.add(n);
+        notesAfter.add(n);
+    }
+
+    jassert(notesBefore.size() == notesAfter.size());
+    if (notesBefore.size() == notesAfter.size())
+    {
+        this->packNotes(notesBefore, notesAfter);
     }
 }
 
 void NotesGroupChangeAction::reset()
 {
     this->notesBefore.clear();
-    this->notesAfter.clear();
+    this->notesDelta.reset();
     this->trackId.clear();
 }
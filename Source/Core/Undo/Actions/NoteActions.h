@@ -23,6 +23,32 @@ class MidiTrackSource;
 #include "Note.h"
 #include "UndoAction.h"
 
+//===----------------------------------------------------------------------===//
+// Compact note parameters for group actions
+//===----------------------------------------------------------------------===//
+
+// Group actions may hold thousands of notes for the whole undo history,
+// so they don't store Note copies, each with its vtable and weak reference,
+// but only the plain parameters; the ids are interned, i.e. shared with
+// other actions that refer to the same notes:
+struct PackedNote final
+{
+    PackedNote() = default;
+    explicit PackedNote(const Note &note) noexcept;
+
+    Note unpack() const noexcept;
+
+    // the changed fields mask, see NotesGroupChangeAction
+    uint8 getChangedFields(const PackedNote &other) const noexcept;
+
+    Note::Id id;
+    float beat = 0.f;
+    float length = 0.f;
+    float velocity = 0.f;
+    int16 key = 0;
+    Note::Tuplet tuplet = 1;
+};
+
 //===----------------------------------------------------------------------===//
 // Insert
 //===----------------------------------------------------------------------===//
@@ -141,7 +167,9 @@ public:
 private:
     
     String trackId;
-    Array<Note> notes;
+    Array<PackedNote> notes;
+
+    Array<Note> unpackNotes() const;
     
     JUCE_DECLARE_NON_COPYABLE(NotesGroupInsertAction)
 };
@@ -171,7 +199,9 @@ public:
 private:
     
     String trackId;
-    Array<Note> notes;
+    Array<PackedNote> notes;
+
+    Array<Note> unpackNotes() const;
     
     JUCE_DECLARE_NON_COPYABLE(NotesGroupRemoveAction)
 };
@@ -203,8 +233,14 @@ private:
 
     String trackId;
 
-    Array<Note> notesBefore;
-    Array<Note> notesAfter;
+    // the notes state before the change, and the delta to the state after it:
+    // for each note, the changed fields mask, followed by the changed values,
+    // since most of the edits change one or two fields of all selected notes
+    Array<PackedNote> notesBefore;
+    MemoryBlock notesDelta;
+
+    void packNotes(const Array<Note> &before, const Array<Note> &after);
+    void unpackNotes(Array<Note> &outBefore, Array<Note> &outAfter) const;
 
     JUCE_DECLARE_NON_COPYABLE(NotesGroupChangeAction)
 };
@@ -20,6 +20,7 @@
 #include "MidiTrackSource.h"
 #include "PianoTrackNode.h"
 #include "SerializationKeys.h"
+#include "DocumentHelpers.h"
 
 //===----------------------------------------------------------------------===//
 // Insert
@@ -67,7 +68,8 @@ bool PianoTrackInsertAction::undo()
 
 int PianoTrackInsertAction::getSizeInUnits()
 {
-    return this->trackName.length();
+    return int(sizeof(PianoTrackInsertAction) +
+        DocumentHelpers::estimateSizeInBytes(this->trackState));
 }
 
 ValueTree PianoTrackInsertAction::serialize() const
@@ -107,15 +109,13 @@ PianoTrackRemoveAction::PianoTrackRemoveAction(MidiTrackSource &source,
     const String &trackId) noexcept :
     UndoAction(source),
     parentTreeItem(parentTreeItem),
-    trackId(trackId),
-    numEvents(0) {}
+    trackId(trackId) {}
 
 bool PianoTrackRemoveAction::perform()
 {
     if (PianoTrackNode *treeItem =
         this->source.findTrackById<PianoTrackNode>(this->trackId))
     {
-        this->numEvents = treeItem->getSequence()->size();
         this->serializedTreeItem = treeItem->serialize();
         this->trackName = treeItem->getTrackName();
         return this->parentTreeItem->deleteItem(treeItem, true);
@@ -143,10 +143,11 @@ int PianoTrackRemoveAction::getSizeInUnits()
 {
     if (this->serializedTreeItem.isValid())
     {
-        return (this->numEvents * sizeof(MidiEvent));
+        return int(sizeof(PianoTrackRemoveAction) +
+            DocumentHelpers::estimateSizeInBytes(this->serializedTreeItem));
     }
     
-    return 1;
+    return int(sizeof(PianoTrackRemoveAction));
 }
 
 ValueTree PianoTrackRemoveAction::serialize() const
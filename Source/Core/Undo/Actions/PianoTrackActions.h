@@ -87,7 +87,6 @@ private:
     WeakReference<TreeNode> parentTreeItem;
 
     String trackId;
-    int numEvents = 0;
     
     ValueTree serializedTreeItem;
     String trackName;
@@ -30,6 +30,8 @@ public:
     virtual bool perform() = 0;
     virtual bool undo() = 0;
 
+    // The approximate number of bytes this action holds in memory,
+    // used by the undo stack to fit the history into its memory budget
     virtual int getSizeInUnits()
     {
         return 10;
@@ -37,8 +37,10 @@ UndoStack::ActionSet::ActionSet(ProjectNode &project, const String &transactionN
     project(project),
     name(transactionName) {}
     
-bool UndoStack::ActionSet::perform() const
+bool UndoStack::ActionSet::perform()
 {
+    this->loadActionsIfNeeded();
+    this->resetSerializationCache(); // some actions update their state here
     for (int i = 0; i < this->actions.size(); ++i)
     {
         if (!this->actions.getUnchecked(i)->perform())
@@ -50,8 +52,10 @@ bool UndoStack::ActionSet::perform() const
     return true;
 }
     
-bool UndoStack::ActionSet::undo() const
+bool UndoStack::ActionSet::undo()
 {
+    this->loadActionsIfNeeded();
+    this->resetSerializationCache(); // some actions update their state here
     for (int i = this->actions.size(); --i >= 0;)
     {
         if (!this->actions.getUnchecked(i)->undo())
@@ -65,6 +69,11 @@ bool UndoStack::ActionSet::undo() const
     
 int UndoStack::ActionSet::getTotalSize() const
 {
+    if (this->hasPendingActions)
+    {
+        return this->serializedActions.getProperty(Serialization::Undo::transactionSize, 0);
+    }
+
     int total = 0;
     for (int i = this->actions.size(); --i >= 0;)
     {
@@ -76,13 +85,22 @@ int UndoStack::ActionSet::getTotalSize() const
     
 ValueTree UndoStack::ActionSet::serialize() const
 {
+    if (this->serializedActions.isValid())
+    {
+        // a tree cannot have two parents, e.g. when the previous save still holds it
+        return this->serializedActions.getParent().isValid() ?
+            this->serializedActions.createCopy() : this->serializedActions;
+    }
+
     ValueTree tree(Serialization::Undo::transaction);
+    tree.setProperty(Serialization::Undo::transactionSize, this->getTotalSize(), nullptr);
 
     for (int i = 0; i < this->actions.size(); ++i)
     {
         tree.appendChild(this->actions.getUnchecked(i)->serialize(), nullptr);
     }
-        
+
+    this->serializedActions = tree;
     return tree;
 }
     
@@ -90,7 +108,27 @@ void UndoStack::ActionSet::deserialize(const ValueTree &tree)
 {
     this->reset();
 
-    for (const auto &childAction : tree)
+    this->serializedActions = tree;
+    this->hasPendingActions = true;
+
+    // the legacy files don't have the transaction size stored,
+    // so the actions have to be created right away to count it
+    if (!tree.hasProperty(Serialization::Undo::transactionSize))
+    {
+        this->loadActionsIfNeeded();
+    }
+}
+
+void UndoStack::ActionSet::loadActionsIfNeeded()
+{
+    if (!this->hasPendingActions)
+    {
+        return;
+    }
+
+    this->hasPendingActions = false;
+
+    for (const auto &childAction : this->serializedActions)
     {
         if (auto *action = createUndoActionsByTagName(childAction.getType()))
         {
@@ -99,10 +137,17 @@ void UndoStack::ActionSet::deserialize(const ValueTree &tree)
         }
     }
 }
+
+void UndoStack::ActionSet::resetSerializationCache() noexcept
+{
+    this->serializedActions = {};
+}
     
 void UndoStack::ActionSet::reset()
 {
     this->actions.clear();
+    this->serializedActions = {};
+    this->hasPendingActions = false;
 }
 
 UndoAction *UndoStack::ActionSet::createUndoActionsByTagName(const Identifier &tagName)
@@ -158,20 +203,20 @@ UndoAction *UndoStack::ActionSet::createUndoActionsByTagName(const Identifier &t
 }
 
 UndoStack::UndoStack(ProjectNode &parentProject,
-    int maxNumberOfUnitsToKeep,
-    int minimumTransactions) :
+    int64 maxNumberOfBytesToKeep,
+    int maxNumberOfTransactionsToKeep) :
     project(parentProject),
-    totalUnitsStored(0),
+    totalBytesStored(0),
+    maxNumBytesToKeep(maxNumberOfBytesToKeep),
+    maxNumTransactionsToKeep(maxNumberOfTransactionsToKeep),
     nextIndex(0),
     newTransaction(true),
-    reentrancyCheck(false),
-    maxNumUnitsToKeep(maxNumberOfUnitsToKeep),
-    minimumTransactionsToKeep(minimumTransactions) {}
+    reentrancyCheck(false) {}
 
 void UndoStack::clearUndoHistory()
 {
     this->transactions.clear();
-    this->totalUnitsStored = 0;
+    this->totalBytesStored = 0;
     this->nextIndex = 0;
     this->sendChangeMessage();
 }
@@ -210,6 +255,7 @@ bool UndoStack::perform(UndoAction *const newAction)
             
             if (actionSet != nullptr && !this->newTransaction)
             {
+                actionSet->loadActionsIfNeeded();
                 for (signed int i = (actionSet->actions.size() - 1); i >= 0; --i)
                 {
                     if (auto *lastAction = actionSet->actions[i])
@@ -217,7 +263,7 @@ bool UndoStack::perform(UndoAction *const newAction)
                         if (auto *coalescedAction = lastAction->createCoalescedAction(action.get()))
                         {
                             action.reset(coalescedAction);
-                            this->totalUnitsStored -= lastAction->getSizeInUnits();
+                            this->totalBytesStored -= lastAction->getSizeInUnits();
                             actionSet->actions.remove(i);
                             break;
                         }
@@ -231,8 +277,9 @@ bool UndoStack::perform(UndoAction *const newAction)
                 ++nextIndex;
             }
             
-            this->totalUnitsStored += action->getSizeInUnits();
+            this->totalBytesStored += action->getSizeInUnits();
             actionSet->actions.add(action.release());
+            actionSet->resetSerializationCache();
             this->newTransaction = false;
             
             this->clearFutureTransactions();
@@ -248,21 +295,23 @@ void UndoStack::clearFutureTransactions()
 {
     while (this->nextIndex < this->transactions.size())
     {
-        this->totalUnitsStored -= transactions.getLast()->getTotalSize();
+        this->totalBytesStored -= transactions.getLast()->getTotalSize();
         this->transactions.removeLast();
     }
     
-    while (this->nextIndex > 0
-           && this->totalUnitsStored > this->maxNumUnitsToKeep
-           && this->transactions.size() > this->minimumTransactionsToKeep)
+    // the byte count is only an estimate, so the number
+    // of transactions is also limited, just in case:
+    while (this->nextIndex > 1
+           && (this->totalBytesStored > this->maxNumBytesToKeep
+               || this->transactions.size() > this->maxNumTransactionsToKeep))
     {
-        this->totalUnitsStored -= this->transactions.getFirst()->getTotalSize();
+        this->totalBytesStored -= this->transactions.getFirst()->getTotalSize();
         this->transactions.remove(0);
         --this->nextIndex;
         
         // if this fails, then some actions may not be returning
         // consistent results from their getSizeInUnits() method
-        jassert(this->totalUnitsStored >= 0);
+        jassert(this->totalBytesStored >= 0);
     }
 }
 
@@ -311,7 +360,7 @@ bool UndoStack::canRedo() const noexcept
 
 bool UndoStack::undo()
 {
-    if (const auto *s = this->getCurrentSet())
+    if (auto *s = this->getCurrentSet())
     {
         const ScopedValueSetter<bool> setter(this->reentrancyCheck, true);
         
@@ -334,7 +383,7 @@ bool UndoStack::undo()
 
 bool UndoStack::redo()
 {
-    if (const auto *s = this->getNextSet())
+    if (auto *s = this->getNextSet())
     {
         const ScopedValueSetter<bool> setter(this->reentrancyCheck, true);
         
@@ -384,8 +433,9 @@ void UndoStack::getActionsInCurrentTransaction(Array<const UndoAction *> &action
 {
     if (!this->newTransaction)
     {
-        if (const auto *s = this->getCurrentSet())
+        if (auto *s = this->getCurrentSet())
         {
+            s->loadActionsIfNeeded();
             for (int i = 0; i < s->actions.size(); ++i)
             {
                 actionsFound.add(s->actions.getUnchecked(i));
@@ -398,8 +448,9 @@ int UndoStack::getNumActionsInCurrentTransaction() const
 {
     if (!this->newTransaction)
     {
-        if (const auto *s = this->getCurrentSet())
+        if (auto *s = this->getCurrentSet())
         {
+            s->loadActionsIfNeeded();
             return s->actions.size();
         }
     }
@@ -447,6 +498,7 @@ void UndoStack::deserialize(const ValueTree &tree)
     {
         auto actionSet = new ActionSet(this->project, {});
         actionSet->deserialize(childTransaction);
+        this->totalBytesStored += actionSet->getTotalSize();
         this->transactions.insert(this->nextIndex, actionSet);
         ++this->nextIndex;
     }
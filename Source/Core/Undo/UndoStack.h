@@ -25,9 +25,12 @@ class UndoStack final : public ChangeBroadcaster, public Serializable
 {
 public:
 
+    // The oldest transactions are dropped when the history exceeds the memory budget,
+    // as reported by getSizeInUnits() of the actions, or the transactions limit,
+    // except for the current one
     explicit UndoStack(ProjectNode &parentProject,
-        int maxNumberOfUnitsToKeep = 30000,
-        int minimumTransactionsToKeep = 30);
+        int64 maxNumberOfBytesToKeep = 64 * 1024 * 1024,
+        int maxNumberOfTransactionsToKeep = 1000);
     
     void clearUndoHistory();
 
@@ -75,8 +78,8 @@ private:
     {
         ActionSet(ProjectNode &project, const String &transactionName);
 
-        bool perform() const;
-        bool undo() const;
+        bool perform();
+        bool undo();
         int getTotalSize() const;
 
         ValueTree serialize() const;
@@ -89,12 +92,21 @@ private:
         String name;
 
         ProjectNode &project;
+
+        // the transaction keeps its serialized tree until its actions change,
+        // so that saving a project doesn't re-serialize the stored history;
+        // the loaded transactions only create their actions when needed
+        void loadActionsIfNeeded();
+        void resetSerializationCache() noexcept;
+        mutable ValueTree serializedActions;
+        bool hasPendingActions = false;
     };
     
     OwnedArray<ActionSet> transactions;
     String newTransactionName;
     
-    int totalUnitsStored, maxNumUnitsToKeep, minimumTransactionsToKeep, nextIndex;
+    int64 totalBytesStored, maxNumBytesToKeep;
+    int maxNumTransactionsToKeep, nextIndex;
     bool newTransaction, reentrancyCheck;
     
     ActionSet *getCurrentSet() const noexcept;
@@ -105,6 +117,7 @@ private:
     {
         if (s != nullptr)
         {
+            s->loadActionsIfNeeded();
             for (int i = 0; i < s->actions.size(); ++i)
             {
                 if (dynamic_cast<T *>(s->actions.getUnchecked(i)))
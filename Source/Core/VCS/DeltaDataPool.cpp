@@ -0,0 +1,119 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "DeltaDataPool.h"
+
+namespace VCS
+{
+
+// 64-bit FNV-1a over the binary representation of the data;
+// no cryptographic hash is needed here, since the collisions
+// are resolved by comparing the data itself (see addData)
+static uint64 getDeltaDataHash(const MemoryBlock &bytes) noexcept
+{
+    uint64 hash = 14695981039346656037ull;
+    const auto *data = static_cast<const uint8 *>(bytes.getData());
+    for (size_t i = 0; i < bytes.getSize(); ++i)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+String DeltaDataPool::addData(const ValueTree &data)
+{
+    MemoryOutputStream stream;
+    data.writeToStream(stream);
+    const auto &bytes = stream.getMemoryBlock();
+
+    const String baseKey = String::toHexString(int64(getDeltaDataHash(bytes))) +
+        "-" + String::toHexString(int64(bytes.getSize()));
+
+    String key = baseKey;
+    for (int collision = 1; this->blobs.contains(key); ++collision)
+    {
+        if (this->blobs.at(key).isEquivalentTo(data))
+        {
+            return key;
+        }
+
+        key = baseKey + "-" + String(collision);
+    }
+
+    this->blobs[key] = data;
+    this->keys.add(key);
+    return key;
+}
+
+const DeltaDataLookup &DeltaDataPool::getLookup() const noexcept
+{
+    return this->blobs;
+}
+
+//===----------------------------------------------------------------------===//
+// Serializable
+//===----------------------------------------------------------------------===//
+
+ValueTree DeltaDataPool::serialize() const
+{
+    ValueTree tree(Serialization::VCS::deltaPool);
+
+    for (const auto &key : this->keys)
+    {
+        const auto data = this->blobs.at(key);
+
+        ValueTree blobNode(Serialization::VCS::deltaPoolItem);
+        blobNode.setProperty(Serialization::VCS::deltaPoolItemKey, key, nullptr);
+        blobNode.appendChild(data.getParent().isValid() ? data.createCopy() : data, nullptr);
+        tree.appendChild(blobNode, nullptr);
+    }
+
+    return tree;
+}
+
+void DeltaDataPool::deserialize(const ValueTree &tree)
+{
+    this->reset();
+
+    const auto root = tree.hasType(Serialization::VCS::deltaPool) ?
+        tree : tree.getChildWithName(Serialization::VCS::deltaPool);
+
+    if (!root.isValid()) { return; }
+
+    this->blobs.reserve(root.getNumChildren());
+
+    forEachValueTreeChildWithType(root, e, Serialization::VCS::deltaPoolItem)
+    {
+        const String key = e.getProperty(Serialization::VCS::deltaPoolItemKey);
+        jassert(e.getNumChildren() == 1);
+        const auto data(e.getChild(0));
+        jassert(data.isValid());
+        this->blobs[key] = data;
+        this->keys.add(key);
+    }
+}
+
+void DeltaDataPool::reset()
+{
+    this->blobs.clear();
+    this->keys.clearQuick();
+}
+
+}
@@ -0,0 +1,64 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Serializable.h"
+#include "Delta.h"
+
+namespace VCS
+{
+    /*
+        A content-addressed storage for deltas data, used on saving and loading.
+
+        Many revision items, e.g. the ones in stashes, or in the head snapshot,
+        or in the revisions that were amended back and forth, refer to the data
+        which is the same byte to byte; each unique piece of data is written once,
+        and the deltas only keep its key, so that on loading all of them share
+        the same ValueTree instance.
+    */
+
+    class DeltaDataPool final : public Serializable
+    {
+    public:
+
+        DeltaDataPool() = default;
+
+        // returns the key of the data, only adding it,
+        // if there's no identical data in the pool yet
+        String addData(const ValueTree &data);
+
+        const DeltaDataLookup &getLookup() const noexcept;
+
+        //===--------------------------------------------------------------===//
+        // Serializable
+        //===--------------------------------------------------------------===//
+
+        ValueTree serialize() const override;
+        void deserialize(const ValueTree &tree) override;
+        void reset() override;
+
+    private:
+
+        DeltaDataLookup blobs;
+
+        // the order in which the blobs were added, to keep the output stable
+        StringArray keys;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeltaDataPool)
+    };
+} // namespace VCS
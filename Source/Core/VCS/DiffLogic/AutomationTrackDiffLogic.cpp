@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "AutomationTrackDiffLogic.h"
+#include "DiffHelpers.h"
 #include "AutomationTrackNode.h"
 #include "PatternDiffHelpers.h"
 #include "AutomationEvent.h"
@@ -351,25 +352,16 @@ ValueTree mergeAutoEventsAdded(const ValueTree &state, const ValueTree &changes)
     result.addArray(stateNotes);
 
     // на всякий пожарный, ищем, нет ли в состоянии нот с теми же id, где нет - добавляем
+    const auto stateIDs = DiffHelpers::createIdIndex(stateNotes);
+
     for (int i = 0; i < changesNotes.size(); ++i)
     {
-        bool foundNoteInState = false;
-        const AutomationEvent *changesNote = static_cast<AutomationEvent *>(changesNotes.getUnchecked(i));
-
-        for (int j = 0; j < stateNotes.size(); ++j)
-        {
-            const AutomationEvent *stateNote = static_cast<AutomationEvent *>(stateNotes.getUnchecked(j));
-
-            if (stateNote->getId() == changesNote->getId())
-            {
-                foundNoteInState = true;
-                break;
-            }
-        }
+        const bool foundNoteInState =
+            DiffHelpers::findIndexById(stateIDs, changesNotes, i) >= 0;
 
         if (! foundNoteInState)
         {
-            result.add(changesNote);
+            result.add(changesNotes.getUnchecked(i));
         }
     }
 
@@ -387,25 +379,16 @@ ValueTree mergeAutoEventsRemoved(const ValueTree &state, const ValueTree &change
     Array<const MidiEvent *> result;
 
     // добавляем все ноты из состояния, которых нет в изменениях
+    const auto changesIDs = DiffHelpers::createIdIndex(changesNotes);
+
     for (int i = 0; i < stateNotes.size(); ++i)
     {
-        bool foundNoteInChanges = false;
-        const AutomationEvent *stateNote = static_cast<AutomationEvent *>(stateNotes.getUnchecked(i));
-
-        for (int j = 0; j < changesNotes.size(); ++j)
-        {
-            const AutomationEvent *changesNote = static_cast<AutomationEvent *>(changesNotes.getUnchecked(j));
-
-            if (stateNote->getId() == changesNote->getId())
-            {
-                foundNoteInChanges = true;
-                break;
-            }
-        }
+        const bool foundNoteInChanges =
+            DiffHelpers::findIndexById(changesIDs, stateNotes, i) >= 0;
 
         if (! foundNoteInChanges)
         {
-            result.add(stateNote);
+            result.add(stateNotes.getUnchecked(i));
         }
     }
 
@@ -421,29 +404,24 @@ ValueTree mergeAutoEventsChanged(const ValueTree &state, const ValueTree &change
     deserializeAutoTrackChanges(state, changes, stateNotes, changesNotes);
 
     Array<const MidiEvent *> result;
-    result.addArray(stateNotes);
 
-    // снова ищем по id и заменяем
+    // снова ищем по id и заменяем, на месте, без поиска по результату
+    const auto changesIDs = DiffHelpers::createIdIndex(changesNotes);
+    Array<bool> changesUsed;
+    changesUsed.insertMultiple(0, false, changesNotes.size());
+
     for (int i = 0; i < stateNotes.size(); ++i)
     {
-        bool foundNoteInChanges = false;
-        const AutomationEvent *stateNote = static_cast<AutomationEvent *>(stateNotes.getUnchecked(i));
-
-        for (int j = 0; j < changesNotes.size(); ++j)
+        const int j = DiffHelpers::findIndexById(changesIDs, stateNotes, i);
+        if (j < 0)
         {
-            const AutomationEvent *changesNote = static_cast<AutomationEvent *>(changesNotes.getUnchecked(j));
-
-            if (stateNote->getId() == changesNote->getId())
-            {
-                foundNoteInChanges = true;
-                result.removeAllInstancesOf(stateNote);
-                result.addIfNotAlreadyThere(changesNote);
-
-                break;
-            }
+            result.add(stateNotes.getUnchecked(i));
+        }
+        else if (! changesUsed[j])
+        {
+            changesUsed.set(j, true);
+            result.add(changesNotes.getUnchecked(j));
         }
-
-        //jassert(foundNoteInChanges);
     }
 
     return serializeAutoSequence(result, AutoSequenceDeltas::eventsAdded);
@@ -510,63 +488,32 @@ Array<DeltaDiff> createAutoEventsDiffs(const ValueTree &state, const ValueTree &
     Array<const MidiEvent *> changedEvents;
 
     // собственно, само сравнение
-    for (int i = 0; i < stateEvents.size(); ++i)
-    {
-        bool foundNoteInChanges = false;
-        const AutomationEvent *stateEvent = static_cast<AutomationEvent *>(stateEvents.getUnchecked(i));
-
-        for (int j = 0; j < changesEvents.size(); ++j)
+    DiffHelpers::joinById(stateEvents, changesEvents,
+        [&](int i, int j)
         {
-            const AutomationEvent *changesEvent = static_cast<AutomationEvent *>(changesEvents.getUnchecked(j));
-
             // нота из состояния - существует в изменениях. добавляем запись changed, если нужно.
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundNoteInChanges = true;
-
-                const bool eventHasChanged = (stateEvent->getBeat() != changesEvent->getBeat() ||
-                                              stateEvent->getCurvature() != changesEvent->getCurvature() ||
-                                              stateEvent->getControllerValue() != changesEvent->getControllerValue());
-
-                if (eventHasChanged)
-                {
-                    changedEvents.add(changesEvent);
-                }
-
-                break;
-            }
-        }
-
-        // нота из состояния - в изменениях не найдена. добавляем запись removed.
-        if (! foundNoteInChanges)
-        {
-            removedEvents.add(stateEvent);
-        }
-    }
-
-    // теперь ищем в изменениях ноты, которые отсутствуют в состоянии
-    for (int i = 0; i < changesEvents.size(); ++i)
-    {
-        bool foundNoteInState = false;
-        const AutomationEvent *changesNote = static_cast<AutomationEvent *>(changesEvents.getUnchecked(i));
+            const AutomationEvent *stateEvent = static_cast<AutomationEvent *>(stateEvents.getUnchecked(i));
+            const AutomationEvent *changesEvent = static_cast<AutomationEvent *>(changesEvents.getUnchecked(j));
 
-        for (int j = 0; j < stateEvents.size(); ++j)
-        {
-            const AutomationEvent *stateNote = static_cast<AutomationEvent *>(stateEvents.getUnchecked(j));
+            const bool eventHasChanged = (stateEvent->getBeat() != changesEvent->getBeat() ||
+                                          stateEvent->getCurvature() != changesEvent->getCurvature() ||
+                                          stateEvent->getControllerValue() != changesEvent->getControllerValue());
 
-            if (stateNote->getId() == changesNote->getId())
+            if (eventHasChanged)
             {
-                foundNoteInState = true;
-                break;
+                changedEvents.add(changesEvent);
             }
-        }
-
-        // и пишем ее в список добавленных
-        if (! foundNoteInState)
+        },
+        [&](int i)
         {
-            addedEvents.add(changesNote);
-        }
-    }
+            // нота из состояния - в изменениях не найдена. добавляем запись removed.
+            removedEvents.add(stateEvents.getUnchecked(i));
+        },
+        [&](int j)
+        {
+            // нота из изменений отсутствует в состоянии, пишем ее в список добавленных
+            addedEvents.add(changesEvents.getUnchecked(j));
+        });
 
     // сериализуем диффы, если таковые есть
 
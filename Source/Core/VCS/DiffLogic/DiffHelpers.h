@@ -0,0 +1,113 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+namespace VCS
+{
+    /*
+        The id-hashed join used by all diff logics and pattern diff helpers:
+        each side is indexed by item id once, so that finding the added,
+        removed and changed items takes O(n + m) instead of comparing
+        every item in the state against every item in the changes.
+
+        Works for both Array<Clip>-like arrays of values,
+        and OwnedArray<Note>-like arrays of pointers.
+    */
+
+    class DiffHelpers final
+    {
+    public:
+
+        // id : the index of the first item with that id
+        using IdIndex = FlatHashMap<String, int, StringHash>;
+
+        template <typename ArrayType>
+        static IdIndex createIdIndex(const ArrayType &items)
+        {
+            IdIndex index;
+            index.reserve(items.size());
+
+            for (int i = 0; i < items.size(); ++i)
+            {
+                // emplace keeps the first one for duplicate ids,
+                // just like the linear searches used to do
+                index.emplace(getItemId(items, i), i);
+            }
+
+            return index;
+        }
+
+        template <typename ArrayType>
+        static int findIndexById(const IdIndex &index, const ArrayType &items, int i)
+        {
+            const auto found = index.find(getItemId(items, i));
+            return (found != index.end()) ? found->second : -1;
+        }
+
+        /*
+            Calls onMatched(stateIndex, changesIndex) for every state item found in changes,
+            onRemoved(stateIndex) for every state item missing in changes (both in state order),
+            and then onAdded(changesIndex) for every changes item missing in state (in changes order),
+            so that the resulting deltas are ordered the same way the nested loops produced them.
+        */
+
+        template <typename ArrayType, typename MatchedFn, typename RemovedFn, typename AddedFn>
+        static void joinById(const ArrayType &state, const ArrayType &changes,
+            MatchedFn onMatched, RemovedFn onRemoved, AddedFn onAdded)
+        {
+            const auto stateIndex = createIdIndex(state);
+            const auto changesIndex = createIdIndex(changes);
+
+            for (int i = 0; i < state.size(); ++i)
+            {
+                const int j = findIndexById(changesIndex, state, i);
+                if (j >= 0)
+                {
+                    onMatched(i, j);
+                }
+                else
+                {
+                    onRemoved(i);
+                }
+            }
+
+            for (int j = 0; j < changes.size(); ++j)
+            {
+                if (findIndexById(stateIndex, changes, j) < 0)
+                {
+                    onAdded(j);
+                }
+            }
+        }
+
+    private:
+
+        template <typename T>
+        static inline String getItemId(const Array<T> &items, int i)
+        {
+            return items.getReference(i).getId();
+        }
+
+        template <typename T>
+        static inline String getItemId(const OwnedArray<T> &items, int i)
+        {
+            return items.getUnchecked(i)->getId();
+        }
+
+    };
+} // namespace VCS
@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "PatternDiffHelpers.h"
+#include "DiffHelpers.h"
 #include "Clip.h"
 #include "Pattern.h"
 #include "SerializationKeys.h"
@@ -88,21 +89,16 @@ ValueTree PatternDiffHelpers::mergeClipsAdded(const ValueTree &state, const Valu
     Array<Clip> result;
     result.addArray(stateClips);
 
-    HashMap<Clip::Id, int> stateIDs;
-
-    for (int j = 0; j < stateClips.size(); ++j)
-    {
-        stateIDs.set(stateClips.getUnchecked(j).getId(), j);
-    }
+    const auto stateIDs = DiffHelpers::createIdIndex(stateClips);
 
     for (int i = 0; i < changesClips.size(); ++i)
     {
-        const Clip changesClip(changesClips.getUnchecked(i));
-        bool foundInState = stateIDs.contains(changesClip.getId());
+        const bool foundInState =
+            DiffHelpers::findIndexById(stateIDs, changesClips, i) >= 0;
 
         if (!foundInState)
         {
-            result.add(changesClip);
+            result.add(changesClips.getUnchecked(i));
         }
     }
 
@@ -118,21 +114,16 @@ ValueTree PatternDiffHelpers::mergeClipsRemoved(const ValueTree &state, const Va
     deserializePatternChanges(state, changes, stateClips, changesClips);
 
     Array<Clip> result;
-    HashMap<Clip::Id, int> changesIDs;
-
-    for (int j = 0; j < changesClips.size(); ++j)
-    {
-        changesIDs.set(changesClips.getUnchecked(j).getId(), j);
-    }
+    const auto changesIDs = DiffHelpers::createIdIndex(changesClips);
 
     for (int i = 0; i < stateClips.size(); ++i)
     {
-        const Clip stateClip(stateClips.getUnchecked(i));
-        bool foundInChanges = changesIDs.contains(stateClip.getId());
+        const bool foundInChanges =
+            DiffHelpers::findIndexById(changesIDs, stateClips, i) >= 0;
 
         if (!foundInChanges)
         {
-            result.add(stateClip);
+            result.add(stateClips.getUnchecked(i));
         }
     }
 
@@ -148,25 +139,22 @@ ValueTree PatternDiffHelpers::mergeClipsChanged(const ValueTree &state, const Va
     deserializePatternChanges(state, changes, stateClips, changesClips);
 
     Array<Clip> result;
-    result.addArray(stateClips);
 
-    HashMap<Clip::Id, Clip> changesIDs;
-
-    for (int j = 0; j < changesClips.size(); ++j)
-    {
-        const Clip changesClip(changesClips.getUnchecked(j));
-        changesIDs.set(changesClip.getId(), changesClip);
-    }
+    const auto changesIDs = DiffHelpers::createIdIndex(changesClips);
+    Array<bool> changesUsed;
+    changesUsed.insertMultiple(0, false, changesClips.size());
 
     for (int i = 0; i < stateClips.size(); ++i)
     {
-        const Clip stateClip(stateClips.getUnchecked(i));
-
-        if (changesIDs.contains(stateClip.getId()))
+        const int j = DiffHelpers::findIndexById(changesIDs, stateClips, i);
+        if (j < 0)
+        {
+            result.add(stateClips.getUnchecked(i));
+        }
+        else if (!changesUsed[j])
         {
-            const Clip changesClip = changesIDs[stateClip.getId()];
-            result.removeAllInstancesOf(stateClip);
-            result.addIfNotAlreadyThere(changesClip);
+            changesUsed.set(j, true);
+            result.add(changesClips.getUnchecked(j));
         }
     }
 
@@ -188,57 +176,29 @@ Array<VCS::DeltaDiff> PatternDiffHelpers::createClipsDiffs(const ValueTree &stat
     Array<Clip> removedClips;
     Array<Clip> changedClips;
 
-    for (int i = 0; i < stateClips.size(); ++i)
-    {
-        bool foundInChanges = false;
-        const Clip stateClip(stateClips.getUnchecked(i));
-
-        for (int j = 0; j < changesClips.size(); ++j)
+    DiffHelpers::joinById(stateClips, changesClips,
+        [&](int i, int j)
         {
-            const Clip changesClip(changesClips.getUnchecked(j));
-
-            if (stateClip.getId() == changesClip.getId())
+            const Clip &stateClip = stateClips.getReference(i);
+            const Clip &changesClip = changesClips.getReference(j);
+
+            if (stateClip.getKey() != changesClip.getKey() ||
+                stateClip.getBeat() != changesClip.getBeat() ||
+                stateClip.getVelocity() != changesClip.getVelocity() ||
+                stateClip.isMuted() != changesClip.isMuted() ||
+                stateClip.isSoloed() != changesClip.isSoloed())
             {
-                foundInChanges = true;
-                if (stateClip.getKey() != changesClip.getKey() ||
-                    stateClip.getBeat() != changesClip.getBeat() ||
-                    stateClip.getVelocity() != changesClip.getVelocity() ||
-                    stateClip.isMuted() != changesClip.isMuted() ||
-                    stateClip.isSoloed() != changesClip.isSoloed())
-                {
-                    changedClips.add(changesClip);
-                }
-
-                break;
+                changedClips.add(changesClip);
             }
-        }
-
-        if (!foundInChanges)
+        },
+        [&](int i)
         {
-            removedClips.add(stateClip);
-        }
-    }
-
-    for (int i = 0; i < changesClips.size(); ++i)
-    {
-        bool foundInState = false;
-        const Clip changesClip(changesClips.getUnchecked(i));
-
-        for (int j = 0; j < stateClips.size(); ++j)
+            removedClips.add(stateClips.getUnchecked(i));
+        },
+        [&](int j)
         {
-            const Clip stateClip(stateClips.getUnchecked(j));
-            if (stateClip.getId() == changesClip.getId())
-            {
-                foundInState = true;
-                break;
-            }
-        }
-
-        if (!foundInState)
-        {
-            addedClips.add(changesClip);
-        }
-    }
+            addedClips.add(changesClips.getUnchecked(j));
+        });
 
     if (addedClips.size() > 0)
     {
@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "PianoTrackDiffLogic.h"
+#include "DiffHelpers.h"
 #include "PianoTrackNode.h"
 #include "PatternDiffHelpers.h"
 #include "Note.h"
@@ -330,22 +331,16 @@ ValueTree mergeNotesAdded(const ValueTree &state, const ValueTree &changes)
     result.addArray(stateNotes);
 
     // на всякий пожарный, ищем, нет ли в состоянии нот с теми же id, где нет - добавляем
-    HashMap<MidiEvent::Id, int> stateIDs;
-    
-    for (int j = 0; j < stateNotes.size(); ++j)
-    {
-        const Note *stateNote = stateNotes.getUnchecked(j);
-        stateIDs.set(stateNote->getId(), j);
-    }
+    const auto stateIDs = DiffHelpers::createIdIndex(stateNotes);
 
     for (int i = 0; i < changesNotes.size(); ++i)
     {
-        const Note *changesNote = changesNotes.getUnchecked(i);
-        bool foundNoteInState = stateIDs.contains(changesNote->getId());
+        const bool foundNoteInState =
+            DiffHelpers::findIndexById(stateIDs, changesNotes, i) >= 0;
 
         if (! foundNoteInState)
         {
-            result.add(changesNote);
+            result.add(changesNotes.getUnchecked(i));
         }
     }
 
@@ -363,21 +358,16 @@ ValueTree mergeNotesRemoved(const ValueTree &state, const ValueTree &changes)
     Array<const MidiEvent *> result;
 
     // добавляем все ноты из состояния, которых нет в изменениях
-    HashMap<MidiEvent::Id, int> changesIDs;
+    const auto changesIDs = DiffHelpers::createIdIndex(changesNotes);
 
-    for (int j = 0; j < changesNotes.size(); ++j)
-    {
-        const Note *changesNote = changesNotes.getUnchecked(j);
-        changesIDs.set(changesNote->getId(), j);
-    }
-    
     for (int i = 0; i < stateNotes.size(); ++i)
     {
-        const Note *stateNote =stateNotes.getUnchecked(i);
-        const bool foundNoteInChanges = changesIDs.contains(stateNote->getId());
+        const bool foundNoteInChanges =
+            DiffHelpers::findIndexById(changesIDs, stateNotes, i) >= 0;
+
         if (! foundNoteInChanges)
         {
-            result.add(stateNote);
+            result.add(stateNotes.getUnchecked(i));
         }
     }
 
@@ -394,25 +384,22 @@ ValueTree mergeNotesChanged(const ValueTree &state, const ValueTree &changes)
 
     Array<const MidiEvent *> result;
 
-    result.addArray(stateNotes);
-
-    // снова ищем по id и заменяем
-    HashMap<MidiEvent::Id, const Note *> changesIDs;
-    
-    for (int j = 0; j < changesNotes.size(); ++j)
-    {
-        const Note *changesNote = changesNotes.getUnchecked(j);
-        changesIDs.set(changesNote->getId(), changesNote);
-    }
+    // снова ищем по id и заменяем, на месте, без поиска по результату
+    const auto changesIDs = DiffHelpers::createIdIndex(changesNotes);
+    Array<bool> changesUsed;
+    changesUsed.insertMultiple(0, false, changesNotes.size());
 
     for (int i = 0; i < stateNotes.size(); ++i)
     {
-        const Note *stateNote = stateNotes.getUnchecked(i);
-        if (changesIDs.contains(stateNote->getId()))
+        const int j = DiffHelpers::findIndexById(changesIDs, stateNotes, i);
+        if (j < 0)
+        {
+            result.add(stateNotes.getUnchecked(i));
+        }
+        else if (! changesUsed[j])
         {
-            const Note *changesNote = changesIDs[stateNote->getId()];
-            result.removeAllInstancesOf(stateNote);
-            result.addIfNotAlreadyThere(changesNote);
+            changesUsed.set(j, true);
+            result.add(changesNotes.getUnchecked(j));
         }
     }
 
@@ -475,66 +462,35 @@ Array<DeltaDiff> createEventsDiffs(const ValueTree &state, const ValueTree &chan
     Array<const MidiEvent *> changedNotes;
 
     // собственно, само сравнение
-    for (int i = 0; i < stateNotes.size(); ++i)
-    {
-        bool foundNoteInChanges = false;
-        const Note *stateNote(stateNotes.getUnchecked(i));
-
-        for (int j = 0; j < changesNotes.size(); ++j)
+    DiffHelpers::joinById(stateNotes, changesNotes,
+        [&](int i, int j)
         {
-            const Note *changesNote = changesNotes.getUnchecked(j);
-
             // нота из состояния - существует в изменениях. добавляем запись changed, если нужно.
-            if (stateNote->getId() == changesNote->getId())
-            {
-                foundNoteInChanges = true;
-
-                const bool noteHasChanged =
-                    stateNote->getKey() != changesNote->getKey() ||
-                    stateNote->getBeat() != changesNote->getBeat() ||
-                    stateNote->getLength() != changesNote->getLength() ||
-                    stateNote->getVelocity() != changesNote->getVelocity() ||
-                    stateNote->getTuplet() != changesNote->getTuplet();
-
-                if (noteHasChanged)
-                {
-                    changedNotes.add(changesNote);
-                }
-
-                break;
-            }
-        }
-
-        // нота из состояния - в изменениях не найдена. добавляем запись removed.
-        if (! foundNoteInChanges)
-        {
-            removedNotes.add(stateNote);
-        }
-    }
-
-    // теперь ищем в изменениях ноты, которые отсутствуют в состоянии
-    for (int i = 0; i < changesNotes.size(); ++i)
-    {
-        bool foundNoteInState = false;
-        const Note *changesNote = changesNotes.getUnchecked(i);
+            const Note *stateNote = stateNotes.getUnchecked(i);
+            const Note *changesNote = changesNotes.getUnchecked(j);
 
-        for (int j = 0; j < stateNotes.size(); ++j)
-        {
-            const Note *stateNote(stateNotes.getUnchecked(j));
+            const bool noteHasChanged =
+                stateNote->getKey() != changesNote->getKey() ||
+                stateNote->getBeat() != changesNote->getBeat() ||
+                stateNote->getLength() != changesNote->getLength() ||
+                stateNote->getVelocity() != changesNote->getVelocity() ||
+                stateNote->getTuplet() != changesNote->getTuplet();
 
-            if (stateNote->getId() == changesNote->getId())
+            if (noteHasChanged)
             {
-                foundNoteInState = true;
-                break;
+                changedNotes.add(changesNote);
             }
-        }
-
-        // и пишем ее в список добавленных
-        if (! foundNoteInState)
+        },
+        [&](int i)
         {
-            addedNotes.add(changesNote);
-        }
-    }
+            // нота из состояния - в изменениях не найдена. добавляем запись removed.
+            removedNotes.add(stateNotes.getUnchecked(i));
+        },
+        [&](int j)
+        {
+            // нота из изменений отсутствует в состоянии, пишем ее в список добавленных
+            addedNotes.add(changesNotes.getUnchecked(j));
+        });
 
     // сериализуем диффы, если таковые есть
 
@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "ProjectTimelineDiffLogic.h"
+#include "DiffHelpers.h"
 #include "ProjectTimeline.h"
 #include "AnnotationsSequence.h"
 #include "TimeSignaturesSequence.h"
@@ -27,6 +28,13 @@
 namespace VCS
 {
 
+static ValueTree mergeTimelineEventsAdded(const ValueTree &state,
+    const ValueTree &changes, const Identifier &tag);
+static ValueTree mergeTimelineEventsRemoved(const ValueTree &state,
+    const ValueTree &changes, const Identifier &tag);
+static ValueTree mergeTimelineEventsChanged(const ValueTree &state,
+    const ValueTree &changes, const Identifier &tag);
+
 static ValueTree mergeAnnotationsAdded(const ValueTree &state, const ValueTree &changes);
 static ValueTree mergeAnnotationsRemoved(const ValueTree &state, const ValueTree &changes);
 static ValueTree mergeAnnotationsChanged(const ValueTree &state, const ValueTree &changes);
@@ -375,13 +383,12 @@ Diff *ProjectTimelineDiffLogic::createMergedItem(const TrackedItem &initialState
 }
 
 //===----------------------------------------------------------------------===//
-// Merge annotations
+// Merge any timeline events by id
 //===----------------------------------------------------------------------===//
 
-ValueTree mergeAnnotationsAdded(const ValueTree &state, const ValueTree &changes)
+ValueTree mergeTimelineEventsAdded(const ValueTree &state,
+    const ValueTree &changes, const Identifier &tag)
 {
-    using namespace Serialization::VCS;
-
     OwnedArray<MidiEvent> stateEvents;
     OwnedArray<MidiEvent> changesEvents;
     deserializeTimelineChanges(state, changes, stateEvents, changesEvents);
@@ -391,107 +398,92 @@ ValueTree mergeAnnotationsAdded(const ValueTree &state, const ValueTree &changes
     result.addArray(stateEvents);
 
     // check if state doesn't already have events with the same ids, then add
+    const auto stateIds = DiffHelpers::createIdIndex(stateEvents);
+
     for (int i = 0; i < changesEvents.size(); ++i)
     {
-        bool foundEventInState = false;
-        const AnnotationEvent *changesEvent =
-            static_cast<AnnotationEvent *>(changesEvents.getUnchecked(i));
-
-        for (int j = 0; j < stateEvents.size(); ++j)
+        if (DiffHelpers::findIndexById(stateIds, changesEvents, i) < 0)
         {
-            const AnnotationEvent *stateEvent =
-                static_cast<AnnotationEvent *>(stateEvents.getUnchecked(j));
-
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInState = true;
-                break;
-            }
-        }
-
-        if (! foundEventInState)
-        {
-            result.add(changesEvent);
+            result.add(changesEvents.getUnchecked(i));
         }
     }
 
-    return serializeTimelineSequence(result, ProjectTimelineDeltas::annotationsAdded);
+    return serializeTimelineSequence(result, tag);
 }
 
-ValueTree mergeAnnotationsRemoved(const ValueTree &state, const ValueTree &changes)
+ValueTree mergeTimelineEventsRemoved(const ValueTree &state,
+    const ValueTree &changes, const Identifier &tag)
 {
-    using namespace Serialization::VCS;
-
     OwnedArray<MidiEvent> stateEvents;
     OwnedArray<MidiEvent> changesEvents;
     deserializeTimelineChanges(state, changes, stateEvents, changesEvents);
 
     Array<const MidiEvent *> result;
 
+    const auto changesIds = DiffHelpers::createIdIndex(changesEvents);
+
     for (int i = 0; i < stateEvents.size(); ++i)
     {
-        bool foundEventInChanges = false;
-        const AnnotationEvent *stateEvent =
-            static_cast<AnnotationEvent *>(stateEvents.getUnchecked(i));
-
-        for (int j = 0; j < changesEvents.size(); ++j)
-        {
-            const AnnotationEvent *changesEvent =
-                static_cast<AnnotationEvent *>(changesEvents.getUnchecked(j));
-
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInChanges = true;
-                break;
-            }
-        }
-
-        if (! foundEventInChanges)
+        if (DiffHelpers::findIndexById(changesIds, stateEvents, i) < 0)
         {
-            result.add(stateEvent);
+            result.add(stateEvents.getUnchecked(i));
         }
     }
 
-    return serializeTimelineSequence(result, ProjectTimelineDeltas::annotationsAdded);
+    return serializeTimelineSequence(result, tag);
 }
 
-ValueTree mergeAnnotationsChanged(const ValueTree &state, const ValueTree &changes)
+ValueTree mergeTimelineEventsChanged(const ValueTree &state,
+    const ValueTree &changes, const Identifier &tag)
 {
-    using namespace Serialization::VCS;
-
     OwnedArray<MidiEvent> stateEvents;
     OwnedArray<MidiEvent> changesEvents;
     deserializeTimelineChanges(state, changes, stateEvents, changesEvents);
 
     Array<const MidiEvent *> result;
 
-    result.addArray(stateEvents);
+    // replace state events with their changed versions in place
+    const auto changesIds = DiffHelpers::createIdIndex(changesEvents);
+    Array<bool> changesUsed;
+    changesUsed.insertMultiple(0, false, changesEvents.size());
 
     for (int i = 0; i < stateEvents.size(); ++i)
     {
-        bool foundEventInChanges = false;
-        const AnnotationEvent *stateEvent =
-            static_cast<AnnotationEvent *>(stateEvents.getUnchecked(i));
-
-        for (int j = 0; j < changesEvents.size(); ++j)
+        const int j = DiffHelpers::findIndexById(changesIds, stateEvents, i);
+        if (j < 0)
         {
-            const AnnotationEvent *changesEvent =
-                static_cast<AnnotationEvent *>(changesEvents.getUnchecked(j));
+            result.add(stateEvents.getUnchecked(i));
+        }
+        else if (! changesUsed[j])
+        {
+            changesUsed.set(j, true);
+            result.add(changesEvents.getUnchecked(j));
+        }
+    }
 
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInChanges = true;
-                result.removeAllInstancesOf(stateEvent);
-                result.addIfNotAlreadyThere(changesEvent);
+    return serializeTimelineSequence(result, tag);
+}
 
-                break;
-            }
-        }
+//===----------------------------------------------------------------------===//
+// Merge annotations
+//===----------------------------------------------------------------------===//
 
-        //jassert(foundEventInChanges);
-    }
+ValueTree mergeAnnotationsAdded(const ValueTree &state, const ValueTree &changes)
+{
+    using namespace Serialization::VCS;
+    return mergeTimelineEventsAdded(state, changes, ProjectTimelineDeltas::annotationsAdded);
+}
 
-    return serializeTimelineSequence(result, ProjectTimelineDeltas::annotationsAdded);
+ValueTree mergeAnnotationsRemoved(const ValueTree &state, const ValueTree &changes)
+{
+    using namespace Serialization::VCS;
+    return mergeTimelineEventsRemoved(state, changes, ProjectTimelineDeltas::annotationsAdded);
+}
+
+ValueTree mergeAnnotationsChanged(const ValueTree &state, const ValueTree &changes)
+{
+    using namespace Serialization::VCS;
+    return mergeTimelineEventsChanged(state, changes, ProjectTimelineDeltas::annotationsAdded);
 }
 
 //===----------------------------------------------------------------------===//
@@ -501,117 +493,19 @@ ValueTree mergeAnnotationsChanged(const ValueTree &state, const ValueTree &chang
 ValueTree mergeTimeSignaturesAdded(const ValueTree &state, const ValueTree &changes)
 {
     using namespace Serialization::VCS;
-
-    OwnedArray<MidiEvent> stateEvents;
-    OwnedArray<MidiEvent> changesEvents;
-    deserializeTimelineChanges(state, changes, stateEvents, changesEvents);
-    
-    Array<const MidiEvent *> result;
-    
-    result.addArray(stateEvents);
-    
-    // check if state doesn't already have events with the same ids, then add
-    for (int i = 0; i < changesEvents.size(); ++i)
-    {
-        bool foundEventInState = false;
-        const TimeSignatureEvent *changesEvent =
-            static_cast<TimeSignatureEvent *>(changesEvents.getUnchecked(i));
-        
-        for (int j = 0; j < stateEvents.size(); ++j)
-        {
-            const TimeSignatureEvent *stateEvent =
-                static_cast<TimeSignatureEvent *>(stateEvents.getUnchecked(j));
-            
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInState = true;
-                break;
-            }
-        }
-        
-        if (! foundEventInState)
-        {
-            result.add(changesEvent);
-        }
-    }
-    
-    return serializeTimelineSequence(result, ProjectTimelineDeltas::timeSignaturesAdded);
+    return mergeTimelineEventsAdded(state, changes, ProjectTimelineDeltas::timeSignaturesAdded);
 }
 
 ValueTree mergeTimeSignaturesRemoved(const ValueTree &state, const ValueTree &changes)
 {
     using namespace Serialization::VCS;
-
-    OwnedArray<MidiEvent> stateEvents;
-    OwnedArray<MidiEvent> changesEvents;
-    deserializeTimelineChanges(state, changes, stateEvents, changesEvents);
-    
-    Array<const MidiEvent *> result;
-    
-    // add all events that are missing in changes
-    for (int i = 0; i < stateEvents.size(); ++i)
-    {
-        bool foundEventInChanges = false;
-        const TimeSignatureEvent *stateEvent =
-            static_cast<TimeSignatureEvent *>(stateEvents.getUnchecked(i));
-        
-        for (int j = 0; j < changesEvents.size(); ++j)
-        {
-            const TimeSignatureEvent *changesEvent =
-                static_cast<TimeSignatureEvent *>(changesEvents.getUnchecked(j));
-            
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInChanges = true;
-                break;
-            }
-        }
-        
-        if (! foundEventInChanges)
-        {
-            result.add(stateEvent);
-        }
-    }
-    
-    return serializeTimelineSequence(result, ProjectTimelineDeltas::timeSignaturesAdded);
+    return mergeTimelineEventsRemoved(state, changes, ProjectTimelineDeltas::timeSignaturesAdded);
 }
 
 ValueTree mergeTimeSignaturesChanged(const ValueTree &state, const ValueTree &changes)
 {
     using namespace Serialization::VCS;
-
-    OwnedArray<MidiEvent> stateEvents;
-    OwnedArray<MidiEvent> changesEvents;
-    deserializeTimelineChanges(state, changes, stateEvents, changesEvents);
-    
-    Array<const MidiEvent *> result;
-    result.addArray(stateEvents);
-    
-    for (int i = 0; i < stateEvents.size(); ++i)
-    {
-        bool foundEventInChanges = false;
-        const TimeSignatureEvent *stateEvent =
-            static_cast<TimeSignatureEvent *>(stateEvents.getUnchecked(i));
-        
-        for (int j = 0; j < changesEvents.size(); ++j)
-        {
-            const TimeSignatureEvent *changesEvent =
-                static_cast<TimeSignatureEvent *>(changesEvents.getUnchecked(j));
-            
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInChanges = true;
-                result.removeAllInstancesOf(stateEvent);
-                result.addIfNotAlreadyThere(changesEvent);
-                
-                break;
-            }
-        }
-        
-        //jassert(foundEventInChanges);
-    }
-    
-    return serializeTimelineSequence(result, ProjectTimelineDeltas::timeSignaturesAdded);
+    return mergeTimelineEventsChanged(state, changes, ProjectTimelineDeltas::timeSignaturesAdded);
 }
 
 //===----------------------------------------------------------------------===//
@@ -621,117 +515,19 @@ ValueTree mergeTimeSignaturesChanged(const ValueTree &state, const ValueTree &ch
 ValueTree mergeKeySignaturesAdded(const ValueTree &state, const ValueTree &changes)
 {
     using namespace Serialization::VCS;
-
-    OwnedArray<MidiEvent> stateEvents;
-    OwnedArray<MidiEvent> changesEvents;
-    deserializeTimelineChanges(state, changes, stateEvents, changesEvents);
-
-    Array<const MidiEvent *> result;
-
-    result.addArray(stateEvents);
-
-    // check if state doesn't already have events with the same ids, then add
-    for (int i = 0; i < changesEvents.size(); ++i)
-    {
-        bool foundEventInState = false;
-        const KeySignatureEvent *changesEvent =
-            static_cast<KeySignatureEvent *>(changesEvents.getUnchecked(i));
-
-        for (int j = 0; j < stateEvents.size(); ++j)
-        {
-            const KeySignatureEvent *stateEvent =
-                static_cast<KeySignatureEvent *>(stateEvents.getUnchecked(j));
-
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInState = true;
-                break;
-            }
-        }
-
-        if (!foundEventInState)
-        {
-            result.add(changesEvent);
-        }
-    }
-
-    return serializeTimelineSequence(result, ProjectTimelineDeltas::keySignaturesAdded);
+    return mergeTimelineEventsAdded(state, changes, ProjectTimelineDeltas::keySignaturesAdded);
 }
 
 ValueTree mergeKeySignaturesRemoved(const ValueTree &state, const ValueTree &changes)
 {
     using namespace Serialization::VCS;
-
-    OwnedArray<MidiEvent> stateEvents;
-    OwnedArray<MidiEvent> changesEvents;
-    deserializeTimelineChanges(state, changes, stateEvents, changesEvents);
-
-    Array<const MidiEvent *> result;
-
-    // add all events that are missing in changes
-    for (int i = 0; i < stateEvents.size(); ++i)
-    {
-        bool foundEventInChanges = false;
-        const KeySignatureEvent *stateEvent =
-            static_cast<KeySignatureEvent *>(stateEvents.getUnchecked(i));
-
-        for (int j = 0; j < changesEvents.size(); ++j)
-        {
-            const KeySignatureEvent *changesEvent =
-                static_cast<KeySignatureEvent *>(changesEvents.getUnchecked(j));
-
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInChanges = true;
-                break;
-            }
-        }
-
-        if (!foundEventInChanges)
-        {
-            result.add(stateEvent);
-        }
-    }
-
-    return serializeTimelineSequence(result, ProjectTimelineDeltas::keySignaturesAdded);
+    return mergeTimelineEventsRemoved(state, changes, ProjectTimelineDeltas::keySignaturesAdded);
 }
 
 ValueTree mergeKeySignaturesChanged(const ValueTree &state, const ValueTree &changes)
 {
     using namespace Serialization::VCS;
-
-    OwnedArray<MidiEvent> stateEvents;
-    OwnedArray<MidiEvent> changesEvents;
-    deserializeTimelineChanges(state, changes, stateEvents, changesEvents);
-
-    Array<const MidiEvent *> result;
-    result.addArray(stateEvents);
-
-    for (int i = 0; i < stateEvents.size(); ++i)
-    {
-        bool foundEventInChanges = false;
-        const KeySignatureEvent *stateEvent =
-            static_cast<KeySignatureEvent *>(stateEvents.getUnchecked(i));
-
-        for (int j = 0; j < changesEvents.size(); ++j)
-        {
-            const KeySignatureEvent *changesEvent =
-                static_cast<KeySignatureEvent *>(changesEvents.getUnchecked(j));
-
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInChanges = true;
-                result.removeAllInstancesOf(stateEvent);
-                result.addIfNotAlreadyThere(changesEvent);
-
-                break;
-            }
-        }
-
-        //jassert(foundEventInChanges);
-    }
-
-    return serializeTimelineSequence(result, ProjectTimelineDeltas::keySignaturesAdded);
+    return mergeTimelineEventsChanged(state, changes, ProjectTimelineDeltas::keySignaturesAdded);
 }
 
 
@@ -752,67 +548,35 @@ Array<DeltaDiff> createAnnotationsDiffs(const ValueTree &state, const ValueTree
     Array<const MidiEvent *> removedEvents;
     Array<const MidiEvent *> changedEvents;
 
-    for (int i = 0; i < stateEvents.size(); ++i)
-    {
-        bool foundEventInChanges = false;
-        const AnnotationEvent *stateEvent =
-            static_cast<AnnotationEvent *>(stateEvents.getUnchecked(i));
-
-        for (int j = 0; j < changesEvents.size(); ++j)
+    DiffHelpers::joinById(stateEvents, changesEvents,
+        [&](int i, int j)
         {
+            // state event was found in changes, add `changed` records
+            const AnnotationEvent *stateEvent =
+                static_cast<AnnotationEvent *>(stateEvents.getUnchecked(i));
             const AnnotationEvent *changesEvent =
                 static_cast<AnnotationEvent *>(changesEvents.getUnchecked(j));
 
-            // state event was found in changes, add `changed` records
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInChanges = true;
-
-                const bool eventHasChanged =
-                    (stateEvent->getBeat() != changesEvent->getBeat() ||
-                     stateEvent->getTrackColour() != changesEvent->getTrackColour() ||
-                     stateEvent->getDescription() != changesEvent->getDescription());
-
-                if (eventHasChanged)
-                {
-                    changedEvents.add(changesEvent);
-                }
-
-                break;
-            }
-        }
-
-        // state event was not found in changes, add `removed` record
-        if (! foundEventInChanges)
-        {
-            removedEvents.add(stateEvent);
-        }
-    }
-
-    // search for the new events missing in state
-    for (int i = 0; i < changesEvents.size(); ++i)
-    {
-        bool foundEventInState = false;
-        const AnnotationEvent *changesEvent =
-            static_cast<AnnotationEvent *>(changesEvents.getUnchecked(i));
+            const bool eventHasChanged =
+                (stateEvent->getBeat() != changesEvent->getBeat() ||
+                 stateEvent->getTrackColour() != changesEvent->getTrackColour() ||
+                 stateEvent->getDescription() != changesEvent->getDescription());
 
-        for (int j = 0; j < stateEvents.size(); ++j)
-        {
-            const AnnotationEvent *stateEvent =
-                static_cast<AnnotationEvent *>(stateEvents.getUnchecked(j));
-
-            if (stateEvent->getId() == changesEvent->getId())
+            if (eventHasChanged)
             {
-                foundEventInState = true;
-                break;
+                changedEvents.add(changesEvent);
             }
-        }
-
-        if (! foundEventInState)
+        },
+        [&](int i)
         {
-            addedEvents.add(changesEvent);
-        }
-    }
+            // state event was not found in changes, add `removed` record
+            removedEvents.add(stateEvents.getUnchecked(i));
+        },
+        [&](int j)
+        {
+            // new event missing in state, add `added` record
+            addedEvents.add(changesEvents.getUnchecked(j));
+        });
 
     // serialize deltas, if any
     if (addedEvents.size() > 0)
@@ -856,68 +620,36 @@ Array<DeltaDiff> createTimeSignaturesDiffs(const ValueTree &state, const ValueTr
     Array<const MidiEvent *> removedEvents;
     Array<const MidiEvent *> changedEvents;
     
-    for (int i = 0; i < stateEvents.size(); ++i)
-    {
-        bool foundEventInChanges = false;
-        const TimeSignatureEvent *stateEvent =
-            static_cast<TimeSignatureEvent *>(stateEvents.getUnchecked(i));
-        
-        for (int j = 0; j < changesEvents.size(); ++j)
+    DiffHelpers::joinById(stateEvents, changesEvents,
+        [&](int i, int j)
         {
+            // state event was found in changes, add `changed` records
+            const TimeSignatureEvent *stateEvent =
+                static_cast<TimeSignatureEvent *>(stateEvents.getUnchecked(i));
             const TimeSignatureEvent *changesEvent =
                 static_cast<TimeSignatureEvent *>(changesEvents.getUnchecked(j));
-            
-            // state event was found in changes, add `changed` records
-            if (stateEvent->getId() == changesEvent->getId())
+
+            const bool eventHasChanged =
+                (stateEvent->getBeat() != changesEvent->getBeat() ||
+                 stateEvent->getNumerator() != changesEvent->getNumerator() ||
+                 stateEvent->getDenominator() != changesEvent->getDenominator());
+
+            if (eventHasChanged)
             {
-                foundEventInChanges = true;
-                
-                const bool eventHasChanged =
-                    (stateEvent->getBeat() != changesEvent->getBeat() ||
-                     stateEvent->getNumerator() != changesEvent->getNumerator() ||
-                     stateEvent->getDenominator() != changesEvent->getDenominator());
-                
-                if (eventHasChanged)
-                {
-                    changedEvents.add(changesEvent);
-                }
-                
-                break;
+                changedEvents.add(changesEvent);
             }
-        }
-        
-        // state event was not found in changes, add `removed` record
-        if (! foundEventInChanges)
+        },
+        [&](int i)
         {
-            removedEvents.add(stateEvent);
-        }
-    }
-    
-    // search for the new events missing in state
-    for (int i = 0; i < changesEvents.size(); ++i)
-    {
-        bool foundEventInState = false;
-        const TimeSignatureEvent *changesEvent =
-            static_cast<TimeSignatureEvent *>(changesEvents.getUnchecked(i));
-        
-        for (int j = 0; j < stateEvents.size(); ++j)
+            // state event was not found in changes, add `removed` record
+            removedEvents.add(stateEvents.getUnchecked(i));
+        },
+        [&](int j)
         {
-            const TimeSignatureEvent *stateEvent =
-                static_cast<TimeSignatureEvent *>(stateEvents.getUnchecked(j));
-            
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInState = true;
-                break;
-            }
-        }
-        
-        if (! foundEventInState)
-        {
-            addedEvents.add(changesEvent);
-        }
-    }
-    
+            // new event missing in state, add `added` record
+            addedEvents.add(changesEvents.getUnchecked(j));
+        });
+
     // serialize deltas, if any
     if (addedEvents.size() > 0)
     {
@@ -959,67 +691,35 @@ Array<DeltaDiff> createKeySignaturesDiffs(const ValueTree &state, const ValueTre
     Array<const MidiEvent *> removedEvents;
     Array<const MidiEvent *> changedEvents;
 
-    for (int i = 0; i < stateEvents.size(); ++i)
-    {
-        bool foundEventInChanges = false;
-        const KeySignatureEvent *stateEvent =
-            static_cast<KeySignatureEvent *>(stateEvents.getUnchecked(i));
-
-        for (int j = 0; j < changesEvents.size(); ++j)
+    DiffHelpers::joinById(stateEvents, changesEvents,
+        [&](int i, int j)
         {
+            // state event was found in changes, add `changed` records
+            const KeySignatureEvent *stateEvent =
+                static_cast<KeySignatureEvent *>(stateEvents.getUnchecked(i));
             const KeySignatureEvent *changesEvent =
                 static_cast<KeySignatureEvent *>(changesEvents.getUnchecked(j));
 
-            // state event was found in changes, add `changed` records
-            if (stateEvent->getId() == changesEvent->getId())
-            {
-                foundEventInChanges = true;
-
-                const bool eventHasChanged =
-                    (stateEvent->getBeat() != changesEvent->getBeat() ||
-                        stateEvent->getRootKey() != changesEvent->getRootKey() ||
-                        ! stateEvent->getScale()->isEquivalentTo(changesEvent->getScale()));
-
-                if (eventHasChanged)
-                {
-                    changedEvents.add(changesEvent);
-                }
-
-                break;
-            }
-        }
-
-        // state event was not found in changes, add `removed` record
-        if (!foundEventInChanges)
-        {
-            removedEvents.add(stateEvent);
-        }
-    }
-
-    // search for the new events missing in state
-    for (int i = 0; i < changesEvents.size(); ++i)
-    {
-        bool foundEventInState = false;
-        const KeySignatureEvent *changesEvent =
-            static_cast<KeySignatureEvent *>(changesEvents.getUnchecked(i));
-
-        for (int j = 0; j < stateEvents.size(); ++j)
-        {
-            const KeySignatureEvent *stateEvent =
-                static_cast<KeySignatureEvent *>(stateEvents.getUnchecked(j));
+            const bool eventHasChanged =
+                (stateEvent->getBeat() != changesEvent->getBeat() ||
+                 stateEvent->getRootKey() != changesEvent->getRootKey() ||
+                 ! stateEvent->getScale()->isEquivalentTo(changesEvent->getScale()));
 
-            if (stateEvent->getId() == changesEvent->getId())
+            if (eventHasChanged)
             {
-                foundEventInState = true;
-                break;
+                changedEvents.add(changesEvent);
             }
-        }
-
-        if (!foundEventInState)
+        },
+        [&](int i)
         {
-            addedEvents.add(changesEvent);
-        }
-    }
+            // state event was not found in changes, add `removed` record
+            removedEvents.add(stateEvents.getUnchecked(i));
+        },
+        [&](int j)
+        {
+            // new event missing in state, add `added` record
+            addedEvents.add(changesEvents.getUnchecked(j));
+        });
 
     // serialize deltas, if any
     if (addedEvents.size() > 0)
@@ -28,12 +28,17 @@ namespace VCS
 
 #define DIFF_BUILD_THREAD_STOP_TIMEOUT 5000
 
+// how many revisions deep are the snapshot checkpoints
+#define HEAD_CHECKPOINT_INTERVAL 20
+
 Head::Head(const Head &other) :
     Thread("Diff Thread"),
     targetVcsItemsSource(other.targetVcsItemsSource),
     diffOutdated(other.diffOutdated),
+    outdatedItems(other.outdatedItems),
     rebuildingDiffMode(false),
     diff(other.diff),
+    diffItems(other.diffItems),
     headingAt(other.headingAt),
     state(new Snapshot(other.state.get())) {}
 
@@ -46,6 +51,33 @@ Head::Head(TrackedItemsSource &targetProject) :
     headingAt(new Revision()),
     state(new Snapshot()) {}
 
+class Head::ItemDiffJob final : public ThreadPoolJob
+{
+public:
+
+    ItemDiffJob(const String &uuid, TrackedItem *stateItem, TrackedItem *targetItem) :
+        ThreadPoolJob("ItemDiffJob"),
+        uuid(uuid),
+        stateItem(stateItem),
+        targetItem(targetItem) {}
+
+    JobStatus runJob() override
+    {
+        this->result = Head::createDiffItem(this->stateItem, this->targetItem);
+        return jobHasFinished;
+    }
+
+    const String uuid;
+    RevisionItem::Ptr result;
+
+private:
+
+    TrackedItem *stateItem;
+    TrackedItem *targetItem;
+
+    JUCE_DECLARE_NON_COPYABLE(ItemDiffJob)
+};
+
 Revision::Ptr Head::getHeadingRevision() const
 {
     return this->headingAt;
@@ -78,13 +110,46 @@ bool Head::hasTrackedItemsOnTheStage() const
 bool Head::isDiffOutdated() const
 {
     const ScopedReadLock lock(this->outdatedMarkerLock);
-    return this->diffOutdated;
+    return this->diffOutdated || !this->outdatedItems.empty();
 }
 
 void Head::setDiffOutdated(bool isOutdated)
 {
     const ScopedWriteLock lock(this->outdatedMarkerLock);
     this->diffOutdated = isOutdated;
+
+    if (!isOutdated)
+    {
+        this->outdatedItems.clear();
+    }
+}
+
+void Head::setItemOutdated(const TrackedItem *item)
+{
+    const ScopedWriteLock lock(this->outdatedMarkerLock);
+
+    if (item == nullptr)
+    {
+        this->diffOutdated = true;
+        return;
+    }
+
+    this->outdatedItems.insert(item->getUuid().toString());
+}
+
+double Head::getLastRebuildTimeMs() const noexcept
+{
+    return this->lastRebuildTimeMs.get();
+}
+
+int Head::getLastRebuildNumItems() const noexcept
+{
+    return this->lastRebuildNumItems.get();
+}
+
+int Head::getLastRebuildNumThreads() const noexcept
+{
+    return this->lastRebuildNumThreads.get();
 }
 
 bool Head::isRebuildingDiff() const
@@ -141,12 +206,6 @@ bool Head::moveTo(const Revision::Ptr revision)
         this->stopThread(DIFF_BUILD_THREAD_STOP_TIMEOUT);
     }
 
-    // first, reset the snapshot state
-    {
-        const ScopedWriteLock lock(this->stateLock);
-        this->state.reset(new Snapshot());
-    }
-
     // a path from the root to current revision
     ReferenceCountedArray<Revision> treePath;
     Revision::Ptr currentRevision(revision);
@@ -156,9 +215,36 @@ bool Head::moveTo(const Revision::Ptr revision)
         currentRevision = currentRevision->getParent();
     }
 
-    // then move from the root back to target revision
-    for (const auto *rev : treePath)
+    // first, reset the snapshot state to the nearest checkpoint on the path, if any
+    int firstRevisionToApply = 0;
+
+    {
+        const ScopedWriteLock lock(this->stateLock);
+        this->state.reset(new Snapshot());
+
+        for (int i = treePath.size(); i --> 0 ;)
+        {
+            const auto checkpoint = this->checkpoints.find(treePath.getUnchecked(i)->getUuid());
+            if (checkpoint != this->checkpoints.end())
+            {
+                this->state.reset(new Snapshot(checkpoint->second.get()));
+                firstRevisionToApply = i + 1;
+                break;
+            }
+        }
+    }
+
+    // shallow copies have no deltas data yet, and the state after them is incomplete
+    bool canCreateCheckpoints = true;
+    for (int i = 0; i < firstRevisionToApply; ++i)
     {
+        canCreateCheckpoints = canCreateCheckpoints && !treePath.getUnchecked(i)->isShallowCopy();
+    }
+
+    // then move from the checkpoint (or the root) back to target revision
+    for (int i = firstRevisionToApply; i < treePath.size(); ++i)
+    {
+        const auto *rev = treePath.getUnchecked(i);
         DBG("VCS head moved to " + rev->getUuid());
 
         // picking all deltas and applying them to current state
@@ -181,6 +267,14 @@ bool Head::moveTo(const Revision::Ptr revision)
                 jassertfalse;
             }
         }
+
+        canCreateCheckpoints = canCreateCheckpoints && !rev->isShallowCopy();
+
+        // snapshots share the unchanged items, so a checkpoint is relatively cheap
+        if (canCreateCheckpoints && i > 0 && (i % HEAD_CHECKPOINT_INTERVAL) == 0)
+        {
+            this->checkpoints[rev->getUuid()].reset(new Snapshot(this->state.get()));
+        }
     }
 
     this->headingAt = revision;
@@ -188,6 +282,11 @@ bool Head::moveTo(const Revision::Ptr revision)
     return true;
 }
 
+void Head::resetCheckpoints()
+{
+    this->checkpoints.clear();
+}
+
 void Head::pointTo(const Revision::Ptr revision)
 {
     this->headingAt = revision;
@@ -195,43 +294,20 @@ void Head::pointTo(const Revision::Ptr revision)
 }
 
 
-bool Head::resetChangedItemToState(const RevisionItem::Ptr diffItem)
+bool Head::resetChangedItemToState(const RevisionItem::Ptr diffItem,
+    const TrackedItemsIndex &stateIndex, const TrackedItemsIndex &targetIndex)
 {
     if (this->state == nullptr)
     { return false; }
 
-    // на входе - один из айтемов диффа
-    TrackedItem *sourceItem = nullptr;
-
-    // ищем в собранном состоянии айтем с соответствующим уидом
-    for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
-    {
-        auto *item = this->state->getTrackedItem(i);
-
-        if (item->getUuid() == diffItem->getUuid())
-        {
-            sourceItem = item;
-            break;
-        }
-    }
+    // на входе - один из айтемов диффа, ищем соответствующие айтемы по уиду
+    const String uuid(diffItem->getUuid().toString());
+    TrackedItem *sourceItem = findTrackedItem(stateIndex, uuid);
+    TrackedItem *targetItem = findTrackedItem(targetIndex, uuid);
 
     // обработать тип - добавлено, удалено, изменено
     if (diffItem->getType() == RevisionItem::Type::Changed)
     {
-        TrackedItem *targetItem = nullptr;
-
-        // ищем в проекте айтем с соответствующим уидом
-        for (int i = 0; i < this->targetVcsItemsSource.getNumTrackedItems(); ++i)
-        {
-            auto *item = this->targetVcsItemsSource.getTrackedItem(i);
-
-            if (item->getUuid() == diffItem->getUuid())
-            {
-                targetItem = item;
-                break;
-            }
-        }
-
         if (targetItem != nullptr && sourceItem != nullptr)
         {
             targetItem->resetStateTo(*sourceItem);
@@ -240,31 +316,21 @@ bool Head::resetChangedItemToState(const RevisionItem::Ptr diffItem)
     }
     else if (diffItem->getType() == RevisionItem::Type::Added)
     {
-        TrackedItem *targetItem = nullptr;
-
-        // снова ищем исходный с тем же уидом и вызываем deleteTrackedItem
-        for (int i = 0; i < this->targetVcsItemsSource.getNumTrackedItems(); ++i)
-        {
-            auto *item = this->targetVcsItemsSource.getTrackedItem(i);
-
-            if (item->getUuid() == diffItem->getUuid())
-            {
-                targetItem = item;
-                break;
-            }
-        }
-
-        if (targetItem)
+        // удаляем из проекта айтем, которого нет в состоянии
+        if (targetItem != nullptr)
         {
             return this->targetVcsItemsSource.deleteTrackedItem(targetItem);
         }
     }
     else if (diffItem->getType() == RevisionItem::Type::Removed)
     {
-        const Identifier logicType(sourceItem->getDiffLogic()->getType());
-        const Uuid id(sourceItem->getUuid());
-        this->targetVcsItemsSource.initTrackedItem(logicType, id, *sourceItem);
-        return true;
+        if (sourceItem != nullptr)
+        {
+            const Identifier logicType(sourceItem->getDiffLogic()->getType());
+            const Uuid id(sourceItem->getUuid());
+            this->targetVcsItemsSource.initTrackedItem(logicType, id, *sourceItem);
+            return true;
+        }
     }
 
     return false;
@@ -278,12 +344,13 @@ void Head::checkout()
     // clear all tracked items
     {
         Array<TrackedItem *> itemsToClear;
+        const auto stateIndex = createTrackedItemsIndex(*this->state);
 
         for (int i = 0; i < this->targetVcsItemsSource.getNumTrackedItems(); ++i)
         {
             TrackedItem *ti = this->targetVcsItemsSource.getTrackedItem(i);
 
-            if (this->state->getItemWithUuid(ti->getUuid()) != nullptr)
+            if (findTrackedItem(stateIndex, ti->getUuid().toString()) != nullptr)
             {
                 itemsToClear.add(ti);
             }
@@ -295,10 +362,12 @@ void Head::checkout()
         }
     }
 
+    const auto targetIndex = createTrackedItemsIndex(this->targetVcsItemsSource);
+
     for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
     {
         RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
-        this->checkoutItem(stateItem);
+        this->checkoutItem(stateItem, targetIndex);
     }
 
     this->targetVcsItemsSource.onResetState();
@@ -309,18 +378,22 @@ void Head::cherryPick(const Array<Uuid> uuids)
     if (this->state == nullptr)
     { return; }
 
+    FlatHashSet<String, StringHash> pickedUuids;
+    for (const auto &uuid : uuids)
+    {
+        pickedUuids.insert(uuid.toString());
+    }
+
+    const auto targetIndex = createTrackedItemsIndex(this->targetVcsItemsSource);
+
     for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
     {
         RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
 
         // если этот айтем состояния выбран юзером, то чекаут.
-        for (int j = 0; j < uuids.size(); ++j)
+        if (pickedUuids.find(stateItem->getUuid().toString()) != pickedUuids.end())
         {
-            if (stateItem->getUuid() == uuids.getUnchecked(j))
-            {
-                this->checkoutItem(stateItem);
-                break;
-            }
+            this->checkoutItem(stateItem, targetIndex);
         }
     }
 
@@ -332,10 +405,12 @@ void Head::cherryPickAll()
     if (this->state == nullptr)
     { return; }
     
+    const auto targetIndex = createTrackedItemsIndex(this->targetVcsItemsSource);
+
     for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
     {
         RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
-        this->checkoutItem(stateItem);
+        this->checkoutItem(stateItem, targetIndex);
     }
 
     this->targetVcsItemsSource.onResetState();
@@ -346,31 +421,22 @@ bool Head::resetChanges(const Array<RevisionItem::Ptr> &changes)
     if (this->state == nullptr)
     { return false; }
 
+    const auto stateIndex = createTrackedItemsIndex(*this->state);
+    const auto targetIndex = createTrackedItemsIndex(this->targetVcsItemsSource);
+
     for (const auto &item : changes)
     {
-        this->resetChangedItemToState(item);
+        this->resetChangedItemToState(item, stateIndex, targetIndex);
     }
 
     this->targetVcsItemsSource.onResetState();
     return true;
 }
 
-void Head::checkoutItem(RevisionItem::Ptr stateItem)
+void Head::checkoutItem(RevisionItem::Ptr stateItem, const TrackedItemsIndex &targetIndex)
 {
     // Changed и Added RevisionItem'ы нужно применять через resetStateTo
-    TrackedItem *targetItem = nullptr;
-    
-    // ищем в проекте айтем с соответствующим уидом
-    for (int j = 0; j < this->targetVcsItemsSource.getNumTrackedItems(); ++j)
-    {
-        TrackedItem *item = this->targetVcsItemsSource.getTrackedItem(j);
-
-        if (item->getUuid() == stateItem->getUuid())
-        {
-            targetItem = item;
-            break;
-        }
-    }
+    TrackedItem *targetItem = findTrackedItem(targetIndex, stateItem->getUuid().toString());
 
     if (stateItem->getType() == RevisionItem::Type::Changed)
     {
@@ -449,7 +515,33 @@ ValueTree Head::serialize() const
     return tree;
 }
 
+ValueTree Head::serialize(DeltaDataPool &dataPool) const
+{
+    ValueTree tree(Serialization::VCS::head);
+    ValueTree snapshotNode(Serialization::VCS::snapshot);
+
+    {
+        const ScopedReadLock lock(this->stateLock);
+
+        // the snapshot mostly shares the data with the heading revision,
+        // so it will mostly refer to the blobs already in the pool
+        for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
+        {
+            const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
+            snapshotNode.appendChild(stateItem->serialize(dataPool), nullptr);
+        }
+    }
+
+    tree.appendChild(snapshotNode, nullptr);
+    return tree;
+}
+
 void Head::deserialize(const ValueTree &tree)
+{
+    this->deserialize(tree, {});
+}
+
+void Head::deserialize(const ValueTree &tree, const DeltaDataLookup &dataLookup)
 {
     this->reset();
     
@@ -462,7 +554,7 @@ void Head::deserialize(const ValueTree &tree)
     if (!snapshotNode.isValid()) { return; }
 
     // A temporary workaround, see the comment in VersionControl::deserialize()
-    DeltaDataLookup deltaDataLookup;
+    DeltaDataLookup deltaDataLookup(dataLookup);
     const auto snapshotDataNode = root.getChildWithName(Serialization::VCS::snapshotData);
     forEachValueTreeChildWithType(snapshotDataNode, dataElement, Serialization::VCS::packItem)
     {
@@ -482,6 +574,7 @@ void Head::deserialize(const ValueTree &tree)
 
 void Head::reset()
 {
+    this->resetCheckpoints();
     this->state.reset(new Snapshot());
     this->setDiffOutdated(true);
 }
@@ -509,196 +602,234 @@ void Head::run()
     this->setRebuildingDiffMode(true);
     this->sendChangeMessage();
 
+    this->rebuildDiff(true);
+
+    this->setRebuildingDiffMode(false);
+    this->sendChangeMessage();
+}
+
+void Head::rebuildDiffSynchronously()
+{
+    if (this->state == nullptr)
+    { return; }
+    
+    if (this->isRebuildingDiff())
+    { return; }
+    
+    this->setRebuildingDiffMode(true);
+    this->rebuildDiff(false);
+    this->setRebuildingDiffMode(false);
+    this->sendChangeMessage();
+}
+
+bool Head::rebuildDiff(bool canBeInterrupted)
+{
+    const double rebuildStartMs = Time::getMillisecondCounterHiRes();
+
+    bool rebuildAllItems = false;
+    FlatHashSet<String, StringHash> itemsToRebuild;
+
     {
-        const ScopedWriteLock lock(this->diffLock);
-        this->diff->reset();
+        const ScopedWriteLock lock(this->outdatedMarkerLock);
+        rebuildAllItems = this->diffOutdated;
+        itemsToRebuild.swap(this->outdatedItems);
+        this->diffOutdated = false;
     }
 
-    const ScopedReadLock threadStateLock(this->stateLock);
+    const ScopedReadLock rebuildStateLock(this->stateLock);
+
+    // `removed` records in the state don't need a diff,
+    // so the state index only has items that are still alive
+    const auto stateIndex = createTrackedItemsIndex(*this->state, true);
+    const auto targetIndex = createTrackedItemsIndex(this->targetVcsItemsSource);
 
-    for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
+    if (rebuildAllItems)
     {
-        if (this->threadShouldExit())
+        this->diffItems.clear();
+        itemsToRebuild.clear();
+
+        for (const auto &stateItem : stateIndex)
+        {
+            itemsToRebuild.insert(stateItem.first);
+        }
+
+        for (const auto &targetItem : targetIndex)
         {
-            this->setRebuildingDiffMode(false);
-            this->sendChangeMessage();
-            return;
+            itemsToRebuild.insert(targetItem.first);
         }
+    }
 
-        bool foundItemInTarget = false;
-        const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
+    // item diffs don't depend on each other, so they are computed in parallel,
+    // and merged into the cache here, on this thread, once they are all done
+    const int numThreads = jmin(int(itemsToRebuild.size()), SystemStats::getNumCpus());
 
-        // will check `removed` records later
-        if (stateItem->getType() == RevisionItem::Type::Removed) { continue; }
+    OwnedArray<ItemDiffJob> jobs;
+    for (const auto &uuid : itemsToRebuild)
+    {
+        jobs.add(new ItemDiffJob(uuid,
+            findTrackedItem(stateIndex, uuid),
+            findTrackedItem(targetIndex, uuid)));
+    }
 
-        for (int j = 0; j < this->targetVcsItemsSource.getNumTrackedItems(); ++j)
+    if (numThreads > 1)
+    {
+        if (this->diffWorkers == nullptr)
         {
-            if (this->threadShouldExit())
-            {
-                this->setRebuildingDiffMode(false);
-                this->sendChangeMessage();
-                return;
-            }
+            this->diffWorkers.reset(new ThreadPool(SystemStats::getNumCpus()));
+        }
 
-            TrackedItem *targetItem = this->targetVcsItemsSource.getTrackedItem(j); // i.e. LayerTreeItem
+        for (auto *job : jobs)
+        {
+            this->diffWorkers->addJob(job, false);
+        }
 
-            // state item exists in project, adding `changed` record, if needed
-            if (stateItem->getUuid() == targetItem->getUuid())
+        for (auto *job : jobs)
+        {
+            while (!this->diffWorkers->waitForJobToFinish(job, 10))
             {
-                foundItemInTarget = true;
-
-                UniquePointer<Diff> itemDiff(targetItem->getDiffLogic()->createDiff(*stateItem));
-
-                if (itemDiff->hasAnyChanges())
+                if (canBeInterrupted && this->threadShouldExit())
                 {
-                    RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Changed, itemDiff.get()));
-                    const ScopedWriteLock itemDiffLock(this->diffLock);
-                    this->diff->addItem(revisionRecord);
+                    this->diffWorkers->removeAllJobs(true, -1);
+                    this->restoreOutdatedItems(itemsToRebuild, rebuildAllItems);
+                    return false;
                 }
-
-                break;
             }
         }
-
-        // state item was not found in project, adding `removed` record
-        if (! foundItemInTarget)
+    }
+    else
+    {
+        for (auto *job : jobs)
         {
-            UniquePointer<Diff> emptyDiff(new Diff(*stateItem));
-            RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Removed, emptyDiff.get()));
-            const ScopedWriteLock emptyDiffLock(this->diffLock);
-            this->diff->addItem(revisionRecord);
+            if (canBeInterrupted && this->threadShouldExit())
+            {
+                this->restoreOutdatedItems(itemsToRebuild, rebuildAllItems);
+                return false;
+            }
+
+            job->runJob();
         }
     }
 
-    // search for project item that are missing (or deleted) in the state
-    for (int i = 0; i < this->targetVcsItemsSource.getNumTrackedItems(); ++i)
+    for (const auto *job : jobs)
     {
-        if (this->threadShouldExit())
+        if (job->result != nullptr)
         {
-            this->setRebuildingDiffMode(false);
-            this->sendChangeMessage();
-            return;
+            this->diffItems[job->uuid] = job->result;
         }
-
-        bool foundItemInState = false;
-        TrackedItem *targetItem = this->targetVcsItemsSource.getTrackedItem(i);
-
-        for (int j = 0; j < this->state->getNumTrackedItems(); ++j)
+        else
         {
-            const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(j));
+            this->diffItems.erase(job->uuid);
+        }
+    }
 
-            if (stateItem->getType() == RevisionItem::Type::Removed) { continue; }
+    // now collect the records in the same order the full rebuild used to have them:
+    // changed and removed ones in the state order, then added ones in the project order
+    Revision::Ptr newDiff(new Revision());
 
-            if (stateItem->getUuid() == targetItem->getUuid())
+    for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
+    {
+        const String uuid(this->state->getTrackedItem(i)->getUuid().toString());
+        if (stateIndex.find(uuid) != stateIndex.end())
+        {
+            const auto diffItem = this->diffItems.find(uuid);
+            if (diffItem != this->diffItems.end())
             {
-                foundItemInState = true;
-                break;
+                newDiff->addItem(diffItem->second);
             }
         }
+    }
 
-        // copy deltas from targetItem and add `added` record
-        if (! foundItemInState)
+    for (int i = 0; i < this->targetVcsItemsSource.getNumTrackedItems(); ++i)
+    {
+        const String uuid(this->targetVcsItemsSource.getTrackedItem(i)->getUuid().toString());
+        if (stateIndex.find(uuid) == stateIndex.end())
         {
-            RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Added, targetItem));
-            const ScopedWriteLock lock(this->diffLock);
-            this->diff->addItem(revisionRecord);
+            const auto diffItem = this->diffItems.find(uuid);
+            if (diffItem != this->diffItems.end())
+            {
+                newDiff->addItem(diffItem->second);
+            }
         }
     }
 
-    this->setDiffOutdated(false);
-    this->setRebuildingDiffMode(false);
-    this->sendChangeMessage();
+    {
+        const ScopedWriteLock lock(this->diffLock);
+        this->diff = newDiff;
+    }
+
+    this->lastRebuildNumItems = int(itemsToRebuild.size());
+    this->lastRebuildNumThreads = jmax(1, numThreads);
+    this->lastRebuildTimeMs = Time::getMillisecondCounterHiRes() - rebuildStartMs;
+
+    return true;
 }
 
-// FIXME: lots of duplicate code form Head::run
-void Head::rebuildDiffSynchronously()
+void Head::restoreOutdatedItems(const FlatHashSet<String, StringHash> &items, bool rebuildAllItems)
 {
-    if (this->state == nullptr)
-    { return; }
-    
-    if (this->isRebuildingDiff())
-    { return; }
-    
-    this->setRebuildingDiffMode(true);
-    
+    // all the taken items will be re-diffed next time
+    const ScopedWriteLock lock(this->outdatedMarkerLock);
+    this->diffOutdated = this->diffOutdated || rebuildAllItems;
+    for (const auto &uuid : items)
     {
-        const ScopedWriteLock lock(this->diffLock);
-        this->diff->reset();
+        this->outdatedItems.insert(uuid);
     }
-    
-    const ScopedReadLock rebuildStateLock(this->stateLock);
-    
-    for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
+}
+
+RevisionItem::Ptr Head::createDiffItem(TrackedItem *stateItem, TrackedItem *targetItem)
+{
+    if (stateItem != nullptr && targetItem != nullptr)
     {
-        bool foundItemInTarget = false;
-        const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
-        
-        // will check `removed` records later
-        if (stateItem->getType() == RevisionItem::Type::Removed) { continue; }
-        
-        for (int j = 0; j < this->targetVcsItemsSource.getNumTrackedItems(); ++j)
+        // state item exists in project, adding `changed` record, if needed
+        UniquePointer<Diff> itemDiff(targetItem->getDiffLogic()->createDiff(*stateItem));
+        if (itemDiff->hasAnyChanges())
         {
-            TrackedItem *targetItem = this->targetVcsItemsSource.getTrackedItem(j); // i.e. LayerTreeItem
-            
-            // state item exists in project, adding `changed` record, if needed
-            if (stateItem->getUuid() == targetItem->getUuid())
-            {
-                foundItemInTarget = true;
-                
-                UniquePointer<Diff> itemDiff(targetItem->getDiffLogic()->createDiff(*stateItem));
-                
-                if (itemDiff->hasAnyChanges())
-                {
-                    RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Changed, itemDiff.get()));
-                    const ScopedWriteLock lock(this->diffLock);
-                    this->diff->addItem(revisionRecord);
-                }
-                
-                break;
-            }
+            return new RevisionItem(RevisionItem::Type::Changed, itemDiff.get());
         }
-        
+    }
+    else if (stateItem != nullptr)
+    {
         // state item was not found in project, adding `removed` record
-        if (! foundItemInTarget)
-        {
-            UniquePointer<Diff> emptyDiff(new Diff(*stateItem));
-            RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Removed, emptyDiff.get()));
-            const ScopedWriteLock lock(this->diffLock);
-            this->diff->addItem(revisionRecord);
-        }
+        UniquePointer<Diff> emptyDiff(new Diff(*stateItem));
+        return new RevisionItem(RevisionItem::Type::Removed, emptyDiff.get());
     }
-    
-    // search for project item that are missing (or deleted) in the state
-    for (int i = 0; i < this->targetVcsItemsSource.getNumTrackedItems(); ++i)
+    else if (targetItem != nullptr)
     {
-        bool foundItemInState = false;
-        TrackedItem *targetItem = this->targetVcsItemsSource.getTrackedItem(i);
-        
-        for (int j = 0; j < this->state->getNumTrackedItems(); ++j)
+        // project item is missing (or deleted) in the state, copy its deltas as `added` record
+        return new RevisionItem(RevisionItem::Type::Added, targetItem);
+    }
+
+    return nullptr;
+}
+
+Head::TrackedItemsIndex Head::createTrackedItemsIndex(TrackedItemsSource &source, bool skipRemovedItems)
+{
+    TrackedItemsIndex index;
+    index.reserve(source.getNumTrackedItems());
+
+    for (int i = 0; i < source.getNumTrackedItems(); ++i)
+    {
+        auto *item = source.getTrackedItem(i);
+
+        if (skipRemovedItems)
         {
-            const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(j));
-            
-            if (stateItem->getType() == RevisionItem::Type::Removed) { continue; }
-            
-            if (stateItem->getUuid() == targetItem->getUuid())
+            const auto *revisionItem = dynamic_cast<RevisionItem *>(item);
+            if (revisionItem != nullptr && revisionItem->getType() == RevisionItem::Type::Removed)
             {
-                foundItemInState = true;
-                break;
+                continue;
             }
         }
-        
-        // copy deltas from targetItem and add `added` record
-        if (! foundItemInState)
-        {
-            RevisionItem::Ptr revisionRecord(new RevisionItem(RevisionItem::Type::Added, targetItem));
-            const ScopedWriteLock lock(this->diffLock);
-            this->diff->addItem(revisionRecord);
-        }
+
+        // emplace keeps the first one found, like the linear searches did
+        index.emplace(item->getUuid().toString(), item);
     }
-    
-    this->setDiffOutdated(false);
-    this->setRebuildingDiffMode(false);
-    this->sendChangeMessage();
+
+    return index;
+}
+
+TrackedItem *Head::findTrackedItem(const TrackedItemsIndex &index, const String &uuid)
+{
+    const auto found = index.find(uuid);
+    return (found != index.end()) ? found->second : nullptr;
 }
 
 }
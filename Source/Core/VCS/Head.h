@@ -40,10 +40,18 @@ namespace VCS
         
         Revision::Ptr getDiff() const;
         bool isDiffOutdated() const;
-        void setDiffOutdated(bool isOutdated);
+        void setDiffOutdated(bool isOutdated); // the whole diff will be rebuilt
+
+        // only this item's diff will be rebuilt, nullptr means everything
+        void setItemOutdated(const TrackedItem *item);
 
         bool isRebuildingDiff() const; // mainly for change-listeners
         void setRebuildingDiffMode(bool isBuildingNow);
+
+        // stats of the last finished rebuild, shown on the stage page
+        double getLastRebuildTimeMs() const noexcept;
+        int getLastRebuildNumItems() const noexcept;
+        int getLastRebuildNumThreads() const noexcept;
         
         bool hasAnythingOnTheStage() const;
         bool hasTrackedItemsOnTheStage() const;
@@ -52,6 +60,9 @@ namespace VCS
         bool moveTo(const Revision::Ptr revision); // rebuilds state index
         void pointTo(const Revision::Ptr revision); // does not rebuild index
 
+        // needs to be called whenever the existing revisions are modified
+        void resetCheckpoints();
+
         void checkout();
         void cherryPick(const Array<Uuid> uuids);
         void cherryPickAll();
@@ -68,6 +79,9 @@ namespace VCS
         ValueTree serialize() const override;
         void deserialize(const ValueTree &tree) override;
         void reset() override;
+
+        ValueTree serialize(DeltaDataPool &dataPool) const;
+        void deserialize(const ValueTree &tree, const DeltaDataLookup &dataLookup);
         
         //===--------------------------------------------------------------===//
         // ChangeListener
@@ -82,14 +96,39 @@ namespace VCS
         //===--------------------------------------------------------------===//
 
         void run() override;
-        void checkoutItem(RevisionItem::Ptr stateItem);
-        bool resetChangedItemToState(const RevisionItem::Ptr diffItem);
+
+        // uuid : tracked item, to avoid linear searches by uuid
+        using TrackedItemsIndex = FlatHashMap<String, TrackedItem *, StringHash>;
+        static TrackedItemsIndex createTrackedItemsIndex(TrackedItemsSource &source,
+            bool skipRemovedItems = false);
+        static TrackedItem *findTrackedItem(const TrackedItemsIndex &index, const String &uuid);
+
+        void checkoutItem(RevisionItem::Ptr stateItem, const TrackedItemsIndex &targetIndex);
+        bool resetChangedItemToState(const RevisionItem::Ptr diffItem,
+            const TrackedItemsIndex &stateIndex, const TrackedItemsIndex &targetIndex);
+
+        // returns false, if interrupted by the thread stop
+        bool rebuildDiff(bool canBeInterrupted);
+        void restoreOutdatedItems(const FlatHashSet<String, StringHash> &items, bool rebuildAllItems);
+        static RevisionItem::Ptr createDiffItem(TrackedItem *stateItem, TrackedItem *targetItem);
+
+        class ItemDiffJob;
+        UniquePointer<ThreadPool> diffWorkers;
+
+        Atomic<double> lastRebuildTimeMs;
+        Atomic<int> lastRebuildNumItems;
+        Atomic<int> lastRebuildNumThreads;
 
         ReadWriteLock outdatedMarkerLock;
         bool diffOutdated;
+        FlatHashSet<String, StringHash> outdatedItems;
 
         ReadWriteLock diffLock;
         Revision::Ptr diff;
+
+        // item uuid : its record in the diff, if it has any changes;
+        // only accessed while rebuilding, so that only the outdated items are re-diffed
+        FlatHashMap<String, RevisionItem::Ptr, StringHash> diffItems;
         
         ReadWriteLock rebuildingDiffLock;
         bool rebuildingDiffMode;
@@ -100,6 +139,11 @@ namespace VCS
         ReadWriteLock stateLock;
         UniquePointer<Snapshot> state;
 
+        // revision id : the state at that revision, kept for every
+        // few revisions deep, so that moveTo only needs to replay the
+        // revisions after the nearest checkpoint instead of the whole path
+        FlatHashMap<String, UniquePointer<Snapshot>, StringHash> checkpoints;
+
     private:
 
         TrackedItemsSource &targetVcsItemsSource;
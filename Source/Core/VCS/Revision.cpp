@@ -34,8 +34,11 @@ Revision::Revision(const RevisionDto &dto) :
 
 void Revision::copyDeltasFrom(Revision::Ptr other)
 {
+    const ScopedLock lock(this->itemsLock);
+    this->pendingItems.clear();
+    this->pendingDataLookup = nullptr;
     this->deltas.clearQuick();
-    for (auto *revItem : other->deltas)
+    for (auto *revItem : other->getItems())
     {
         this->deltas.add(revItem);
     }
@@ -43,13 +46,15 @@ void Revision::copyDeltasFrom(Revision::Ptr other)
 
 bool Revision::isEmpty() const noexcept
 {
-    return this->deltas.isEmpty() && this->children.isEmpty();
+    const ScopedLock lock(this->itemsLock);
+    return this->deltas.isEmpty() && this->pendingItems.isEmpty() && this->children.isEmpty();
 }
 
 bool Revision::isShallowCopy() const noexcept
 {
     // children might me not empty though:
-    return this->deltas.isEmpty();
+    const ScopedLock lock(this->itemsLock);
+    return this->deltas.isEmpty() && this->pendingItems.isEmpty();
 }
 
 int64 Revision::getTimeStamp() const noexcept
@@ -69,9 +74,33 @@ String Revision::getMessage() const noexcept
 
 const ReferenceCountedArray<RevisionItem> &Revision::getItems() const noexcept
 {
+    this->loadItemsIfNeeded();
     return this->deltas;
 }
 
+void Revision::loadItemsIfNeeded() const
+{
+    const ScopedLock lock(this->itemsLock);
+
+    if (this->pendingItems.isEmpty())
+    {
+        return;
+    }
+
+    jassert(this->deltas.isEmpty());
+    jassert(this->pendingDataLookup != nullptr);
+
+    for (const auto &e : this->pendingItems)
+    {
+        RevisionItem::Ptr item(new RevisionItem(RevisionItem::Type::Undefined, nullptr));
+        item->deserialize(e, this->pendingDataLookup->lookup);
+        this->deltas.add(item);
+    }
+
+    this->pendingItems.clear();
+    this->pendingDataLookup = nullptr;
+}
+
 const ReferenceCountedArray<Revision> &Revision::getChildren() const  noexcept
 {
     return this->children;
@@ -104,12 +133,14 @@ void Revision::removeChild(Revision::Ptr revision)
 
 void Revision::addItem(RevisionItem *item)
 {
+    this->loadItemsIfNeeded();
+    const ScopedLock lock(this->itemsLock);
     this->deltas.add(item);
 }
 
 void Revision::addItem(RevisionItem::Ptr item)
 {
-    this->deltas.add(item);
+    this->addItem(item.get());
 }
 
 WeakReference<Revision> Revision::getParent() const noexcept
@@ -125,7 +156,7 @@ ValueTree Revision::serializeDeltas() const
 {
     ValueTree tree(Serialization::VCS::revision);
 
-    for (const auto *revItem : this->deltas)
+    for (const auto *revItem : this->getItems())
     {
         tree.appendChild(revItem->serialize(), nullptr);
     }
@@ -143,13 +174,15 @@ void Revision::deserializeDeltas(ValueTree data)
 
     if (!root.isValid()) { return; }
 
+    const ScopedLock lock(this->itemsLock);
+
     this->deltas.clearQuick();
 
     forEachValueTreeChildWithType(root, e, Serialization::VCS::revisionItem)
     {
         RevisionItem::Ptr item(new RevisionItem(RevisionItem::Type::Undefined, nullptr));
         item->deserialize(e, {});
-        this->addItem(item);
+        this->deltas.add(item);
     }
 }
 
@@ -161,7 +194,7 @@ ValueTree Revision::serialize() const
     tree.setProperty(Serialization::VCS::commitMessage, this->message, nullptr);
     tree.setProperty(Serialization::VCS::commitTimeStamp, this->timestamp, nullptr);
 
-    for (const auto *revItem : this->deltas)
+    for (const auto *revItem : this->getItems())
     {
         tree.appendChild(revItem->serialize(), nullptr);
     }
@@ -174,6 +207,42 @@ ValueTree Revision::serialize() const
     return tree;
 }
 
+ValueTree Revision::serialize(DeltaDataPool &dataPool) const
+{
+    ValueTree tree(Serialization::VCS::revision);
+
+    tree.setProperty(Serialization::VCS::commitId, this->id, nullptr);
+    tree.setProperty(Serialization::VCS::commitMessage, this->message, nullptr);
+    tree.setProperty(Serialization::VCS::commitTimeStamp, this->timestamp, nullptr);
+
+    {
+        const ScopedLock lock(this->itemsLock);
+
+        if (!this->pendingItems.isEmpty())
+        {
+            for (const auto &e : this->pendingItems)
+            {
+                tree.appendChild(RevisionItem::repackDeltasData(e,
+                    this->pendingDataLookup->lookup, dataPool), nullptr);
+            }
+        }
+        else
+        {
+            for (const auto *revItem : this->deltas)
+            {
+                tree.appendChild(revItem->serialize(dataPool), nullptr);
+            }
+        }
+    }
+
+    for (const auto *child : this->children)
+    {
+        tree.appendChild(child->serialize(dataPool), nullptr);
+    }
+
+    return tree;
+}
+
 void Revision::deserialize(const ValueTree &tree)
 {
     // Use deserialize/2 workaround (see the comment in VersionControl.cpp)
@@ -181,6 +250,11 @@ void Revision::deserialize(const ValueTree &tree)
 }
 
 void Revision::deserialize(const ValueTree &tree, const DeltaDataLookup &dataLookup)
+{
+    this->deserialize(tree, SharedDataLookup::Ptr(new SharedDataLookup(dataLookup)));
+}
+
+void Revision::deserialize(const ValueTree &tree, SharedDataLookup::Ptr dataLookup)
 {
     this->reset();
 
@@ -194,20 +268,23 @@ void Revision::deserialize(const ValueTree &tree, const DeltaDataLookup &dataLoo
     this->message = root.getProperty(Serialization::VCS::commitMessage);
     this->timestamp = root.getProperty(Serialization::VCS::commitTimeStamp);
 
-    for (const auto &e : root)
+    forEachValueTreeChildWithType(root, e, Serialization::VCS::revision)
     {
-        if (e.hasType(Serialization::VCS::revision))
-        {
-            Revision::Ptr child(new Revision());
-            child->deserialize(e, dataLookup);
-            this->addChild(child);
-        }
-        else if (e.hasType(Serialization::VCS::revisionItem))
-        {
-            RevisionItem::Ptr item(new RevisionItem(RevisionItem::Type::Undefined, nullptr));
-            item->deserialize(e, dataLookup);
-            this->addItem(item);
-        }
+        Revision::Ptr child(new Revision());
+        child->deserialize(e, dataLookup);
+        this->addChild(child);
+    }
+
+    const ScopedLock lock(this->itemsLock);
+
+    forEachValueTreeChildWithType(root, e, Serialization::VCS::revisionItem)
+    {
+        this->pendingItems.add(e);
+    }
+
+    if (!this->pendingItems.isEmpty())
+    {
+        this->pendingDataLookup = dataLookup;
     }
 }
 
@@ -216,8 +293,12 @@ void Revision::reset()
     this->id = {};
     this->message = {};
     this->timestamp = 0;
-    this->deltas.clearQuick();
     this->children.clearQuick();
+
+    const ScopedLock lock(this->itemsLock);
+    this->pendingItems.clear();
+    this->pendingDataLookup = nullptr;
+    this->deltas.clearQuick();
 }
 
 }
@@ -71,6 +71,7 @@ namespace VCS
         void deserializeDeltas(ValueTree data);
 
         ValueTree serialize() const;
+        ValueTree serialize(DeltaDataPool &dataPool) const;
         void deserialize(const ValueTree &tree);
         void deserialize(const ValueTree &tree, const DeltaDataLookup &dataLookup);
         void reset();
@@ -84,7 +85,30 @@ namespace VCS
         int64 timestamp;
 
         ReferenceCountedArray<Revision> children;
-        ReferenceCountedArray<RevisionItem> deltas;
+        mutable ReferenceCountedArray<RevisionItem> deltas;
+
+    private:
+
+        // the lookup is shared by all revisions loaded from the same tree
+        struct SharedDataLookup final : public ReferenceCountedObject
+        {
+            explicit SharedDataLookup(const DeltaDataLookup &lookup) : lookup(lookup) {}
+            const DeltaDataLookup lookup;
+            using Ptr = ReferenceCountedObjectPtr<SharedDataLookup>;
+        };
+
+        void deserialize(const ValueTree &tree, SharedDataLookup::Ptr dataLookup);
+
+        // the revisions loaded from the project file only have their metadata
+        // and children deserialized on startup, and keep their items serialized
+        // until someone needs them (checkout, diff, cherry-pick, etc);
+        // until then, saving the project just re-packs the serialized items;
+        // only the item nodes are kept, not the whole revision subtree, which
+        // would pin the serialized children even after they load their items
+        void loadItemsIfNeeded() const;
+        mutable Array<ValueTree> pendingItems;
+        mutable SharedDataLookup::Ptr pendingDataLookup;
+        CriticalSection itemsLock;
 
         JUCE_DECLARE_WEAK_REFERENCEABLE(Revision)
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Revision)
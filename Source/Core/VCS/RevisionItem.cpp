@@ -17,6 +17,7 @@
 
 #include "Common.h"
 #include "RevisionItem.h"
+#include "DeltaDataPool.h"
 #include "DiffLogic.h"
 
 namespace VCS
@@ -100,7 +101,7 @@ DiffLogic *RevisionItem::getDiffLogic() const noexcept
 // Serializable
 //===----------------------------------------------------------------------===//
 
-ValueTree RevisionItem::serialize() const
+ValueTree RevisionItem::serializeProperties() const
 {
     ValueTree tree(Serialization::VCS::revisionItem);
 
@@ -110,6 +111,46 @@ ValueTree RevisionItem::serialize() const
     tree.setProperty(Serialization::VCS::revisionItemName, this->getVCSName(), nullptr);
     tree.setProperty(Serialization::VCS::revisionItemDiffLogic, this->getDiffLogic()->getType().toString(), nullptr);
 
+    return tree;
+}
+
+ValueTree RevisionItem::serialize(DeltaDataPool &dataPool) const
+{
+    auto tree(this->serializeProperties());
+
+    for (int i = 0; i < this->deltas.size(); ++i)
+    {
+        ValueTree deltaNode(this->deltas.getUnchecked(i)->serialize());
+        const auto dataKey = dataPool.addData(this->getDeltaData(i));
+        deltaNode.setProperty(Serialization::VCS::deltaDataKey, dataKey, nullptr);
+        tree.appendChild(deltaNode, nullptr);
+    }
+
+    return tree;
+}
+
+ValueTree RevisionItem::repackDeltasData(const ValueTree &serializedItem,
+    const DeltaDataLookup &dataLookup, DeltaDataPool &dataPool)
+{
+    ValueTree tree(serializedItem.getType());
+    tree.copyPropertiesFrom(serializedItem, nullptr);
+
+    for (const auto &e : serializedItem)
+    {
+        ValueTree deltaNode(e.getType());
+        deltaNode.copyPropertiesFrom(e, nullptr);
+        const auto dataKey = dataPool.addData(RevisionItem::findDeltaData(e, dataLookup));
+        deltaNode.setProperty(Serialization::VCS::deltaDataKey, dataKey, nullptr);
+        tree.appendChild(deltaNode, nullptr);
+    }
+
+    return tree;
+}
+
+ValueTree RevisionItem::serialize() const
+{
+    auto tree(this->serializeProperties());
+
     for (int i = 0; i < this->deltas.size(); ++i)
     {
         const auto *delta = this->deltas.getUnchecked(i);
@@ -157,28 +198,38 @@ void RevisionItem::deserialize(const ValueTree &tree, const DeltaDataLookup &dat
         UniquePointer<Delta> delta(new Delta({}, {}));
         delta->deserialize(e);
 
-        // either we already have saved data, or the lookup table is provided:
-        jassert((e.getNumChildren() == 0 && dataLookup.size() > 0) || (e.getNumChildren() == 1 && dataLookup.size() == 0));
-
-        if (e.getNumChildren() == 1)
-        {
-            this->deltasData.add(e.getChild(0));
-        }
-        else
-        {
-            const String deltaId = e.getProperty(Serialization::VCS::deltaId);
-            if (dataLookup.contains(deltaId))
-            {
-                const auto data = dataLookup.at(deltaId);
-                this->deltasData.add(data);
-            }
-        }
-
+        this->deltasData.add(RevisionItem::findDeltaData(e, dataLookup));
         this->deltas.add(delta.release());
         jassert(this->deltasData.size() == this->deltas.size());
     }
 }
 
+ValueTree RevisionItem::findDeltaData(const ValueTree &deltaNode,
+    const DeltaDataLookup &dataLookup)
+{
+    // the data is either referenced by its key in the pool,
+    // or saved inline, or (in the legacy format) looked up by the delta id:
+    const String dataKey = deltaNode.getProperty(Serialization::VCS::deltaDataKey);
+    if (dataKey.isNotEmpty() && dataLookup.contains(dataKey))
+    {
+        return dataLookup.at(dataKey);
+    }
+
+    if (deltaNode.getNumChildren() == 1)
+    {
+        return deltaNode.getChild(0);
+    }
+
+    const String deltaId = deltaNode.getProperty(Serialization::VCS::deltaId);
+    if (dataLookup.contains(deltaId))
+    {
+        return dataLookup.at(deltaId);
+    }
+
+    jassertfalse; // the data is missing, but keep the indices in sync anyway
+    return {};
+}
+
 void RevisionItem::reset()
 {
     this->deltas.clear();
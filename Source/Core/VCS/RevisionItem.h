@@ -21,6 +21,8 @@
 
 namespace VCS
 {
+    class DeltaDataPool;
+
     class RevisionItem :
         public TrackedItem,
         public Serializable,
@@ -62,10 +64,22 @@ namespace VCS
         void deserialize(const ValueTree &tree, const DeltaDataLookup &dataLookup);
         void reset() override;
 
+        // deltas only refer to their data by the key in the pool:
+        ValueTree serialize(DeltaDataPool &dataPool) const;
+
+        // same as above, but for the item which is not deserialized yet
+        static ValueTree repackDeltasData(const ValueTree &serializedItem,
+            const DeltaDataLookup &dataLookup, DeltaDataPool &dataPool);
+
         using Ptr = ReferenceCountedObjectPtr<RevisionItem>;
 
     private:
 
+        ValueTree serializeProperties() const;
+
+        static ValueTree findDeltaData(const ValueTree &deltaNode,
+            const DeltaDataLookup &dataLookup);
+
         OwnedArray<Delta> deltas;
         Array<ValueTree> deltasData;
         UniquePointer<DiffLogic> logic;
@@ -25,55 +25,58 @@ namespace VCS
 {
 
 Snapshot::Snapshot(const Snapshot &other) :
-    items(other.items) {}
+    items(other.items),
+    itemsLookup(other.itemsLookup) {}
 
 Snapshot::Snapshot(const Snapshot *other) :
-    items(other->items) {}
+    items(other->items),
+    itemsLookup(other->itemsLookup) {}
 
 void Snapshot::addItem(RevisionItem::Ptr item)
 {
-    RevisionItem::Ptr ownItem = this->getItemWithSameUuid(item);
+    const int ownItemIndex = this->indexOfItemWithUuid(item->getUuid());
 
-    if (ownItem == nullptr)
+    if (ownItemIndex < 0)
     {
-        this->items.addIfNotAlreadyThere(item);
+        this->itemsLookup[item->getUuid().toString()] = this->items.size();
+        this->items.add(item);
     }
     else
     {
         // ситуация, когда в состоянии есть removed запись, которую нужно заменить на added
-        this->items.removeAllInstancesOf(ownItem);
-        this->items.addIfNotAlreadyThere(item);
+        this->replaceItem(ownItemIndex, item);
     }
 }
 
 void Snapshot::removeItem(RevisionItem::Ptr item)
 {
-    this->items.removeAllInstancesOf(item);
+    const int ownItemIndex = this->indexOfItemWithUuid(item->getUuid());
 
-    RevisionItem::Ptr ownItem = this->getItemWithSameUuid(item);
-
-    if (ownItem != nullptr)
+    if (ownItemIndex >= 0)
     {
-        this->items.removeAllInstancesOf(ownItem);
+        // removed-запись на месте удаляемого айтема
+        this->replaceItem(ownItemIndex, item);
+    }
+    else
+    {
+        this->itemsLookup[item->getUuid().toString()] = this->items.size();
+        this->items.add(item);
     }
-
-    // removed-запись
-    this->items.addIfNotAlreadyThere(item);
 }
 
 void Snapshot::mergeItem(RevisionItem::Ptr newItem)
 {
-    RevisionItem::Ptr stateItem = this->getItemWithSameUuid(newItem);
+    const int stateItemIndex = this->indexOfItemWithUuid(newItem->getUuid());
 
-    if (stateItem != nullptr) // есть куда мержить
+    if (stateItemIndex >= 0) // есть куда мержить
     {
+        RevisionItem::Ptr stateItem = this->items.getUnchecked(stateItemIndex);
         UniquePointer<Diff> diff(newItem->getDiffLogic()->createMergedItem(*stateItem));
 
         if (diff->hasAnyChanges())
         {
             RevisionItem::Ptr mergedItem(new RevisionItem(stateItem->getType(), diff.get()));
-            this->items.removeAllInstancesOf(stateItem);
-            this->items.add(mergedItem);
+            this->replaceItem(stateItemIndex, mergedItem);
         }
     }
     else
@@ -83,6 +86,15 @@ void Snapshot::mergeItem(RevisionItem::Ptr newItem)
     }
 }
 
+void Snapshot::replaceItem(int index, RevisionItem::Ptr newItem)
+{
+    jassert(this->items[index]->getUuid() == newItem->getUuid());
+
+    // items are replaced in place, so that the diff order is stable,
+    // and the lookup, which refers to their indices, stays valid
+    this->items.set(index, newItem);
+}
+
 //===----------------------------------------------------------------------===//
 // TrackedItemsSource
 //===----------------------------------------------------------------------===//
@@ -97,22 +109,16 @@ TrackedItem *Snapshot::getTrackedItem(int index) noexcept
     return this->items[index].get();
 }
 
-RevisionItem::Ptr Snapshot::getItemWithSameUuid(RevisionItem::Ptr item) const
+int Snapshot::indexOfItemWithUuid(const Uuid &uuid) const
 {
-    return this->getItemWithUuid(item->getUuid());
+    const auto found = this->itemsLookup.find(uuid.toString());
+    return (found != this->itemsLookup.end()) ? found->second : -1;
 }
 
 RevisionItem::Ptr Snapshot::getItemWithUuid(const Uuid &uuid) const
 {
-    for (auto &item : this->items)
-    {
-        if (item->getUuid() == uuid)
-        {
-            return item;
-        }
-    }
-
-    return nullptr;
+    const int index = this->indexOfItemWithUuid(uuid);
+    return (index >= 0) ? this->items.getUnchecked(index) : nullptr;
 }
 
 }
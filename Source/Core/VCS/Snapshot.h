@@ -52,10 +52,15 @@ namespace VCS
 
     private:
 
-        RevisionItem::Ptr getItemWithSameUuid(RevisionItem::Ptr item) const;
+        int indexOfItemWithUuid(const Uuid &uuid) const;
+        void replaceItem(int index, RevisionItem::Ptr newItem);
 
         Array<RevisionItem::Ptr> items;
 
+        // uuid : index in items, to find and replace items without a linear search;
+        // items are never removed from a snapshot, so the indices stay valid
+        FlatHashMap<String, int, StringHash> itemsLookup;
+
         JUCE_LEAK_DETECTOR(Snapshot);
 
     };
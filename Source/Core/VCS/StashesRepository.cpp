@@ -106,6 +106,23 @@ ValueTree StashesRepository::serialize() const
     return tree;
 }
 
+ValueTree StashesRepository::serialize(DeltaDataPool &dataPool) const
+{
+    ValueTree tree(Serialization::VCS::stashesRepository);
+
+    ValueTree userStashesXml(Serialization::VCS::userStashes);
+    tree.appendChild(userStashesXml, nullptr);
+
+    userStashesXml.appendChild(this->userStashes->serialize(dataPool), nullptr);
+
+    ValueTree quickStashXml(Serialization::VCS::quickStash);
+    tree.appendChild(quickStashXml, nullptr);
+
+    quickStashXml.appendChild(this->quickStash->serialize(dataPool), nullptr);
+
+    return tree;
+}
+
 void StashesRepository::deserialize(const ValueTree &tree)
 {
     // Use deserialize/2 workaround (see the comment in VersionControl.cpp)
@@ -45,6 +45,7 @@ namespace VCS
         //===--------------------------------------------------------------===//
 
         ValueTree serialize() const override;
+        ValueTree serialize(DeltaDataPool &dataPool) const;
         void deserialize(const ValueTree &tree) override;
         void deserialize(const ValueTree &tree, const DeltaDataLookup &dataLookup);
         void reset() override;
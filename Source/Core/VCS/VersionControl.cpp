@@ -19,7 +19,12 @@
 #include "VersionControl.h"
 #include "VersionControlEditor.h"
 #include "TrackedItem.h"
+#include "DeltaDataPool.h"
 #include "MidiSequence.h"
+#include "Pattern.h"
+#include "ProjectNode.h"
+#include "ProjectTimeline.h"
+#include "ProjectInfo.h"
 #include "SerializationKeys.h"
 #include "SerializationKeys.h"
 #include "Network.h"
@@ -56,6 +61,7 @@ void VersionControl::moveHead(const VCS::Revision::Ptr revision)
     if (! revision->isEmpty())
     {
         this->head.moveTo(revision);
+        this->resetSerializationCache();
         this->sendChangeMessage();
     }
 }
@@ -66,6 +72,7 @@ void VersionControl::checkout(const VCS::Revision::Ptr revision)
     {
         this->head.moveTo(revision);
         this->head.checkout();
+        this->resetSerializationCache();
         this->sendChangeMessage();
     }
 }
@@ -78,6 +85,7 @@ void VersionControl::cherryPick(const VCS::Revision::Ptr revision, const Array<U
         this->head.moveTo(revision);
         this->head.cherryPick(uuids);
         this->head.moveTo(headRevision);
+        this->resetSerializationCache();
         this->sendChangeMessage();
     }
 }
@@ -89,7 +97,9 @@ void VersionControl::replaceHistory(const VCS::Revision::Ptr root)
     DBG("Replacing history tree");
     this->rootRevision = root;
     // make sure head doesn't point to replaced revision:
+    this->head.resetCheckpoints();
     this->head.moveTo(this->rootRevision);
+    this->resetSerializationCache();
     this->sendChangeMessage();
 }
 
@@ -99,6 +109,7 @@ void VersionControl::appendSubtree(const VCS::Revision::Ptr subtree, const Strin
     if (auto targetRevision = this->getRevisionById(this->rootRevision, appendRevisionId))
     {
         targetRevision->addChild(subtree);
+        this->resetSerializationCache();
         this->sendChangeMessage();
     }
 }
@@ -110,6 +121,7 @@ VCS::Revision::Ptr VersionControl::updateShallowRevisionData(const String &id, c
         if (revision->isShallowCopy())
         {
             revision->deserializeDeltas(data);
+            this->resetSerializationCache();
             this->sendChangeMessage();
         }
 
@@ -126,7 +138,9 @@ void VersionControl::quickAmendItem(VCS::TrackedItem *targetItem)
     // changes and deletions to committed items will not work:
     VCS::RevisionItem::Ptr revisionRecord(new VCS::RevisionItem(VCS::RevisionItem::Type::Added, targetItem));
     this->head.getHeadingRevision()->addItem(revisionRecord);
+    this->head.resetCheckpoints();
     this->head.moveTo(this->head.getHeadingRevision());
+    this->resetSerializationCache();
     this->sendChangeMessage();
 }
 
@@ -147,6 +161,7 @@ bool VersionControl::resetChanges(SparseSet<int> selectedItems)
         }
     }
 
+    this->resetSerializationCache();
     this->head.resetChanges(changesToReset);
     return true;
 }
@@ -161,6 +176,7 @@ bool VersionControl::resetAllChanges()
         changesToReset.add(item);
     }
     
+    this->resetSerializationCache();
     this->head.resetChanges(changesToReset);
     return true;
 }
@@ -188,6 +204,7 @@ bool VersionControl::commit(SparseSet<int> selectedItems, const String &message)
     headingRevision->addChild(newRevision);
     this->head.moveTo(newRevision);
 
+    this->resetSerializationCache();
     this->sendChangeMessage();
     return true;
 }
@@ -219,6 +236,7 @@ bool VersionControl::stash(SparseSet<int> selectedItems,
         this->resetChanges(selectedItems);
     }
     
+    this->resetSerializationCache();
     this->sendChangeMessage();
     return true;
 }
@@ -237,6 +255,7 @@ bool VersionControl::applyStash(const VCS::Revision::Ptr stash, bool shouldKeepS
             this->stashes->removeStash(stash);
         }
         
+        this->resetSerializationCache();
         this->sendChangeMessage();
         return true;
     }
@@ -263,6 +282,7 @@ bool VersionControl::quickStashAll()
     this->stashes->storeQuickStash(allChanges);
     this->resetAllChanges();
 
+    this->resetSerializationCache();
     this->sendChangeMessage();
     return true;
 }
@@ -277,18 +297,114 @@ bool VersionControl::applyQuickStash()
     tempHead.cherryPickAll();
     this->stashes->resetQuickStash();
     
+    this->resetSerializationCache();
     this->sendChangeMessage();
     return true;
 }
 
 //===----------------------------------------------------------------------===//
-// ChangeListener
+// ProjectListener
 //===----------------------------------------------------------------------===//
 
-void VersionControl::changeListenerCallback(ChangeBroadcaster* source)
+// Timeline tracks are not tracked items themselves, the timeline is;
+// returns nullptr when unsure, so that the whole diff will be rebuilt
+static VCS::TrackedItem *findTrackedItemFor(MidiTrack *const track, ProjectNode *project)
 {
-    // Project changed
-    this->getHead().setDiffOutdated(true);
+    if (auto *trackedItem = dynamic_cast<VCS::TrackedItem *>(track))
+    {
+        return trackedItem;
+    }
+
+    if (project != nullptr && track != nullptr)
+    {
+        auto *timeline = project->getTimeline();
+        if (track == timeline->getAnnotations() ||
+            track == timeline->getTimeSignatures() ||
+            track == timeline->getKeySignatures())
+        {
+            return timeline;
+        }
+    }
+
+    return nullptr;
+}
+
+static VCS::TrackedItem *findTrackedItemFor(const MidiSequence *sequence)
+{
+    return (sequence != nullptr) ?
+        findTrackedItemFor(sequence->getTrack(), sequence->getProject()) : nullptr;
+}
+
+static VCS::TrackedItem *findTrackedItemFor(const Pattern *pattern)
+{
+    return (pattern != nullptr) ?
+        findTrackedItemFor(pattern->getTrack(), pattern->getProject()) : nullptr;
+}
+
+void VersionControl::onAddMidiEvent(const MidiEvent &event)
+{
+    this->head.setItemOutdated(findTrackedItemFor(event.getSequence()));
+}
+
+void VersionControl::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &newEvent)
+{
+    this->head.setItemOutdated(findTrackedItemFor(newEvent.getSequence()));
+}
+
+void VersionControl::onRemoveMidiEvent(const MidiEvent &event)
+{
+    this->head.setItemOutdated(findTrackedItemFor(event.getSequence()));
+}
+
+void VersionControl::onPostRemoveMidiEvent(MidiSequence *const layer)
+{
+    this->head.setItemOutdated(findTrackedItemFor(layer));
+}
+
+void VersionControl::onAddClip(const Clip &clip)
+{
+    this->head.setItemOutdated(findTrackedItemFor(clip.getPattern()));
+}
+
+void VersionControl::onChangeClip(const Clip &oldClip, const Clip &newClip)
+{
+    this->head.setItemOutdated(findTrackedItemFor(newClip.getPattern()));
+}
+
+void VersionControl::onRemoveClip(const Clip &clip)
+{
+    this->head.setItemOutdated(findTrackedItemFor(clip.getPattern()));
+}
+
+void VersionControl::onPostRemoveClip(Pattern *const pattern)
+{
+    this->head.setItemOutdated(findTrackedItemFor(pattern));
+}
+
+void VersionControl::onAddTrack(MidiTrack *const track)
+{
+    // a new track might not have its vcs uuid deserialized yet
+    this->head.setDiffOutdated(true);
+}
+
+void VersionControl::onRemoveTrack(MidiTrack *const track)
+{
+    this->head.setItemOutdated(findTrackedItemFor(track, nullptr));
+}
+
+void VersionControl::onChangeTrackProperties(MidiTrack *const track)
+{
+    this->head.setItemOutdated(findTrackedItemFor(track, nullptr));
+}
+
+void VersionControl::onChangeProjectInfo(const ProjectInfo *info)
+{
+    this->head.setItemOutdated(info);
+}
+
+void VersionControl::onReloadProjectContent(const Array<MidiTrack *> &tracks)
+{
+    this->head.setDiffOutdated(true);
 }
 
 //===----------------------------------------------------------------------===//
@@ -351,12 +467,14 @@ void VersionControl::pullBranch(const VCS::Revision::Ptr leaf)
 void VersionControl::updateLocalSyncCache(const VCS::Revision::Ptr revision)
 {
     this->remoteCache.updateForLocalRevision(revision);
+    this->resetSerializationCache();
     this->sendChangeMessage();
 }
 
 void VersionControl::updateRemoteSyncCache(const Array<RevisionDto> &revisions)
 {
     this->remoteCache.updateForRemoteRevisions(revisions);
+    this->resetSerializationCache();
     this->sendChangeMessage();
 }
 
@@ -380,15 +498,30 @@ VCS::Revision::SyncState VersionControl::getRevisionSyncState(const VCS::Revisio
 
 ValueTree VersionControl::serialize() const
 {
+    // the history only changes via the methods above, which reset the cache,
+    // so that autosaves don't rebuild and re-hash the whole history each time;
+    // a tree cannot have two parents, so if the previous save
+    // is still holding the cached tree, it has to be copied:
+    if (this->serializationCache.isValid())
+    {
+        return this->serializationCache.getParent().isValid() ?
+            this->serializationCache.createCopy() : this->serializationCache;
+    }
+
     ValueTree tree(Serialization::Core::versionControl);
 
     tree.setProperty(Serialization::VCS::headRevisionId, this->head.getHeadingRevision()->getUuid(), nullptr);
     
-    tree.appendChild(this->rootRevision->serialize(), nullptr);
-    tree.appendChild(this->stashes->serialize(), nullptr);
-    tree.appendChild(this->head.serialize(), nullptr);
+    // all deltas data goes to the pool, where each unique blob is stored once,
+    // and the revisions, stashes and head snapshot only refer to it by key
+    VCS::DeltaDataPool deltaDataPool;
+    tree.appendChild(this->rootRevision->serialize(deltaDataPool), nullptr);
+    tree.appendChild(this->stashes->serialize(deltaDataPool), nullptr);
+    tree.appendChild(this->head.serialize(deltaDataPool), nullptr);
     tree.appendChild(this->remoteCache.serialize(), nullptr);
+    tree.appendChild(deltaDataPool.serialize(), nullptr);
 
+    this->serializationCache = tree;
     return tree;
 }
 
@@ -404,7 +537,12 @@ void VersionControl::deserialize(const ValueTree &tree)
     const String headId = root.getProperty(Serialization::VCS::headRevisionId);
     DBG("Head ID is " + headId);
 
-    VCS::DeltaDataLookup deltaDataLookup;
+    VCS::DeltaDataPool deltaDataPool;
+    deltaDataPool.deserialize(root);
+
+    // keys of the pool are content hashes, so they never clash with the
+    // delta ids used as the keys in the legacy format, see the hack below
+    VCS::DeltaDataLookup deltaDataLookup(deltaDataPool.getLookup());
     const auto packNode = root.hasType(Serialization::VCS::pack) ?
         root : root.getChildWithName(Serialization::VCS::pack);
 
@@ -436,8 +574,15 @@ void VersionControl::deserialize(const ValueTree &tree)
         }
     }
 
-    this->rootRevision->deserialize(root, deltaDataLookup);
-    this->stashes->deserialize(root, deltaDataLookup);
+    {
+#if DEBUG
+        const double historyLoadStart = Time::getMillisecondCounterHiRes();
+#endif
+        // only the revisions' metadata is loaded here, the items are loaded on demand:
+        this->rootRevision->deserialize(root, deltaDataLookup);
+        this->stashes->deserialize(root, deltaDataLookup);
+        DBG("Loading VCS history done in " + String(Time::getMillisecondCounterHiRes() - historyLoadStart) + "ms");
+    }
 
     this->remoteCache.deserialize(root);
 
@@ -445,7 +590,7 @@ void VersionControl::deserialize(const ValueTree &tree)
 #if DEBUG
         const double headLoadStart = Time::getMillisecondCounterHiRes();
 #endif
-        this->head.deserialize(root);
+        this->head.deserialize(root, deltaDataLookup);
         DBG("Loading VCS snapshot done in " + String(Time::getMillisecondCounterHiRes() - headLoadStart) + "ms");
     }
     
@@ -457,6 +602,7 @@ void VersionControl::deserialize(const ValueTree &tree)
 
 void VersionControl::reset()
 {
+    this->resetSerializationCache();
     this->rootRevision->reset();
     this->head.reset();
     this->remoteCache.reset();
@@ -467,6 +613,11 @@ void VersionControl::reset()
 // Private
 //===----------------------------------------------------------------------===//
 
+void VersionControl::resetSerializationCache() noexcept
+{
+    this->serializationCache = {};
+}
+
 VCS::Revision::Ptr VersionControl::getRevisionById(const VCS::Revision::Ptr startFrom, const String &id) const
 {
     if (startFrom->getUuid() == id)
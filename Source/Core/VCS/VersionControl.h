@@ -32,7 +32,7 @@ class VersionControlEditor;
 
 class VersionControl final :
     public Serializable,
-    public ChangeListener,
+    public ProjectListener, // marks the changed items' diffs outdated
     public ChangeBroadcaster
 {
 public:
@@ -100,10 +100,27 @@ public:
     void reset() override;
 
     //===------------------------------------------------------------------===//
-    // ChangeListener
+    // ProjectListener
     //===------------------------------------------------------------------===//
 
-    void changeListenerCallback(ChangeBroadcaster *source) override;
+    void onAddMidiEvent(const MidiEvent &event) override;
+    void onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &newEvent) override;
+    void onRemoveMidiEvent(const MidiEvent &event) override;
+    void onPostRemoveMidiEvent(MidiSequence *const layer) override;
+
+    void onAddClip(const Clip &clip) override;
+    void onChangeClip(const Clip &oldClip, const Clip &newClip) override;
+    void onRemoveClip(const Clip &clip) override;
+    void onPostRemoveClip(Pattern *const pattern) override;
+
+    void onAddTrack(MidiTrack *const track) override;
+    void onRemoveTrack(MidiTrack *const track) override;
+    void onChangeTrackProperties(MidiTrack *const track) override;
+
+    void onChangeProjectInfo(const ProjectInfo *info) override;
+    void onChangeProjectBeatRange(float firstBeat, float lastBeat) override {}
+    void onChangeViewBeatRange(float firstBeat, float lastBeat) override {}
+    void onReloadProjectContent(const Array<MidiTrack *> &tracks) override;
     
 protected:
 
@@ -118,6 +135,10 @@ private:
 
     VCS::TrackedItemsSource &parent;
 
+    // the last serialized tree, reused by autosaves until the history changes
+    void resetSerializationCache() noexcept;
+    mutable ValueTree serializationCache;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VersionControl)
     JUCE_DECLARE_WEAK_REFERENCEABLE(VersionControl)
 };
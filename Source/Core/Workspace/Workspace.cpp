@@ -58,6 +58,25 @@ void Workspace::init()
     }
 }
 
+void Workspace::initAudioCoreOnly()
+{
+    if (this->audioCore == nullptr)
+    {
+        this->audioCore.reset(new AudioCore());
+
+        if (App::Config().containsProperty(Serialization::Config::activeWorkspace))
+        {
+            // audio core will pick its own subtree from the workspace
+            App::Config().load(this->audioCore.get(), Serialization::Config::activeWorkspace);
+        }
+        else
+        {
+            this->audioCore->autodetectDeviceSetup();
+            this->audioCore->initDefaultInstrument();
+        }
+    }
+}
+
 bool Workspace::isInitialized() const noexcept
 {
     return this->wasInitialized;
@@ -281,6 +300,11 @@ void Workspace::unloadProject(const String &projectId, bool deleteLocally, bool
 
 Array<ProjectNode *> Workspace::getLoadedProjects() const
 {
+    if (this->treeRoot == nullptr)
+    {
+        return {}; // the audio-only workspace has no tree
+    }
+
     return this->treeRoot->findChildrenOfType<ProjectNode>();
 }
 
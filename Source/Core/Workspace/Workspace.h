@@ -35,6 +35,10 @@ public:
 
     void init();
     void shutdown();
+
+    // Only creates the audio core with the saved instruments, without the tree
+    // and pages, and never saves the workspace back; used by non-GUI run modes
+    void initAudioCoreOnly();
     bool isInitialized() const noexcept;
     void stopPlaybackForAllProjects(); // on app suspend / shutdown
 
@@ -150,6 +150,9 @@ int CommandIDs::getIdForName(const String &command)
         CASE_FOR(SelectSampleRate)
         CASE_FOR(SelectBufferSize)
         CASE_FOR(SelectFont)
+        CASE_FOR(SelectRenderBitDepth)
+        CASE_FOR(SelectRenderBlockSize)
+        CASE_FOR(ToggleRenderDoublePrecision)
         CASE_FOR(EditModeDefault)
         CASE_FOR(EditModeDraw)
         CASE_FOR(EditModePan)
@@ -186,6 +186,9 @@ namespace CommandIDs
         SelectSampleRate                = 0x3600,
         SelectBufferSize                = 0x3700, // more ids reserved for sub-items
         SelectFont                      = 0x3800, // more ids reserved for sub-items
+        SelectRenderBitDepth            = 0x3900, // more ids reserved for sub-items
+        SelectRenderBlockSize           = 0x3910, // more ids reserved for sub-items
+        ToggleRenderDoublePrecision     = 0x3920,
 
         EditModeDefault                 = 0x4000,
         EditModeDraw                    = 0x4001,
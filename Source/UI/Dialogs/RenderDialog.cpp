@@ -31,6 +31,11 @@
 #include "FailTooltip.h"
 #include "MenuItemComponent.h"
 #include "CommandIDs.h"
+#include "SerializationKeys.h"
+#include "Config.h"
+
+static const int renderBitDepths[] = { 16, 24, 32 };
+static const int renderBlockSizes[] = { 256, 512, 1024, 2048, 4096, 8192 };
 //[/MiscUserDefs]
 
 RenderDialog::RenderDialog(ProjectNode &parentProject, const File &renderTo, const String &formatExtension)
@@ -92,6 +97,16 @@ RenderDialog::RenderDialog(ProjectNode &parentProject, const File &renderTo, con
     this->separatorH.reset(new SeparatorHorizontal());
     this->addAndMakeVisible(separatorH.get());
 
+    this->settingsComboPrimer.reset(new MobileComboBox::Primer());
+    this->addAndMakeVisible(settingsComboPrimer.get());
+
+    this->settingsEditor.reset(new Label(String(),
+                                          String()));
+    this->addAndMakeVisible(settingsEditor.get());
+    this->settingsEditor->setFont(Font (16.00f, Font::plain).withTypefaceStyle ("Regular"));
+    settingsEditor->setJustificationType(Justification::centredLeft);
+    settingsEditor->setEditable(false, false, false);
+
     //[UserPreSize]
     this->renderButton->setButtonText(TRANS(I18n::Dialog::renderProceed));
     this->cancelButton->setButtonText(TRANS(I18n::Dialog::renderClose));
@@ -115,10 +130,16 @@ RenderDialog::RenderDialog(ProjectNode &parentProject, const File &renderTo, con
 #endif
     //[/UserPreSize]
 
-    this->setSize(520, 224);
+    this->setSize(520, 264);
 
     //[Constructor]
     this->updatePosition();
+
+    App::Config().load(&this->renderSettings, Serialization::Config::lastUsedRenderSettings);
+    this->settingsEditor->setInterceptsMouseClicks(false, true);
+    MenuPanel::Menu emptyMenu;
+    this->settingsComboPrimer->initWith(this->settingsEditor.get(), emptyMenu);
+    this->syncRenderSettingsMenu();
     //[/Constructor]
 }
 
@@ -138,6 +159,8 @@ RenderDialog::~RenderDialog()
     pathEditor = nullptr;
     component3 = nullptr;
     separatorH = nullptr;
+    settingsComboPrimer = nullptr;
+    settingsEditor = nullptr;
 
     //[Destructor]
     //[/Destructor]
@@ -176,6 +199,8 @@ void RenderDialog::resized()
     browseButton->setBounds(getWidth() - 448 - 48, 59, 48, 48);
     pathEditor->setBounds((getWidth() / 2) + 25 - (406 / 2), 4 + 48, 406, 24);
     separatorH->setBounds(4, getHeight() - 52 - 2, getWidth() - 8, 2);
+    settingsComboPrimer->setBounds((getWidth() / 2) - ((getWidth() - 24) / 2), 12, getWidth() - 24, getHeight() - 72);
+    settingsEditor->setBounds((getWidth() / 2) + 25 - (406 / 2), 164, 406, 32);
     //[UserResized] Add your own custom resize handling here..
     //[/UserResized]
 }
@@ -278,6 +303,26 @@ void RenderDialog::handleCommandMessage (int commandId)
         this->shouldRenderAfterDialogCompletes = false;
 #endif
     }
+    else if (commandId == CommandIDs::ToggleRenderDoublePrecision)
+    {
+        this->renderSettings.setDoublePrecision(!this->renderSettings.shouldUseDoublePrecision());
+        this->syncRenderSettingsMenu();
+    }
+    else
+    {
+        const int bitDepthIndex = commandId - CommandIDs::SelectRenderBitDepth;
+        const int blockSizeIndex = commandId - CommandIDs::SelectRenderBlockSize;
+        if (bitDepthIndex >= 0 && bitDepthIndex < numElementsInArray(renderBitDepths))
+        {
+            this->renderSettings.setBitDepth(renderBitDepths[bitDepthIndex]);
+            this->syncRenderSettingsMenu();
+        }
+        else if (blockSizeIndex >= 0 && blockSizeIndex < numElementsInArray(renderBlockSizes))
+        {
+            this->renderSettings.setBlockSize(renderBlockSizes[blockSizeIndex]);
+            this->syncRenderSettingsMenu();
+        }
+    }
     //[/UserCode_handleCommandMessage]
 }
 
@@ -304,7 +349,8 @@ void RenderDialog::startOrAbortRender()
 
     if (! transport.isRendering())
     {
-        transport.startRender(this->getFileName());
+        App::Config().save(&this->renderSettings, Serialization::Config::lastUsedRenderSettings);
+        transport.startRender(this->getFileName(), this->renderSettings);
         this->startTrackingProgress();
     }
     else
@@ -341,11 +387,21 @@ void RenderDialog::timerCallback()
     {
         const float percentsDone = transport.getRenderingPercentsComplete();
         this->slider->setValue(percentsDone, dontSendNotification);
+        this->updateStageTimings();
     }
     else
     {
         this->stopTrackingProgress();
-        App::Layout().showModalComponentUnowned(new SuccessTooltip());
+
+        if (transport.hasRenderFailed())
+        {
+            App::Layout().showModalComponentUnowned(new FailTooltip());
+        }
+        else
+        {
+            App::Layout().showModalComponentUnowned(new SuccessTooltip());
+        }
+
         transport.stopRender();
     }
 }
@@ -365,12 +421,64 @@ void RenderDialog::stopTrackingProgress()
     Transport &transport = this->project.getTransport();
     const float percentsDone = transport.getRenderingPercentsComplete();
     this->slider->setValue(percentsDone, dontSendNotification);
+    // the final timings are shown until the settings are changed
+    this->updateStageTimings();
 
     this->animator.fadeOut(this->indicator.get(), 250);
     this->indicator->stopAnimating();
     this->renderButton->setButtonText(TRANS(I18n::Dialog::renderProceed));
 }
 
+void RenderDialog::syncRenderSettingsMenu()
+{
+    // flac has no floating point samples, see RendererThread
+    const bool supportsFloatOutput = (this->extension == "wav");
+    const bool isFloatOutput = supportsFloatOutput && this->renderSettings.isFloatOutput();
+    const int bitDepth = isFloatOutput ? 32 : jmin(this->renderSettings.getBitDepth(), 24);
+    const int blockSize = this->renderSettings.getBlockSize();
+
+    MenuPanel::Menu menu;
+
+    for (int i = 0; i < numElementsInArray(renderBitDepths); ++i)
+    {
+        if (renderBitDepths[i] == 32 && !supportsFloatOutput)
+        {
+            continue;
+        }
+
+        menu.add(MenuItem::item(renderBitDepths[i] == bitDepth ? Icons::apply : Icons::empty,
+            CommandIDs::SelectRenderBitDepth + i,
+            String(renderBitDepths[i]) + (renderBitDepths[i] == 32 ? " bit float" : " bit")));
+    }
+
+    for (int i = 0; i < numElementsInArray(renderBlockSizes); ++i)
+    {
+        menu.add(MenuItem::item(renderBlockSizes[i] == blockSize ? Icons::apply : Icons::empty,
+            CommandIDs::SelectRenderBlockSize + i,
+            TRANS(I18n::Settings::audioBufferSize) + ": " + String(renderBlockSizes[i])));
+    }
+
+    const bool usesDoublePrecision = this->renderSettings.shouldUseDoublePrecision();
+    menu.add(MenuItem::item(usesDoublePrecision ? Icons::apply : Icons::empty,
+        CommandIDs::ToggleRenderDoublePrecision, "64 bit processing"));
+
+    this->settingsEditor->setText(String(bitDepth) + (isFloatOutput ? " bit float, " : " bit, ") +
+        TRANS(I18n::Settings::audioBufferSize).toLowerCase() + " " + String(blockSize) +
+        (usesDoublePrecision ? ", 64 bit processing" : ""), dontSendNotification);
+
+    this->settingsComboPrimer->updateMenu(menu);
+}
+
+// While rendering, the settings label shows where the time goes
+void RenderDialog::updateStageTimings()
+{
+    const auto timings = this->project.getTransport().getRenderingStageTimings();
+    this->settingsEditor->setText("process " + String(timings.processMs / 1000.0, 1) +
+        " s, mix " + String(timings.mixMs / 1000.0, 1) +
+        " s, encode " + String(timings.encodeMs / 1000.0, 1) +
+        " s, write " + String(timings.writeMs / 1000.0, 1) + " s", dontSendNotification);
+}
+
 //[/MiscUserCode]
 
 #if 0
@@ -382,7 +490,7 @@ BEGIN_JUCER_METADATA
                  constructorParams="ProjectNode &amp;parentProject, const File &amp;renderTo, const String &amp;formatExtension"
                  variableInitialisers="project(parentProject),&#10;extension(formatExtension.toLowerCase()),&#10;shouldRenderAfterDialogCompletes(false)"
                  snapPixels="8" snapActive="1" snapShown="1" overlayOpacity="0.330"
-                 fixedSize="1" initialWidth="520" initialHeight="224">
+                 fixedSize="1" initialWidth="520" initialHeight="264">
   <METHODS>
     <METHOD name="parentHierarchyChanged()"/>
     <METHOD name="parentSizeChanged()"/>
@@ -433,6 +541,13 @@ BEGIN_JUCER_METADATA
   <JUCERCOMP name="" id="e39d9e103e2a60e6" memberName="separatorH" virtualName=""
              explicitFocusOrder="0" pos="4 52Rr 8M 2" sourceFile="../Themes/SeparatorHorizontal.cpp"
              constructorParams=""/>
+  <GENERICCOMPONENT name="" id="c7e2a94d0b16f385" memberName="settingsComboPrimer"
+                    virtualName="" explicitFocusOrder="0" pos="0Cc 12 24M 72M" class="MobileComboBox::Primer"
+                    params=""/>
+  <LABEL name="" id="5f3b1d6a8e2c4b07" memberName="settingsEditor" virtualName=""
+         explicitFocusOrder="0" pos="25Cc 164 406 32" labelText="" editableSingleClick="0"
+         editableDoubleClick="0" focusDiscardsChanges="0" fontname="Default font"
+         fontsize="16.0" kerning="0.0" bold="0" italic="0" justification="33"/>
 </JUCER_COMPONENT>
 
 END_JUCER_METADATA
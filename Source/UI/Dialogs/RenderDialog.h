@@ -19,6 +19,8 @@
 
 //[Headers]
 #include "FadingDialog.h"
+#include "MobileComboBox.h"
+#include "RenderSettings.h"
 
 class DocumentOwner;
 class ProjectNode;
@@ -76,6 +78,10 @@ private:
     void startOrAbortRender();
     void stopRender();
 
+    RenderSettings renderSettings;
+    void syncRenderSettingsMenu();
+    void updateStageTimings();
+
     //[/UserVariables]
 
     UniquePointer<DialogPanel> background;
@@ -89,6 +95,8 @@ private:
     UniquePointer<Label> pathEditor;
     UniquePointer<SeparatorHorizontalFading> component3;
     UniquePointer<SeparatorHorizontal> separatorH;
+    UniquePointer<MobileComboBox::Primer> settingsComboPrimer;
+    UniquePointer<Label> settingsEditor;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderDialog)
 };
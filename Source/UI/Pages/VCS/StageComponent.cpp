@@ -66,12 +66,21 @@ StageComponent::StageComponent(VersionControl &versionControl)
     this->separator3.reset(new SeparatorHorizontalFadingReversed());
     this->addAndMakeVisible(separator3.get());
 
+    this->rebuildStatsLabel.reset(new Label(String(),
+                                             String()));
+    this->addAndMakeVisible(rebuildStatsLabel.get());
+    this->rebuildStatsLabel->setFont(Font (12.00f, Font::plain).withTypefaceStyle ("Regular"));
+    rebuildStatsLabel->setJustificationType(Justification::centredRight);
+    rebuildStatsLabel->setEditable(false, false, false);
+
     //[UserPreSize]
     this->setComponentID(ComponentIDs::versionControlStage);
 
     this->indicator->setVisible(false);
     this->indicator->setAlpha(0.5f);
 
+    this->rebuildStatsLabel->setAlpha(0.5f);
+
     this->changesList->getViewport()->setScrollBarThickness(2);
     this->changesList->getViewport()->setScrollBarsShown(true, false);
     this->changesList->setMultipleSelectionEnabled(true);
@@ -98,6 +107,7 @@ StageComponent::~StageComponent()
     indicator = nullptr;
     changesList = nullptr;
     separator3 = nullptr;
+    rebuildStatsLabel = nullptr;
 
     //[Destructor]
     //[/Destructor]
@@ -122,6 +132,7 @@ void StageComponent::resized()
     indicator->setBounds((getWidth() / 2) - (32 / 2), (getHeight() / 2) - (32 / 2), 32, 32);
     changesList->setBounds(1, 42, getWidth() - 2, getHeight() - 43);
     separator3->setBounds((getWidth() / 2) - ((getWidth() - 0) / 2), 40, getWidth() - 0, 3);
+    rebuildStatsLabel->setBounds(getWidth() - 4 - 160, 20, 160, 20);
     //[UserResized] Add your own custom resize handling here..
     //[/UserResized]
 }
@@ -195,6 +206,11 @@ void StageComponent::changeListenerCallback(ChangeBroadcaster *source)
         {
             this->stopProgressAnimation();
             this->updateList();
+
+            // items re-diffed / threads used, and the time it took
+            this->rebuildStatsLabel->setText(String(head->getLastRebuildNumItems()) + " / " +
+                String(head->getLastRebuildNumThreads()) + "  " +
+                String(head->getLastRebuildTimeMs(), 1) + " ms", dontSendNotification);
         }
     }
 }
@@ -424,6 +440,11 @@ BEGIN_JUCER_METADATA
   <JUCERCOMP name="" id="a09914d60dab2768" memberName="separator3" virtualName=""
              explicitFocusOrder="0" pos="0.5Cc 40 0M 3" sourceFile="../../Themes/SeparatorHorizontalFadingReversed.cpp"
              constructorParams=""/>
+  <LABEL name="" id="3b3d4a84ff3b2a1c" memberName="rebuildStatsLabel"
+         virtualName="" explicitFocusOrder="0" pos="4Rr 20 160 20" labelText=""
+         editableSingleClick="0" editableDoubleClick="0" focusDiscardsChanges="0"
+         fontname="Default font" fontsize="12.00000000000000000000" kerning="0.00000000000000000000"
+         bold="0" italic="0" justification="34"/>
 </JUCER_COMPONENT>
 
 END_JUCER_METADATA
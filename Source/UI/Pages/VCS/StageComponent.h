@@ -105,6 +105,7 @@ private:
     UniquePointer<ProgressIndicator> indicator;
     UniquePointer<ListBox> changesList;
     UniquePointer<SeparatorHorizontalFadingReversed> separator3;
+    UniquePointer<Label> rebuildStatsLabel;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StageComponent)
 };
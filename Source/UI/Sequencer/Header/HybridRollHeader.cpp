@@ -146,7 +146,6 @@ void HybridRollHeader::updateTimeDistanceIndicator()
     double outTimeMs2 = 0.0;
     double outTempo2 = 0.0;
     
-    // todo don't rebuild sequences here
     this->transport.calcTimeAndTempoAt(seek1, outTimeMs1, outTempo1);
     this->transport.calcTimeAndTempoAt(seek2, outTimeMs2, outTempo2);
     
@@ -36,7 +36,6 @@ Playhead::Playhead(HybridRoll &parentRoll,
     playheadWidth(width + FREE_SPACE),
     lastCorrectPosition(0.0),
     timerStartTime(0.0),
-    msPerQuarterNote(1.0),
     timerStartPosition(0.0),
     listener(movementListener)
 {
@@ -87,8 +86,6 @@ void Playhead::onSeek(double absolutePosition,
 void Playhead::onTempoChanged(double msPerQuarter)
 {
     SpinLock::ScopedLockType lock(this->anchorsLock);
-    this->msPerQuarterNote = jmax(msPerQuarter, 0.01);
-        
     if (this->isTimerRunning())
     {
         this->timerStartTime = Time::getMillisecondCounterHiRes();
@@ -218,14 +215,20 @@ void Playhead::updatePosition(double position)
 
 void Playhead::tick()
 {
-    double estimatedPosition;
+    double timeOffsetMs;
+    double startPosition;
     
     {
         SpinLock::ScopedLockType lock(this->anchorsLock);
-        const double timeOffsetMs = Time::getMillisecondCounterHiRes() - this->timerStartTime;
-        const double positionOffset = (timeOffsetMs / this->transport.getTotalTime()) / this->msPerQuarterNote;
-        estimatedPosition = this->timerStartPosition + positionOffset;
+        timeOffsetMs = Time::getMillisecondCounterHiRes() - this->timerStartTime;
+        startPosition = this->timerStartPosition;
     }
+
+    // the tempo map takes care of all tempo changes since the last anchor
+    double startTimeMs = 0.0;
+    double startTempo = 0.0;
+    this->transport.calcTimeAndTempoAt(startPosition, startTimeMs, startTempo);
+    const double estimatedPosition = this->transport.calcPositionAtTime(startTimeMs + timeOffsetMs);
     
     this->updatePosition(estimatedPosition);
 }
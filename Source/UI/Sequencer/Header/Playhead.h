@@ -85,7 +85,6 @@ private:
     SpinLock anchorsLock;
     double timerStartTime;
     double timerStartPosition;
-    double msPerQuarterNote;
 
 private:
 
@@ -689,19 +689,43 @@ void HybridRoll::setBarWidth(const float newBarWidth)
 #define MIN_BAR_WIDTH 14
 #define MIN_BEAT_WIDTH 8
 
-void HybridRoll::computeVisibleBeatLines()
+void HybridRoll::updateTimeSignatureAnchorsIfNeeded()
+{
+    if (!this->timeSignatureAnchorsOutdated)
+    {
+        return;
+    }
+
+    this->timeSignatureAnchors.clearQuick();
+
+    const auto tsSequence =
+        this->project.getTimeline()->getTimeSignatures()->getSequence();
+
+    for (int i = 0; i < tsSequence->size(); ++i)
+    {
+        const auto signature =
+            static_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(i));
+
+        this->timeSignatureAnchors.add({ signature->getBeat(),
+            signature->getNumerator(), signature->getDenominator() });
+    }
+
+    this->timeSignatureAnchorsOutdated = false;
+}
+
+void HybridRoll::computeVisibleBeatLines(int startX, int endX)
 {
     this->visibleBars.clearQuick();
     this->visibleBeats.clearQuick();
     this->visibleSnaps.clearQuick();
 
-    const auto tsSequence =
-        this->project.getTimeline()->getTimeSignatures()->getSequence();
-    
+    this->updateTimeSignatureAnchorsIfNeeded();
+    const auto &anchors = this->timeSignatureAnchors;
+
     const float zeroCanvasOffset = this->firstBar * this->barWidth; // usually a negative value
-    const float viewPosX = float(this->viewport.getViewPositionX());
+    const float viewPosX = float(startX);
     const float paintStartX = viewPosX + zeroCanvasOffset;
-    const float paintEndX = float(viewPosX + this->viewport.getViewWidth()) + zeroCanvasOffset;
+    const float paintEndX = float(endX) + zeroCanvasOffset;
     
     const float paintStartBar = roundf(paintStartX / this->barWidth) - 2.f;
     const float paintEndBar = roundf(paintEndX / this->barWidth) + 1.f;
@@ -716,40 +740,63 @@ void HybridRoll::computeVisibleBeatLines()
     int denominator = TIME_SIGNATURE_DEFAULT_DENOMINATOR;
     float barIterator = float(this->firstBar);
     int nextSignatureIdx = 0;
-    bool firstEvent = true;
 
     // Find a time signature to start from (or use default values):
     // find a first time signature after a paint start and take a previous one, if any
-    for (; nextSignatureIdx < tsSequence->size(); ++nextSignatureIdx)
+    if (!anchors.isEmpty())
     {
-        const auto signature =
-            static_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(nextSignatureIdx));
-
         // The very first event defines what's before it (both time signature and offset)
-        if (firstEvent)
+        const auto &first = anchors.getReference(0);
+        numerator = first.numerator;
+        denominator = first.denominator;
+        const float beatStep = 1.f / float(denominator);
+        const float barStep = beatStep * float(numerator);
+        barIterator += fmodf(first.beat / BEATS_PER_BAR - float(this->firstBar), barStep) - barStep;
+
+        int low = 0;
+        int high = anchors.size();
+        while (low < high)
         {
-            numerator = signature->getNumerator();
-            denominator = signature->getDenominator();
-            const float beatStep = 1.f / float(denominator);
-            const float barStep = beatStep * float(numerator);
-            barIterator += fmodf(signature->getBeat() / BEATS_PER_BAR - float(this->firstBar), barStep) - barStep;
-            firstEvent = false;
+            const int mid = (low + high) / 2;
+            if (anchors.getReference(mid).beat < (paintStartBar * BEATS_PER_BAR))
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
         }
 
-        if (signature->getBeat() >= (paintStartBar * BEATS_PER_BAR))
+        nextSignatureIdx = low;
+        if (nextSignatureIdx > 0)
         {
-            break;
+            const auto &previous = anchors.getReference(nextSignatureIdx - 1);
+            numerator = previous.numerator;
+            denominator = previous.denominator;
+            barIterator = previous.beat / BEATS_PER_BAR;
         }
-
-        numerator = signature->getNumerator();
-        denominator = signature->getDenominator();
-        barIterator = signature->getBeat() / BEATS_PER_BAR;
     }
 
     // At this point we have barIterator pointing at the anchor,
     // that is nearest to the left side of visible screen area
     // (it could be either TimeSignatureEvent, or just the very first bar)
 
+    // There are no time signature changes until the visible area, so skip
+    // the bars before it at once, but keep the grouping of the bars which are
+    // too narrow to have their own lines (see barWidthSum below) the same:
+    {
+        const float barStep = float(numerator) / float(denominator);
+        const float stepWidth = this->barWidth * barStep;
+        const float barsPerLine = (stepWidth > MIN_BAR_WIDTH) ?
+            1.f : floorf(MIN_BAR_WIDTH / stepWidth) + 1.f;
+        const float linesToSkip = floorf((paintStartBar - barIterator) / (barStep * barsPerLine)) - 1.f;
+        if (linesToSkip > 0.f)
+        {
+            barIterator += linesToSkip * barsPerLine * barStep;
+        }
+    }
+
     float barWidthSum = 0.f;
     bool canDrawBarLine = false;
 
@@ -778,10 +825,10 @@ void HybridRoll::computeVisibleBeatLines()
             }
 
             // Check if we have more time signatures to come
-            TimeSignatureEvent *nextSignature = nullptr;
-            if (nextSignatureIdx < tsSequence->size())
+            const TimeSignatureAnchor *nextSignature = nullptr;
+            if (nextSignatureIdx < anchors.size())
             {
-                nextSignature = static_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(nextSignatureIdx));
+                nextSignature = &anchors.getReference(nextSignatureIdx);
             }
 
             // Now for the beat lines
@@ -794,11 +841,11 @@ void HybridRoll::computeVisibleBeatLines()
                 // Check for time signature change at this point
                 if (nextSignature != nullptr)
                 {
-                    const float tsBar = nextSignature->getBeat() / BEATS_PER_BAR;
+                    const float tsBar = nextSignature->beat / BEATS_PER_BAR;
                     if (tsBar <= (barIterator + j + beatStep))
                     {
-                        numerator = nextSignature->getNumerator();
-                        denominator = nextSignature->getDenominator();
+                        numerator = nextSignature->numerator;
+                        denominator = nextSignature->denominator;
                         barStep = (tsBar - barIterator); // i.e. incomplete bar
                         nextBeatStartX = barStartX + this->barWidth * barStep;
                         nextSignatureIdx++;
@@ -937,6 +984,7 @@ void HybridRoll::onChangeMidiEvent(const MidiEvent &event, const MidiEvent &newE
     // Time signatures have changed, need to repaint
     if (event.isTypeOf(MidiEvent::Type::TimeSignature))
     {
+        this->resetBeatLinesCache();
         this->updateChildrenBounds();
         this->repaint();
     }
@@ -946,6 +994,7 @@ void HybridRoll::onAddMidiEvent(const MidiEvent &event)
 {
     if (event.isTypeOf(MidiEvent::Type::TimeSignature))
     {
+        this->resetBeatLinesCache();
         this->updateChildrenBounds();
         this->repaint();
     }
@@ -955,6 +1004,7 @@ void HybridRoll::onRemoveMidiEvent(const MidiEvent &event)
 {
     if (event.isTypeOf(MidiEvent::Type::TimeSignature))
     {
+        this->resetBeatLinesCache();
         this->updateChildrenBounds();
         this->repaint();
     }
@@ -986,6 +1036,11 @@ void HybridRoll::onChangeViewBeatRange(float firstBeat, float lastBeat)
     this->setBarRange(viewFirstBar, viewLastBar);
 }
 
+void HybridRoll::onReloadProjectContent(const Array<MidiTrack *> &tracks)
+{
+    this->resetBeatLinesCache();
+}
+
 //===----------------------------------------------------------------------===//
 // Component
 //===----------------------------------------------------------------------===//
@@ -1250,36 +1305,76 @@ void HybridRoll::resized()
 
 void HybridRoll::paint(Graphics &g)
 {
-    this->computeVisibleBeatLines();
+    this->updateBeatLinesCacheIfNeeded();
+
+    const int viewX = this->viewport.getViewPositionX();
+    const int viewWidth = this->viewport.getViewWidth();
+
+    Graphics::ScopedSaveState state(g);
+    g.setImageResamplingQuality(Graphics::lowResamplingQuality);
+    g.drawImage(this->beatLinesCache,
+        viewX, this->viewport.getViewPositionY(), viewWidth, this->viewport.getViewHeight(),
+        viewX - this->beatLinesCacheX, 0, viewWidth, 1);
+}
+
+void HybridRoll::updateBeatLinesCacheIfNeeded()
+{
+    const int viewX = this->viewport.getViewPositionX();
+    const int viewWidth = this->viewport.getViewWidth();
+
+    if (this->beatLinesCache.isValid() &&
+        this->beatLinesCacheBarWidth == this->barWidth &&
+        this->beatLinesCacheFirstBar == this->firstBar &&
+        viewX >= this->beatLinesCacheX &&
+        (viewX + viewWidth) <= (this->beatLinesCacheX + this->beatLinesCache.getWidth()))
+    {
+        return;
+    }
+
+    const int startX = viewX - viewWidth;
+    const int endX = viewX + viewWidth * 2;
+
+    this->computeVisibleBeatLines(startX, endX);
 
-    const float y = float(this->viewport.getViewPositionY());
-    const float h = float(this->viewport.getViewHeight());
+    this->beatLinesCacheX = startX;
+    this->beatLinesCacheBarWidth = this->barWidth;
+    this->beatLinesCacheFirstBar = this->firstBar;
+    this->beatLinesCache = Image(Image::ARGB, jmax(1, endX - startX), 1, true);
+
+    Graphics g(this->beatLinesCache);
+    g.setOrigin(-startX, 0);
 
     g.setColour(this->barLineColour);
     for (const auto &f : this->visibleBars)
     {
-        g.fillRect(floorf(f), y, 1.f, h);
+        g.fillRect(floorf(f), 0.f, 1.f, 1.f);
     }
 
     g.setColour(this->barLineBevelColour);
     for (const auto &f : this->visibleBars)
     {
-        g.fillRect(floorf(f + 1.f), y, 1.f, h);
+        g.fillRect(floorf(f + 1.f), 0.f, 1.f, 1.f);
     }
 
     g.setColour(this->beatLineColour);
     for (const auto &f : this->visibleBeats)
     {
-        g.fillRect(floorf(f), y, 1.f, h);
+        g.fillRect(floorf(f), 0.f, 1.f, 1.f);
     }
-    
+
     g.setColour(this->snapLineColour);
     for (const auto &f : this->visibleSnaps)
     {
-        g.fillRect(floorf(f), y, 1.f, h);
+        g.fillRect(floorf(f), 0.f, 1.f, 1.f);
     }
 }
 
+void HybridRoll::resetBeatLinesCache()
+{
+    this->timeSignatureAnchorsOutdated = true;
+    this->beatLinesCache = {};
+}
+
 //===----------------------------------------------------------------------===//
 // Playhead::Listener
 //===----------------------------------------------------------------------===//
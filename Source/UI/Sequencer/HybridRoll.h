@@ -244,6 +244,7 @@ public:
     void onRemoveMidiEvent(const MidiEvent &event) override;
     void onChangeProjectBeatRange(float firstBeat, float lastBeat) override;
     void onChangeViewBeatRange(float firstBeat, float lastBeat) override;
+    void onReloadProjectContent(const Array<MidiTrack *> &tracks) override;
 
     //===------------------------------------------------------------------===//
     // Component
@@ -390,7 +391,32 @@ protected:
     const Colour beatLineColour;
     const Colour snapLineColour;
 
-    void computeVisibleBeatLines();
+    void computeVisibleBeatLines(int startX, int endX);
+
+    // All time signatures, so that computing the beat lines can start from
+    // the one nearest to the visible area instead of walking the sequence;
+    // rebuilt lazily after any time signature changes:
+    struct TimeSignatureAnchor final
+    {
+        float beat;
+        int numerator;
+        int denominator;
+    };
+
+    Array<TimeSignatureAnchor> timeSignatureAnchors;
+    bool timeSignatureAnchorsOutdated = true;
+    void updateTimeSignatureAnchorsIfNeeded();
+
+    // The beat lines are rendered into a one pixel high strip,
+    // which covers the visible area with a margin of one screen
+    // on both sides, and is stretched over the roll's height on paint,
+    // so that scrolling doesn't need to recompute or redraw them:
+    Image beatLinesCache;
+    int beatLinesCacheX = 0;
+    float beatLinesCacheBarWidth = 0.f;
+    float beatLinesCacheFirstBar = 0.f;
+    void updateBeatLinesCacheIfNeeded();
+    void resetBeatLinesCache();
 
 protected:
 
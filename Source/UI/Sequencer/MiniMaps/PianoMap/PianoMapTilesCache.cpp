@@ -0,0 +1,395 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "PianoMapTilesCache.h"
+#include "MidiTrack.h"
+#include "MidiSequence.h"
+#include "Pattern.h"
+#include "Note.h"
+
+#define PIANOMAP_TILE_WIDTH 256
+#define PIANOMAP_ZOOM_STEPS_PER_OCTAVE 4.f
+
+//===----------------------------------------------------------------------===//
+// Render job
+//===----------------------------------------------------------------------===//
+
+class PianoMapTilesCache::RenderJob final : public ThreadPoolJob
+{
+public:
+
+    RenderJob(PianoMapTilesCache &cache, Tile::Ptr tile, NotesSnapshot::Ptr snapshot,
+        float startBeat, float pixelsPerBeat, int height) :
+        ThreadPoolJob("PianoMapTile"),
+        cache(cache),
+        tile(tile),
+        version(tile->version.get()),
+        snapshot(snapshot),
+        startBeat(startBeat),
+        pixelsPerBeat(pixelsPerBeat),
+        height(height) {}
+
+    JobStatus runJob() override
+    {
+        // the tile has been dropped or invalidated again meanwhile
+        if (this->tile->getReferenceCount() == 1 ||
+            this->tile->version.get() != this->version)
+        {
+            return jobHasFinished;
+        }
+
+        Image image(Image::SingleChannel, PIANOMAP_TILE_WIDTH, this->height, true, SoftwareImageType());
+
+        {
+            Graphics g(image);
+            g.setColour(Colours::white);
+
+            const auto &notes = this->snapshot->notes;
+            const float endBeat = this->startBeat + PIANOMAP_TILE_WIDTH / this->pixelsPerBeat;
+            const float keyHeight = float(this->height) / 128.f;
+
+            // the notes are sorted by beat, so skip the ones which surely end before the tile
+            const float firstBeat = this->startBeat - this->snapshot->maxLength;
+            int low = 0;
+            int high = notes.size();
+            while (low < high)
+            {
+                const int mid = (low + high) / 2;
+                if (notes.getReference(mid).beat < firstBeat)
+                {
+                    low = mid + 1;
+                }
+                else
+                {
+                    high = mid;
+                }
+            }
+
+            for (int i = low; i < notes.size(); ++i)
+            {
+                const auto &n = notes.getReference(i);
+                if (n.beat >= endBeat)
+                {
+                    break;
+                }
+
+                if ((i % 256) == 0 && this->shouldExit())
+                {
+                    return jobHasFinished;
+                }
+
+                const float x = (n.beat - this->startBeat) * this->pixelsPerBeat;
+                const float w = n.length * this->pixelsPerBeat;
+                const float y = roundf(this->height - n.key * keyHeight);
+                g.fillRect(x, y, jmax(0.25f, w), 1.0f);
+            }
+        }
+
+        {
+            const SpinLock::ScopedLockType lock(this->tile->imageLock);
+            this->tile->image = image;
+        }
+
+        this->cache.triggerAsyncUpdate();
+        return jobHasFinished;
+    }
+
+    PianoMapTilesCache &cache;
+
+private:
+
+    const Tile::Ptr tile;
+    const int version;
+    const NotesSnapshot::Ptr snapshot;
+
+    const float startBeat;
+    const float pixelsPerBeat;
+    const int height;
+
+    JUCE_DECLARE_NON_COPYABLE(RenderJob)
+};
+
+class PianoMapTilesCache::RenderJobsSelector final : public ThreadPool::JobSelector
+{
+public:
+
+    explicit RenderJobsSelector(PianoMapTilesCache &cache) : cache(cache) {}
+
+    bool isJobSuitable(ThreadPoolJob *job) override
+    {
+        const auto *renderJob = dynamic_cast<RenderJob *>(job);
+        return renderJob != nullptr && &renderJob->cache == &this->cache;
+    }
+
+private:
+
+    PianoMapTilesCache &cache;
+
+};
+
+//===----------------------------------------------------------------------===//
+// PianoMapTilesCache
+//===----------------------------------------------------------------------===//
+
+PianoMapTilesCache::PianoMapTilesCache(Component &owner) :
+    zoomStep(INT_MIN),
+    tilesHeight(0),
+    previousZoomStep(INT_MIN),
+    owner(owner) {}
+
+PianoMapTilesCache::~PianoMapTilesCache()
+{
+    // the jobs refer to this cache, so wait for the running ones without a timeout;
+    // they check shouldExit() while painting, so this doesn't take long
+    RenderJobsSelector selector(*this);
+    this->renderer->removeAllJobs(true, -1, &selector);
+    this->cancelPendingUpdate();
+}
+
+void PianoMapTilesCache::paint(Graphics &g, const Clip &clip,
+    float originBeat, float pixelsPerBeat, int height)
+{
+    if (pixelsPerBeat <= 0.f || height <= 0)
+    {
+        return;
+    }
+
+    this->updateZoomLevel(pixelsPerBeat, height);
+
+    auto &layerPtr = this->layers[clip];
+    if (layerPtr == nullptr)
+    {
+        layerPtr.reset(new Layer());
+    }
+
+    auto &layer = *layerPtr;
+    if (layer.snapshot == nullptr)
+    {
+        layer.snapshot = PianoMapTilesCache::createSnapshot(clip);
+    }
+
+    if (layer.snapshot->notes.isEmpty())
+    {
+        return;
+    }
+
+    const auto paintBounds = g.getClipBounds();
+    const float visibleStartBeat = jmax(originBeat + paintBounds.getX() / pixelsPerBeat,
+        layer.snapshot->notes.getReference(0).beat);
+    const float visibleEndBeat = jmin(originBeat + paintBounds.getRight() / pixelsPerBeat,
+        layer.snapshot->endBeat);
+
+    if (visibleStartBeat > visibleEndBeat)
+    {
+        return;
+    }
+
+    const float tileBeats = PianoMapTilesCache::getTileBeats(this->zoomStep);
+    const float previousTileBeats = (this->previousZoomStep == INT_MIN) ?
+        tileBeats : PianoMapTilesCache::getTileBeats(this->previousZoomStep);
+
+    const int firstTile = int(floorf(visibleStartBeat / tileBeats));
+    const int lastTile = int(floorf(visibleEndBeat / tileBeats));
+
+    Graphics::ScopedSaveState state(g);
+    g.setImageResamplingQuality(Graphics::lowResamplingQuality);
+
+    for (int i = firstTile; i <= lastTile; ++i)
+    {
+        auto &tile = layer.tiles[i];
+        if (tile == nullptr)
+        {
+            tile = new Tile();
+        }
+
+        if (tile->requestedVersion != tile->version.get())
+        {
+            tile->requestedVersion = tile->version.get();
+            this->renderer->addJob(new RenderJob(*this, tile, layer.snapshot,
+                i * tileBeats, PIANOMAP_TILE_WIDTH / tileBeats, height), true);
+        }
+
+        const Rectangle<float> area((i * tileBeats - originBeat) * pixelsPerBeat,
+            0.f, tileBeats * pixelsPerBeat, float(height));
+
+        const auto image = PianoMapTilesCache::getTileImage(tile.get());
+        if (image.isValid())
+        {
+            g.drawImage(image, area, RectanglePlacement::stretchToFit, true);
+            continue;
+        }
+
+        if (layer.previousTiles.empty())
+        {
+            continue;
+        }
+
+        // not rendered yet, so stretch the previous zoom level's tiles, if any
+        const int firstPreviousTile = int(floorf(i * tileBeats / previousTileBeats));
+        const int lastPreviousTile = int(floorf((i + 1) * tileBeats / previousTileBeats));
+        for (int j = firstPreviousTile; j <= lastPreviousTile; ++j)
+        {
+            const auto previousTile = layer.previousTiles.find(j);
+            if (previousTile == layer.previousTiles.end())
+            {
+                continue;
+            }
+
+            const auto previousImage = PianoMapTilesCache::getTileImage(previousTile->second.get());
+            if (previousImage.isValid())
+            {
+                const Rectangle<float> previousArea((j * previousTileBeats - originBeat) * pixelsPerBeat,
+                    0.f, previousTileBeats * pixelsPerBeat, float(height));
+
+                Graphics::ScopedSaveState previousState(g);
+                g.reduceClipRegion(area.getSmallestIntegerContainer());
+                g.drawImage(previousImage, previousArea, RectanglePlacement::stretchToFit, true);
+            }
+        }
+    }
+}
+
+void PianoMapTilesCache::invalidate(const Clip &clip, float startBeat, float endBeat)
+{
+    const auto found = this->layers.find(clip);
+    if (found == this->layers.end())
+    {
+        return;
+    }
+
+    auto &layer = *found->second.get();
+    layer.snapshot = nullptr;
+
+    const float tileBeats = PianoMapTilesCache::getTileBeats(this->zoomStep);
+    const int firstTile = int(floorf(startBeat / tileBeats));
+    const int lastTile = int(floorf(endBeat / tileBeats));
+
+    // iterate whichever is shorter, the tiles range or the tiles map
+    if (lastTile - firstTile < int(layer.tiles.size()))
+    {
+        for (int i = firstTile; i <= lastTile; ++i)
+        {
+            const auto tile = layer.tiles.find(i);
+            if (tile != layer.tiles.end())
+            {
+                ++tile->second->version;
+            }
+        }
+    }
+    else
+    {
+        for (const auto &tile : layer.tiles)
+        {
+            if (tile.first >= firstTile && tile.first <= lastTile)
+            {
+                ++tile.second->version;
+            }
+        }
+    }
+}
+
+void PianoMapTilesCache::invalidate(const Clip &clip)
+{
+    const auto found = this->layers.find(clip);
+    if (found == this->layers.end())
+    {
+        return;
+    }
+
+    auto &layer = *found->second.get();
+    layer.snapshot = nullptr;
+
+    for (const auto &tile : layer.tiles)
+    {
+        ++tile.second->version;
+    }
+}
+
+void PianoMapTilesCache::remove(const Clip &clip)
+{
+    this->layers.erase(clip);
+}
+
+void PianoMapTilesCache::clear()
+{
+    this->layers.clear();
+}
+
+//===----------------------------------------------------------------------===//
+// Private
+//===----------------------------------------------------------------------===//
+
+void PianoMapTilesCache::updateZoomLevel(float pixelsPerBeat, int height)
+{
+    const int newZoomStep = roundToInt(log2f(pixelsPerBeat) * PIANOMAP_ZOOM_STEPS_PER_OCTAVE);
+    if (newZoomStep == this->zoomStep && height == this->tilesHeight)
+    {
+        return;
+    }
+
+    this->previousZoomStep = this->zoomStep;
+    this->zoomStep = newZoomStep;
+    this->tilesHeight = height;
+
+    for (const auto &layer : this->layers)
+    {
+        layer.second->previousTiles = std::move(layer.second->tiles);
+        layer.second->tiles.clear();
+    }
+}
+
+float PianoMapTilesCache::getTileBeats(int zoomStep) noexcept
+{
+    const float pixelsPerBeat = powf(2.f, float(zoomStep) / PIANOMAP_ZOOM_STEPS_PER_OCTAVE);
+    return PIANOMAP_TILE_WIDTH / pixelsPerBeat;
+}
+
+PianoMapTilesCache::NotesSnapshot::Ptr PianoMapTilesCache::createSnapshot(const Clip &clip)
+{
+    NotesSnapshot::Ptr snapshot(new NotesSnapshot());
+
+    const auto *sequence = clip.getPattern()->getTrack()->getSequence();
+    snapshot->notes.ensureStorageAllocated(sequence->size());
+
+    for (int i = 0; i < sequence->size(); ++i)
+    {
+        const auto *event = sequence->getUnchecked(i);
+        if (event->isTypeOf(MidiEvent::Type::Note))
+        {
+            const auto *note = static_cast<const Note *>(event);
+            const int key = jlimit(0, 128, note->getKey() + clip.getKey());
+            snapshot->notes.add({ note->getBeat(), note->getLength(), key });
+            snapshot->maxLength = jmax(snapshot->maxLength, note->getLength());
+            snapshot->endBeat = jmax(snapshot->endBeat, note->getBeat() + note->getLength());
+        }
+    }
+
+    return snapshot;
+}
+
+Image PianoMapTilesCache::getTileImage(const Tile *tile)
+{
+    const SpinLock::ScopedLockType lock(tile->imageLock);
+    return tile->image;
+}
+
+void PianoMapTilesCache::handleAsyncUpdate()
+{
+    this->owner.repaint();
+}
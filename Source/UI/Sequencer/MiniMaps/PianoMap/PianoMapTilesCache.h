@@ -0,0 +1,129 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Clip.h"
+
+/*
+    A raster cache for the piano mini-maps, i.e. the project map
+    and the piano clips of the pattern roll, which otherwise would
+    have to draw every single note on each repaint, or each scroll.
+
+    The notes of each clip are rendered into alpha-only tiles of a fixed
+    width in pixels, so that the caller's colour is applied when blitting them.
+    Tiles are aligned to the clip's sequence beats, so moving the clip doesn't
+    invalidate anything; changing the notes only invalidates the tiles they
+    intersect, which are then re-rendered on a background thread from a
+    snapshot of the sequence, while the outdated images are still displayed.
+
+    Zoom levels are quantized, so that the tiles are only re-rendered when
+    the zoom level changes noticeably, and are just stretched a bit in between.
+*/
+
+class PianoMapTilesCache final : private AsyncUpdater
+{
+public:
+
+    explicit PianoMapTilesCache(Component &owner);
+    ~PianoMapTilesCache() override;
+
+    // Draws the clip's notes within the graphics clip bounds, so that a note
+    // at the sequence beat b starts at x = (b - originBeat) * pixelsPerBeat,
+    // and the key k is a 1px line at y = roundf(height - k * height / 128)
+    void paint(Graphics &g, const Clip &clip,
+        float originBeat, float pixelsPerBeat, int height);
+
+    // Marks the tiles within the given range of the sequence beats as outdated
+    void invalidate(const Clip &clip, float startBeat, float endBeat);
+    void invalidate(const Clip &clip);
+    void remove(const Clip &clip);
+    void clear();
+
+private:
+
+    struct NoteLine final
+    {
+        float beat;
+        float length;
+        int key;
+    };
+
+    // An immutable copy of the clip's notes, sorted by beat,
+    // which the render thread can safely read
+    struct NotesSnapshot final : public ReferenceCountedObject
+    {
+        using Ptr = ReferenceCountedObjectPtr<NotesSnapshot>;
+        Array<NoteLine> notes;
+        float maxLength = 0.f;
+        float endBeat = -FLT_MAX;
+    };
+
+    struct Tile final : public ReferenceCountedObject
+    {
+        using Ptr = ReferenceCountedObjectPtr<Tile>;
+
+        // bumped on the message thread each time the tile is invalidated,
+        // so that the render thread can skip the outdated requests
+        Atomic<int> version;
+        int requestedVersion = -1;
+
+        // set by the render thread
+        SpinLock imageLock;
+        Image image;
+    };
+
+    using Tiles = FlatHashMap<int, Tile::Ptr>;
+
+    struct Layer final
+    {
+        // null when outdated, re-created on the next paint
+        NotesSnapshot::Ptr snapshot;
+        Tiles tiles;
+        // the tiles of the previous zoom level,
+        // displayed until the new ones are rendered
+        Tiles previousTiles;
+    };
+
+    FlatHashMap<Clip, UniquePointer<Layer>, ClipHash> layers;
+
+    int zoomStep;
+    int tilesHeight;
+    int previousZoomStep;
+
+    void updateZoomLevel(float pixelsPerBeat, int height);
+    static float getTileBeats(int zoomStep) noexcept;
+    static NotesSnapshot::Ptr createSnapshot(const Clip &clip);
+    static Image getTileImage(const Tile *tile);
+
+    Component &owner;
+    void handleAsyncUpdate() override;
+
+    class RenderJob;
+    class RenderJobsSelector;
+
+    // all the caches share the same render thread
+    struct RenderThreadPool final : public ThreadPool
+    {
+        RenderThreadPool() : ThreadPool(1) {}
+    };
+
+    SharedResourcePointer<RenderThreadPool> renderer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PianoMapTilesCache)
+};
@@ -30,7 +30,8 @@
 
 PianoProjectMap::PianoProjectMap(ProjectNode &parentProject, HybridRoll &parentRoll) :
     project(parentProject),
-    roll(parentRoll)
+    roll(parentRoll),
+    tilesCache(*this)
 {
     this->baseColour = findDefaultColour(ColourIDs::Roll::noteFill);
 
@@ -50,38 +51,27 @@ PianoProjectMap::~PianoProjectMap()
 // Component
 //===----------------------------------------------------------------------===//
 
-void PianoProjectMap::resized()
-{
-    this->componentHeight = float(this->getHeight()) / 128.f; // TODO remove hard-coded value
-}
-
 void PianoProjectMap::paint(Graphics &g)
 {
     const float rollLengthInBeats = this->rollLastBeat - this->rollFirstBeat;
-    const float projectLengthInBeats = this->projectLastBeat - this->projectFirstBeat;
-    const float mapWidth = float(this->getWidth()) * (projectLengthInBeats / rollLengthInBeats);
+    if (rollLengthInBeats <= 0.f)
+    {
+        return;
+    }
 
-    for (const auto &c : this->patternMap)
+    // scrolling only changes the origin, so the cached tiles are just blitted
+    const float pixelsPerBeat = float(this->getWidth()) / rollLengthInBeats;
+
+    for (const auto &clip : this->clips)
     {
-        const auto sequenceMap = c.second.get();
-        const bool isActiveClip = this->activeClip == c.first;
+        const bool isActiveClip = this->activeClip == clip;
 
-        g.setColour(c.first.getTrackColour().
+        g.setColour(clip.getTrackColour().
             interpolatedWith(this->baseColour, .4f).
             withAlpha(isActiveClip ? .9f : .6f));
 
-        for (const auto &n : *sequenceMap)
-        {
-            const auto key = jlimit(0, 128, n.getKey() + c.first.getKey());
-            const auto beat = n.getBeat() + c.first.getBeat() - this->rollFirstBeat;
-            const auto length = n.getLength();
-
-            const float x = (mapWidth * (beat / projectLengthInBeats));
-            const float w = (mapWidth * (length / projectLengthInBeats));
-            const float y = roundf(this->getHeight() - (key * this->componentHeight));
-
-            g.fillRect(x, y, jmax(0.25f, w), 1.0f);
-        }
+        this->tilesCache.paint(g, clip, this->rollFirstBeat - clip.getBeat(),
+            pixelsPerBeat, this->getHeight());
     }
 }
 
@@ -89,9 +79,9 @@ void PianoProjectMap::paint(Graphics &g)
 // ProjectListener
 //===----------------------------------------------------------------------===//
 
-#define forEachSequenceMapOfGivenTrack(map, child, track) \
-    for (const auto &child : map) \
-        if (child.first.getPattern()->getTrack() == track)
+#define forEachClipOfGivenTrack(clips, child, track) \
+    for (const auto &child : clips) \
+        if (child.getPattern()->getTrack() == track)
 
 void PianoProjectMap::onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2)
 {
@@ -101,14 +91,10 @@ void PianoProjectMap::onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2
         const Note &newNote = static_cast<const Note &>(e2);
         const auto *track = newNote.getSequence()->getTrack();
 
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
+        forEachClipOfGivenTrack(this->clips, c, track)
         {
-            auto &sequenceMap = *c.second.get();
-            if (sequenceMap.contains(note))
-            {
-                sequenceMap.erase(note);
-                sequenceMap.insert(newNote);
-            }
+            this->tilesCache.invalidate(c, note.getBeat(), note.getBeat() + note.getLength());
+            this->tilesCache.invalidate(c, newNote.getBeat(), newNote.getBeat() + newNote.getLength());
         }
 
         this->triggerAsyncUpdate();
@@ -122,10 +108,9 @@ void PianoProjectMap::onAddMidiEvent(const MidiEvent &event)
         const Note &note = static_cast<const Note &>(event);
         const auto *track = note.getSequence()->getTrack();
 
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
+        forEachClipOfGivenTrack(this->clips, c, track)
         {
-            auto &sequenceMap = *c.second.get();
-            sequenceMap.insert(note);
+            this->tilesCache.invalidate(c, note.getBeat(), note.getBeat() + note.getLength());
         }
 
         this->triggerAsyncUpdate();
@@ -139,13 +124,9 @@ void PianoProjectMap::onRemoveMidiEvent(const MidiEvent &event)
         const Note &note = static_cast<const Note &>(event);
         const auto *track = note.getSequence()->getTrack();
 
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
+        forEachClipOfGivenTrack(this->clips, c, track)
         {
-            auto &sequenceMap = *c.second.get();
-            if (sequenceMap.contains(note))
-            {
-                sequenceMap.erase(note);
-            }
+            this->tilesCache.invalidate(c, note.getBeat(), note.getBeat() + note.getLength());
         }
 
         this->triggerAsyncUpdate();
@@ -154,51 +135,38 @@ void PianoProjectMap::onRemoveMidiEvent(const MidiEvent &event)
 
 void PianoProjectMap::onAddClip(const Clip &clip)
 {
-    const SequenceSet *referenceMap = nullptr;
     const auto *track = clip.getPattern()->getTrack();
     if (!dynamic_cast<const PianoSequence *>(track->getSequence())) { return; }
 
-    forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-    {
-        // Found a sequence map for the same track
-        referenceMap = c.second.get();
-        break;
-    }
-
-    if (referenceMap == nullptr)
-    {
-        jassertfalse;
-        return;
-    }
-
-    auto sequenceMap = new SequenceSet();
-    this->patternMap[clip] = UniquePointer<SequenceSet>(sequenceMap);
-        
-    for (const auto &note : *referenceMap)
-    {
-        sequenceMap->insert(note);
-    }
-
+    this->clips.insert(clip);
     this->triggerAsyncUpdate();
 }
 
 void PianoProjectMap::onChangeClip(const Clip &clip, const Clip &newClip)
 {
-    if (this->patternMap.contains(clip))
+    if (this->clips.contains(clip))
     {
-        // Set new key for existing sequence map
-        auto *sequenceMap = this->patternMap[clip].release();
-        this->patternMap.erase(clip);
-        this->patternMap[newClip] = UniquePointer<SequenceSet>(sequenceMap);
+        // Update the clip parameters used for painting
+        this->clips.erase(clip);
+        this->clips.insert(newClip);
+
+        // The tiles are aligned to the sequence beats,
+        // so only transposing a clip makes them outdated
+        if (clip.getKey() != newClip.getKey())
+        {
+            this->tilesCache.invalidate(newClip);
+        }
+
         this->triggerAsyncUpdate();
     }
 }
 
 void PianoProjectMap::onRemoveClip(const Clip &clip)
 {
-    if (this->patternMap.contains(clip))
+    if (this->clips.contains(clip))
     {
-        this->patternMap.erase(clip);
+        this->clips.erase(clip);
+        this->tilesCache.remove(clip);
         this->triggerAsyncUpdate();
     }
 }
@@ -228,9 +196,10 @@ void PianoProjectMap::onRemoveTrack(MidiTrack *const track)
     for (int i = 0; i < track->getPattern()->size(); ++i)
     {
         const auto &clip = *track->getPattern()->getUnchecked(i);
-        if (this->patternMap.contains(clip))
+        if (this->clips.contains(clip))
         {
-            this->patternMap.erase(clip);
+            this->clips.erase(clip);
+            this->tilesCache.remove(clip);
         }
     }
 
@@ -275,7 +244,8 @@ void PianoProjectMap::onChangeViewEditableScope(MidiTrack *const, const Clip &cl
 
 void PianoProjectMap::reloadTrackMap()
 {
-    this->patternMap.clear();
+    this->clips.clear();
+    this->tilesCache.clear();
 
     const auto &tracks = this->project.getTracks();
     for (const auto *track : tracks)
@@ -299,19 +269,7 @@ void PianoProjectMap::loadTrack(const MidiTrack *const track)
     for (int i = 0; i < track->getPattern()->size(); ++i)
     {
         const Clip *clip = track->getPattern()->getUnchecked(i);
-
-        auto *sequenceMap = new SequenceSet();
-        this->patternMap[*clip] = UniquePointer<SequenceSet>(sequenceMap);
-
-        for (int j = 0; j < track->getSequence()->size(); ++j)
-        {
-            const MidiEvent *event = track->getSequence()->getUnchecked(j);
-            if (event->isTypeOf(MidiEvent::Type::Note))
-            {
-                const Note *note = static_cast<const Note *>(event);
-                sequenceMap->insert(*note);
-            }
-        }
+        this->clips.insert(*clip);
     }
 }
 
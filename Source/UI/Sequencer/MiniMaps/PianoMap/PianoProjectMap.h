@@ -20,6 +20,7 @@
 #include "Clip.h"
 #include "Note.h"
 #include "ProjectListener.h"
+#include "PianoMapTilesCache.h"
 
 class HybridRoll;
 class ProjectNode;
@@ -39,7 +40,6 @@ public:
     // Component
     //===------------------------------------------------------------------===//
 
-    void resized() override;
     void paint(Graphics &g) override;
 
     //===------------------------------------------------------------------===//
@@ -74,17 +74,16 @@ private:
     float rollFirstBeat = 0.f;
     float rollLastBeat = 0.f;
 
-    float componentHeight = 1.f;
-
     HybridRoll &roll;
     ProjectNode &project;
 
     Clip activeClip;
     Colour baseColour;
 
-    using SequenceSet = FlatHashSet<Note, MidiEventHash>;
-    using PatternMap = FlatHashMap<Clip, UniquePointer<SequenceSet>, ClipHash>;
-    PatternMap patternMap;
+    // the clips are only kept here to be painted with their current parameters,
+    // the notes are rendered by the tiles cache straight from their sequences
+    FlatHashSet<Clip, ClipHash> clips;
+    PianoMapTilesCache tilesCache;
 
     void handleAsyncUpdate() override;
 
@@ -29,10 +29,10 @@ PianoClipComponent::PianoClipComponent(ProjectNode &project, MidiSequence *seque
     HybridRoll &roll, const Clip &clip) :
     ClipComponent(roll, clip),
     project(project),
-    sequence(sequence)
+    sequence(sequence),
+    tilesCache(*this)
 {
     this->setPaintingIsUnclipped(true);
-    this->reloadTrackMap();
     this->project.addListener(this);
 }
 
@@ -50,18 +50,19 @@ void PianoClipComponent::paint(Graphics &g)
     // Draw the frame, set the colour, etc:
     ClipComponent::paint(g);
 
-    for (const auto &note : this->displayedNotes)
+    if (this->sequence == nullptr)
     {
-        const auto *ns = note.getSequence();
-        const float sequenceLength = ns->getLengthInBeats();
-        const float beat = note.getBeat() - ns->getFirstBeat();
-        const auto key = jlimit(0, 128, note.getKey() + this->clip.getKey());
-        const float x = float(this->getWidth()) * (beat / sequenceLength);
-        const float w = float(this->getWidth()) * (note.getLength() / sequenceLength);
-        const float h = float(this->getHeight());
-        const float y = roundf(h - key * h / 128.f);
-        g.fillRect(x, y, jmax(0.25f, w), 1.0f);
+        return;
     }
+
+    const float sequenceLength = this->sequence->getLengthInBeats();
+    if (sequenceLength <= 0.f)
+    {
+        return;
+    }
+
+    this->tilesCache.paint(g, this->clip, this->sequence->getFirstBeat(),
+        float(this->getWidth()) / sequenceLength, this->getHeight());
 }
 
 //===----------------------------------------------------------------------===//
@@ -76,12 +77,8 @@ void PianoClipComponent::onChangeMidiEvent(const MidiEvent &oldEvent, const Midi
         const Note &newNote = static_cast<const Note &>(newEvent);
         if (newNote.getSequence() != this->sequence) { return; }
 
-        if (this->displayedNotes.contains(note))
-        {
-            this->displayedNotes.erase(note);
-            this->displayedNotes.insert(newNote);
-        }
-
+        this->tilesCache.invalidate(this->clip, note.getBeat(), note.getBeat() + note.getLength());
+        this->tilesCache.invalidate(this->clip, newNote.getBeat(), newNote.getBeat() + newNote.getLength());
         this->roll.triggerBatchRepaintFor(this);
     }
 }
@@ -93,7 +90,7 @@ void PianoClipComponent::onAddMidiEvent(const MidiEvent &event)
         const Note &note = static_cast<const Note &>(event);
         if (note.getSequence() != this->sequence) { return; }
 
-        this->displayedNotes.insert(note);
+        this->tilesCache.invalidate(this->clip, note.getBeat(), note.getBeat() + note.getLength());
         this->roll.triggerBatchRepaintFor(this);
     }
 }
@@ -105,11 +102,7 @@ void PianoClipComponent::onRemoveMidiEvent(const MidiEvent &event)
         const Note &note = static_cast<const Note &>(event);
         if (note.getSequence() != this->sequence) { return; }
 
-        if (this->displayedNotes.contains(note))
-        {
-            this->displayedNotes.erase(note);
-        }
-
+        this->tilesCache.invalidate(this->clip, note.getBeat(), note.getBeat() + note.getLength());
         this->roll.triggerBatchRepaintFor(this);
     }
 }
@@ -118,6 +111,13 @@ void PianoClipComponent::onChangeClip(const Clip &oldClip, const Clip &newClip)
 {
     if (this->clip == oldClip)
     {
+        // The tiles are aligned to the sequence beats,
+        // so only transposing a clip makes them outdated
+        if (oldClip.getKey() != newClip.getKey())
+        {
+            this->tilesCache.invalidate(this->clip);
+        }
+
         this->updateColours(); // transparency depends on clip velocity
         this->roll.triggerBatchRepaintFor(this);
     }
@@ -133,7 +133,7 @@ void PianoClipComponent::onReloadProjectContent(const Array<MidiTrack *> &tracks
 {
     if (this->sequence != nullptr)
     {
-        this->reloadTrackMap();
+        this->tilesCache.clear();
         this->roll.triggerBatchRepaintFor(this);
     }
 }
@@ -143,7 +143,7 @@ void PianoClipComponent::onAddTrack(MidiTrack *const track)
     if (track->getSequence() == this->sequence &&
         track->getSequence()->size() > 0)
     {
-        this->reloadTrackMap();
+        this->tilesCache.clear();
         this->roll.triggerBatchRepaintFor(this);
     }
 }
@@ -151,37 +151,5 @@ void PianoClipComponent::onAddTrack(MidiTrack *const track)
 void PianoClipComponent::onRemoveTrack(MidiTrack *const track)
 {
     if (track->getSequence() != this->sequence) { return; }
-
-    for (int i = 0; i < track->getSequence()->size(); ++i)
-    {
-        const Note &note = static_cast<const Note &>(*track->getSequence()->getUnchecked(i));
-        if (this->displayedNotes.contains(note))
-        {
-            this->displayedNotes.erase(note);
-        }
-    }
-}
-
-//===----------------------------------------------------------------------===//
-// Private
-//===----------------------------------------------------------------------===//
-
-void PianoClipComponent::reloadTrackMap()
-{
-    this->displayedNotes.clear();
-
-    for (auto *track : this->project.getTracks())
-    {
-        if (track->getSequence() != this->sequence) { continue; }
-
-        for (int j = 0; j < track->getSequence()->size(); ++j)
-        {
-            auto *event = track->getSequence()->getUnchecked(j);
-            if (event != nullptr && event->isTypeOf(MidiEvent::Type::Note))
-            {
-                auto *note = static_cast<Note *>(event);
-                this->displayedNotes.insert(*note);
-            }
-        }
-    }
+    this->tilesCache.clear();
 }
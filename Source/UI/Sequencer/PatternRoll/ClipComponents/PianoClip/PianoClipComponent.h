@@ -20,6 +20,7 @@
 #include "Note.h"
 #include "ClipComponent.h"
 #include "ProjectListener.h"
+#include "PianoMapTilesCache.h"
 
 class HybridRoll;
 class MidiSequence;
@@ -62,11 +63,9 @@ public:
 
 private:
 
-    void reloadTrackMap();
-
     ProjectNode &project;
     WeakReference<MidiSequence> sequence;
-    FlatHashSet<Note, MidiEventHash> displayedNotes;
+    PianoMapTilesCache tilesCache;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PianoClipComponent)
 };
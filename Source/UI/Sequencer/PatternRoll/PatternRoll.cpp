@@ -445,6 +445,7 @@ void PatternRoll::onPostRemoveClip(Pattern *const pattern) {}
 void PatternRoll::onReloadProjectContent(const Array<MidiTrack *> &tracks)
 {
     this->reloadRollContent();
+    HybridRoll::onReloadProjectContent(tracks);
 }
 
 //===----------------------------------------------------------------------===//
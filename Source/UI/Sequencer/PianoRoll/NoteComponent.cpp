@@ -47,7 +47,6 @@ NoteComponent::NoteComponent(PianoRoll &editor, const Note &event, const Clip &c
     this->setPaintingIsUnclipped(true);
     this->setWantsKeyboardFocus(false);
     this->setMouseClickGrabsKeyboardFocus(false);
-    this->setFloatBounds(this->getRoll().getEventBounds(this));
 }
 
 PianoRoll &NoteComponent::getRoll() const noexcept
@@ -0,0 +1,107 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Common.h"
+#include "NoteComponentsIndex.h"
+
+int NoteComponentsIndex::getBarIndex(float beat) noexcept
+{
+    return int(floorf(beat / float(BEATS_PER_BAR)));
+}
+
+uint64 NoteComponentsIndex::getCellIndex(int bar, int key) noexcept
+{
+    // the bars are negative for the notes before zero, so shift them as unsigned
+    return (uint64(uint32(bar)) << 32) | uint64(uint32(key));
+}
+
+void NoteComponentsIndex::add(NoteComponent *nc, float beat, float length, int key)
+{
+    const int firstBar = NoteComponentsIndex::getBarIndex(beat);
+    const int lastBar = NoteComponentsIndex::getBarIndex(beat + length);
+    for (int bar = firstBar; bar <= lastBar; ++bar)
+    {
+        this->cells[NoteComponentsIndex::getCellIndex(bar, key)].add({ nc, firstBar });
+    }
+}
+
+void NoteComponentsIndex::remove(NoteComponent *nc, float beat, float length, int key)
+{
+    const int firstBar = NoteComponentsIndex::getBarIndex(beat);
+    const int lastBar = NoteComponentsIndex::getBarIndex(beat + length);
+    for (int bar = firstBar; bar <= lastBar; ++bar)
+    {
+        const auto cellIndex = NoteComponentsIndex::getCellIndex(bar, key);
+        const auto cell = this->cells.find(cellIndex);
+        if (cell == this->cells.end())
+        {
+            // removing a note from a wrong position, this should never happen:
+            jassertfalse;
+            continue;
+        }
+
+        auto &items = cell.value();
+        for (int i = 0; i < items.size(); ++i)
+        {
+            if (items.getReference(i).component == nc)
+            {
+                items.remove(i);
+                break;
+            }
+        }
+
+        if (items.isEmpty())
+        {
+            this->cells.erase(cell);
+        }
+    }
+}
+
+void NoteComponentsIndex::clear()
+{
+    this->cells.clear();
+}
+
+void NoteComponentsIndex::findNotes(Array<NoteComponent *> &result,
+    float startBeat, float endBeat, int minKey, int maxKey) const
+{
+    const int firstBar = NoteComponentsIndex::getBarIndex(startBeat);
+    const int lastBar = NoteComponentsIndex::getBarIndex(endBeat);
+
+    for (int key = minKey; key <= maxKey; ++key)
+    {
+        for (int bar = firstBar; bar <= lastBar; ++bar)
+        {
+            const auto cell = this->cells.find(NoteComponentsIndex::getCellIndex(bar, key));
+            if (cell == this->cells.end())
+            {
+                continue;
+            }
+
+            for (const auto &item : cell->second)
+            {
+                // a note spanning several bars is listed in each of them,
+                // and is only reported from the first bar within the range:
+                if (bar == jmax(item.firstBar, firstBar))
+                {
+                    result.add(item.component);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+class NoteComponent;
+
+/*
+    A uniform grid of note components over the roll's beats and keys,
+    with a cell for each bar and key, so that the lasso, range selection
+    and hit-testing only visit the notes in the cells they intersect.
+
+    A note is put into the cells of all bars it spans; the positions passed
+    here are absolute, i.e. with the clip's beat and key offsets applied,
+    and removing a note requires the same position it was added at.
+*/
+
+class NoteComponentsIndex final
+{
+public:
+
+    NoteComponentsIndex() = default;
+
+    void add(NoteComponent *nc, float beat, float length, int key);
+    void remove(NoteComponent *nc, float beat, float length, int key);
+    void clear();
+
+    // Collects the components of the notes intersecting the given range
+    // (both inclusive), each component only once; the caller is still
+    // supposed to do the precise checks, if needed:
+    void findNotes(Array<NoteComponent *> &result,
+        float startBeat, float endBeat, int minKey, int maxKey) const;
+
+private:
+
+    struct Item final
+    {
+        NoteComponent *component;
+        int firstBar; // used to report the long notes only once
+    };
+
+    static int getBarIndex(float beat) noexcept;
+    static uint64 getCellIndex(int bar, int key) noexcept;
+
+    FlatHashMap<uint64, Array<Item>> cells;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteComponentsIndex)
+};
@@ -64,6 +64,30 @@
 
 #define DEFAULT_NOTE_LENGTH 0.25f
 
+// Set to 1 to log the time spent on loading, resizing and painting the roll,
+// e.g. to compare the frame times of opening, scrolling and zooming large projects
+#define PIANOROLL_LOGS_FRAME_TIMES 0
+
+#if PIANOROLL_LOGS_FRAME_TIMES
+struct PianoRollFrameTimer final
+{
+    explicit PianoRollFrameTimer(const char *const name) :
+        name(name), startTime(Time::getMillisecondCounterHiRes()) {}
+
+    ~PianoRollFrameTimer()
+    {
+        const auto ms = Time::getMillisecondCounterHiRes() - this->startTime;
+        DBG(String(this->name) + " done in " + String(ms, 3) + " ms");
+    }
+
+    const char *const name;
+    const double startTime;
+};
+#   define PIANOROLL_FRAME_TIMER(name) const PianoRollFrameTimer frameTimer(name);
+#else
+#   define PIANOROLL_FRAME_TIMER(name)
+#endif
+
 #define forEachEventOfGivenTrack(map, child, track) \
     for (const auto &_c : map) \
         if (_c.first.getPattern()->getTrack() == track) \
@@ -73,9 +97,6 @@
     for (const auto &child : map) \
         if (child.first.getPattern()->getTrack() == track)
 
-#define forEachEventComponent(map, child) \
-    for (const auto &_c : this->patternMap) \
-        for (const auto &child : (*_c.second.get()))
 
 
 PianoRoll::PianoRoll(ProjectNode &parentProject,
@@ -92,7 +113,6 @@ PianoRoll::PianoRoll(ProjectNode &parentProject,
     defaultHighlighting() // default pattern (black and white keys)
 {
     this->defaultHighlighting.reset(new HighlightingScheme(0, Scale::getNaturalMajorScale()));
-    this->defaultHighlighting->setRows(this->renderBackgroundCacheFor(this->defaultHighlighting.get()));
 
     this->selectedNotesMenuManager.reset(new PianoRollSelectionMenuManager(&this->selection, this->project));
 
@@ -108,60 +128,189 @@ PianoRoll::PianoRoll(ProjectNode &parentProject,
 
 void PianoRoll::reloadRollContent()
 {
+    PIANOROLL_FRAME_TIMER("PianoRoll::reloadRollContent")
+
     this->selection.deselectAll();
     this->backgroundsCache.clear();
     this->patternMap.clear();
+    this->notesIndex.clear();
 
     HYBRID_ROLL_BULK_REPAINT_START
 
-    const auto &tracks = this->project.getTracks();
-    for (const auto *track : tracks)
+    // All key signatures live in the timeline, no need to look for them in other tracks:
+    const auto *keySignatures = this->project.getTimeline()->getKeySignatures()->getSequence();
+    for (int i = 0; i < keySignatures->size(); ++i)
     {
-        this->loadTrack(track);
+        const auto &key = static_cast<const KeySignatureEvent &>(*keySignatures->getUnchecked(i));
+        this->updateBackgroundCacheFor(key);
+    }
 
-        // Re-render backgrounds for all key signatures:
-        for (int j = 0; j < track->getSequence()->size(); ++j)
+    // Only load the notes around the viewport, the rest are loaded when scrolled into view:
+    this->loadedBeatRange = {};
+    this->loadVisibleClipsIfNeeded();
+
+    this->loadActiveClip();
+
+    this->repaint(this->viewport.getViewArea());
+
+    HYBRID_ROLL_BULK_REPAINT_END
+}
+
+// Returns true if any of the track's clips were loaded
+bool PianoRoll::loadTrack(const MidiTrack *const track)
+{
+    if (track->getPattern() == nullptr ||
+        dynamic_cast<const PianoSequence *>(track->getSequence()) == nullptr)
+    {
+        return false;
+    }
+
+    bool hasLoadedClips = false;
+    for (int i = 0; i < track->getPattern()->size(); ++i)
+    {
+        const Clip *clip = track->getPattern()->getUnchecked(i);
+        if (!this->patternMap.contains(*clip) &&
+            (*clip == this->activeClip || this->isClipInLoadedRange(*clip)))
         {
-            const MidiEvent *event = track->getSequence()->getUnchecked(j);
-            if (event->isTypeOf(MidiEvent::Type::KeySignature))
+            this->loadClip(*clip);
+            hasLoadedClips = true;
+        }
+    }
+
+    return hasLoadedClips;
+}
+
+// Creates the components for the clip's notes within the loaded range,
+// or for all of them, if the clip is active; the ones created before are kept
+void PianoRoll::loadClip(const Clip &clip)
+{
+    const auto *sequence = clip.getPattern()->getTrack()->getSequence();
+
+    auto found = this->patternMap.find(clip);
+    if (found == this->patternMap.end())
+    {
+        found = this->patternMap.emplace(clip, UniquePointer<SequenceMap>(new SequenceMap())).first;
+    }
+
+    auto &sequenceMap = *found->second.get();
+    const bool loadsAllNotes = (clip == this->activeClip);
+
+    for (int j = 0; j < sequence->size(); ++j)
+    {
+        const MidiEvent *event = sequence->getUnchecked(j);
+        if (!event->isTypeOf(MidiEvent::Type::Note))
+        {
+            continue;
+        }
+
+        const Note *note = static_cast<const Note *>(event);
+        if (!loadsAllNotes)
+        {
+            // the notes are sorted by beat, so nothing further is in range
+            const float beat = note->getBeat() + clip.getBeat();
+            if (beat > this->loadedBeatRange.getEnd())
+            {
+                break;
+            }
+
+            if (beat + note->getLength() < this->loadedBeatRange.getStart())
             {
-                const auto &key = static_cast<const KeySignatureEvent &>(*event);
-                this->updateBackgroundCacheFor(key);
+                continue;
             }
         }
+
+        if (!sequenceMap.contains(*note))
+        {
+            this->loadNote(sequenceMap, *note, clip);
+        }
     }
+}
 
-    this->repaint(this->viewport.getViewArea());
+// The active clip is always loaded in full, even if it's not visible,
+// so that selection and editing tools can see all of its notes
+void PianoRoll::loadActiveClip()
+{
+    if (this->activeTrack == nullptr ||
+        this->activeTrack->getPattern() == nullptr ||
+        dynamic_cast<const PianoSequence *>(this->activeTrack->getSequence()) == nullptr)
+    {
+        return;
+    }
 
-    HYBRID_ROLL_BULK_REPAINT_END
+    // the components refer to the pattern's own clip instance
+    const auto *pattern = this->activeTrack->getPattern();
+    const int i = pattern->indexOfSorted(&this->activeClip);
+    if (i >= 0)
+    {
+        this->loadClip(*pattern->getUnchecked(i));
+    }
+}
+
+NoteComponent *PianoRoll::loadNote(SequenceMap &sequenceMap, const Note &note, const Clip &clip)
+{
+    auto nc = new NoteComponent(*this, note, clip);
+    sequenceMap[note] = UniquePointer<NoteComponent>(nc);
+    this->addToNotesIndex(nc, note, clip);
+    const bool isActive = nc->belongsTo(this->activeTrack, this->activeClip);
+    this->updateNoteComponentActivity(nc, isActive);
+    return nc;
+}
+
+bool PianoRoll::isNoteInLoadedRange(const Note &note, const Clip &clip) const
+{
+    const float beat = note.getBeat() + clip.getBeat();
+    return clip == this->activeClip ||
+        Range<float>(beat, beat + note.getLength()).intersects(this->loadedBeatRange);
 }
 
-void PianoRoll::loadTrack(const MidiTrack *const track)
+Range<float> PianoRoll::getVisibleBeatRange() const
 {
-    if (track->getPattern() == nullptr)
+    const int viewX = this->viewport.getViewPositionX();
+    const int viewWidth = this->viewport.getViewWidth();
+    return { this->getBarByXPosition(viewX) * float(BEATS_PER_BAR),
+        this->getBarByXPosition(viewX + viewWidth) * float(BEATS_PER_BAR) };
+}
+
+bool PianoRoll::isClipInLoadedRange(const Clip &clip) const
+{
+    // an empty sequence's range is empty, and it never intersects anything
+    const auto *sequence = clip.getPattern()->getTrack()->getSequence();
+    const Range<float> clipRange(sequence->getFirstBeat() + clip.getBeat(),
+        sequence->getLastBeat() + clip.getBeat());
+
+    return clipRange.intersects(this->loadedBeatRange);
+}
+
+void PianoRoll::loadVisibleClipsIfNeeded()
+{
+    const auto visibleRange = this->getVisibleBeatRange();
+    if (!this->loadedBeatRange.isEmpty() &&
+        this->loadedBeatRange.contains(visibleRange))
     {
         return;
     }
 
-    for (int i = 0; i < track->getPattern()->size(); ++i)
-    {
-        const Clip *clip = track->getPattern()->getUnchecked(i);
+    PIANOROLL_FRAME_TIMER("PianoRoll::loadVisibleClipsIfNeeded")
 
-        auto sequenceMap = new SequenceMap();
-        this->patternMap[*clip] = UniquePointer<SequenceMap>(sequenceMap);
+    // the notes loaded before are kept, as most likely they will be scrolled back to
+    this->loadedBeatRange = visibleRange.expanded(visibleRange.getLength());
 
-        for (int j = 0; j < track->getSequence()->size(); ++j)
+    const auto &tracks = this->project.getTracks();
+    for (const auto *track : tracks)
+    {
+        if (track->getPattern() == nullptr ||
+            dynamic_cast<const PianoSequence *>(track->getSequence()) == nullptr)
+        {
+            continue;
+        }
+
+        // the clips loaded before might be missing the notes of the new range
+        for (int i = 0; i < track->getPattern()->size(); ++i)
         {
-            const MidiEvent *event = track->getSequence()->getUnchecked(j);
-            if (event->isTypeOf(MidiEvent::Type::Note))
+            const Clip *clip = track->getPattern()->getUnchecked(i);
+            if (this->isClipInLoadedRange(*clip))
             {
-                const Note *note = static_cast<const Note *>(event);
-                auto nc = new NoteComponent(*this, *note, *clip);
-                (*sequenceMap)[*note] = UniquePointer<NoteComponent>(nc);
-                const bool isActive = nc->belongsTo(this->activeTrack, this->activeClip);
-                nc->setActive(isActive, true);
-                this->addAndMakeVisible(nc);
-                nc->setFloatBounds(this->getEventBounds(nc));
+                this->loadClip(*clip);
             }
         }
     }
@@ -180,6 +329,76 @@ void PianoRoll::updateActiveRangeIndicator() const
     }
 }
 
+void PianoRoll::updateNoteComponentActivity(NoteComponent *nc, bool isActive)
+{
+    if (isActive && nc->getParentComponent() != this)
+    {
+        this->addAndMakeVisible(nc);
+        nc->setFloatBounds(this->getEventBounds(nc));
+    }
+    else if (!isActive && nc->getParentComponent() == this)
+    {
+        this->removeChildComponent(nc);
+    }
+
+    nc->setActive(isActive, true);
+}
+
+PianoRoll::SequenceMap *PianoRoll::findActiveSequenceMap() const
+{
+    if (this->activeTrack == nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto found = this->patternMap.find(this->activeClip);
+    return (found != this->patternMap.end()) ? found->second.get() : nullptr;
+}
+
+NoteComponent *PianoRoll::findInactiveNoteAt(const Point<float> &position) const
+{
+    const int x = int(position.getX());
+    const int y = int(position.getY());
+    const float beat = this->getBarByXPosition(x) * float(BEATS_PER_BAR);
+
+    int minKey = 0, maxKey = 0;
+    this->getKeysRangeByYPositions(y, y, minKey, maxKey);
+
+    Array<NoteComponent *> candidates;
+    this->notesIndex.findNotes(candidates, beat, beat, minKey, maxKey);
+
+    for (auto *nc : candidates)
+    {
+        if (!nc->isActive() && this->getEventBounds(nc).contains(position))
+        {
+            return nc;
+        }
+    }
+
+    return nullptr;
+}
+
+void PianoRoll::addToNotesIndex(NoteComponent *nc, const Note &note, const Clip &clip)
+{
+    this->notesIndex.add(nc, note.getBeat() + clip.getBeat(),
+        note.getLength(), note.getKey() + clip.getKey());
+}
+
+void PianoRoll::removeFromNotesIndex(NoteComponent *nc, const Note &note, const Clip &clip)
+{
+    this->notesIndex.remove(nc, note.getBeat() + clip.getBeat(),
+        note.getLength(), note.getKey() + clip.getKey());
+}
+
+// returns a slightly wider range of keys, which covers the given positions
+void PianoRoll::getKeysRangeByYPositions(int y1, int y2, int &outMinKey, int &outMaxKey) const noexcept
+{
+    const int keyAtY1 = (this->getHeight() - y1) / this->rowHeight;
+    const int keyAtY2 = (this->getHeight() - y2) / this->rowHeight;
+    outMinKey = jlimit(-128, 256, jmin(keyAtY1, keyAtY2) - 1);
+    outMaxKey = jlimit(-128, 256, jmax(keyAtY1, keyAtY2) + 1);
+}
+
 WeakReference<MidiTrack> PianoRoll::getActiveTrack() const noexcept { return this->activeTrack; }
 const Clip &PianoRoll::getActiveClip() const noexcept { return this->activeClip; }
 
@@ -201,23 +420,25 @@ void PianoRoll::setRowHeight(int newRowHeight)
 
 void PianoRoll::selectAll()
 {
-    forEachEventComponent(this->patternMap, e)
+    if (auto *activeMap = this->findActiveSequenceMap())
     {
-        const auto childComponent = e.second.get();
-        if (childComponent->belongsTo(this->activeTrack, activeClip))
+        for (const auto &e : *activeMap)
         {
-            this->selection.addToSelection(childComponent);
+            this->selection.addToSelection(e.second.get());
         }
     }
 }
 
 void PianoRoll::setChildrenInteraction(bool interceptsMouse, MouseCursor cursor)
 {
-    forEachEventComponent(this->patternMap, e)
+    if (auto *activeMap = this->findActiveSequenceMap())
     {
-        const auto childComponent = e.second.get();
-        childComponent->setInterceptsMouseClicks(interceptsMouse, interceptsMouse);
-        childComponent->setMouseCursor(cursor);
+        for (const auto &e : *activeMap)
+        {
+            const auto childComponent = e.second.get();
+            childComponent->setInterceptsMouseClicks(interceptsMouse, interceptsMouse);
+            childComponent->setMouseCursor(cursor);
+        }
     }
 }
 
@@ -229,6 +450,7 @@ void PianoRoll::showGhostNoteFor(NoteComponent *target)
 {
     auto component = new NoteComponent(*this, target->getNote(), target->getClip());
     component->setEnabled(false);
+    component->setFloatBounds(this->getEventBounds(component));
 
     //component->setAlpha(0.2f); // setAlpha makes everything slower
     component->setGhostMode(); // use this, Luke.
@@ -261,7 +483,10 @@ void PianoRoll::longTapEvent(const Point<float> &position,
     if (!this->multiTouchController->hasMultitouch() &&
         !this->getEditMode().forbidsSelectionMode())
     {
-        const auto *nc = dynamic_cast<NoteComponent *>(target.get());
+        const auto *nc = (target == this) ?
+            this->findInactiveNoteAt(position) :
+            dynamic_cast<NoteComponent *>(target.get());
+
         if (nc != nullptr && !nc->isActive())
         {
             auto *track = nc->getNote().getSequence()->getTrack();
@@ -446,8 +671,28 @@ void PianoRoll::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &ne
         forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
         {
             auto &sequenceMap = *c.second.get();
-            if (const auto component = sequenceMap[note].release())
+            const auto found = sequenceMap.find(note);
+            if (found == sequenceMap.end())
             {
+                // The note wasn't loaded, as it was out of the loaded range, but it might have moved in:
+                const int i = track->getPattern()->indexOfSorted(&c.first);
+                jassert(i >= 0);
+
+                const Clip *realClip = track->getPattern()->getUnchecked(i);
+                if (this->isNoteInLoadedRange(newNote, *realClip))
+                {
+                    auto *component = this->loadNote(sequenceMap, newNote, *realClip);
+                    if (!component->isActive())
+                    {
+                        this->repaint(this->getEventBounds(component).getSmallestIntegerContainer());
+                    }
+                }
+            }
+            else if (const auto component = found.value().release())
+            {
+                this->removeFromNotesIndex(component, note, component->getClip());
+                this->addToNotesIndex(component, newNote, component->getClip());
+
                 // Pass ownership to another key:
                 sequenceMap.erase(note);
                 // Hitting this assert means that a track somehow contains events
@@ -455,10 +700,29 @@ void PianoRoll::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &ne
                 jassert(!sequenceMap.contains(newNote));
                 // Always erase before updating, as it may happen both events have the same hash code:
                 sequenceMap[newNote] = UniquePointer<NoteComponent>(component);
-                // Schedule to be repainted later:
-                this->triggerBatchRepaintFor(component);
+
+                if (component->isActive())
+                {
+                    // Schedule to be repainted later:
+                    this->triggerBatchRepaintFor(component);
+                }
+                else
+                {
+                    // Inactive notes are painted by the roll itself:
+                    const Clip &clip = component->getClip();
+                    this->repaint(this->getEventBounds(note.getKey() + clip.getKey(),
+                        note.getBeat() + clip.getBeat(), note.getLength()).getSmallestIntegerContainer());
+                    this->repaint(this->getEventBounds(newNote.getKey() + clip.getKey(),
+                        newNote.getBeat() + clip.getBeat(), newNote.getLength()).getSmallestIntegerContainer());
+                }
             }
         }
+
+        // The note might have moved some not yet loaded clip into view:
+        if (this->loadTrack(track))
+        {
+            this->repaint(this->viewport.getViewArea());
+        }
     }
     else if (oldEvent.isTypeOf(MidiEvent::Type::KeySignature))
     {
@@ -493,18 +757,24 @@ void PianoRoll::onAddMidiEvent(const MidiEvent &event)
             const Clip *realClip = track->getPattern()->getUnchecked(i);
             auto component = new NoteComponent(*this, note, *realClip);
             sequenceMap[note] = UniquePointer<NoteComponent>(component);
-            this->addAndMakeVisible(component);
-
-            this->fader.fadeIn(component, 150);
+            this->addToNotesIndex(component, note, *realClip);
 
             // TODO check this in a more elegant way
             // (needed not to break shift+drag note copying)
             const bool isCurrentlyDraggingNote = this->draggingHelper->isVisible();
 
             const bool isActive = component->belongsTo(this->activeTrack, this->activeClip);
-            component->setActive(isActive, true);
+            this->updateNoteComponentActivity(component, isActive);
 
-            this->triggerBatchRepaintFor(component);
+            if (isActive)
+            {
+                this->fader.fadeIn(component, 150);
+                this->triggerBatchRepaintFor(component);
+            }
+            else
+            {
+                this->repaint(this->getEventBounds(component).getSmallestIntegerContainer());
+            }
 
             // arpeggiators preview cannot work without that:
             if (isActive && !isCurrentlyDraggingNote)
@@ -519,6 +789,11 @@ void PianoRoll::onAddMidiEvent(const MidiEvent &event)
                 this->selectEvent(this->newNoteDragging, true); // clear prev selection
             }
         }
+
+        if (this->loadTrack(track))
+        {
+            this->repaint(this->viewport.getViewArea());
+        }
     }
     else if (event.isTypeOf(MidiEvent::Type::KeySignature))
     {
@@ -547,8 +822,17 @@ void PianoRoll::onRemoveMidiEvent(const MidiEvent &event)
             if (sequenceMap.contains(note))
             {
                 NoteComponent *deletedComponent = sequenceMap[note].get();
-                this->fader.fadeOut(deletedComponent, 150);
-                this->selection.deselect(deletedComponent);
+                this->removeFromNotesIndex(deletedComponent, note, deletedComponent->getClip());
+                if (deletedComponent->isActive())
+                {
+                    this->fader.fadeOut(deletedComponent, 150);
+                    this->selection.deselect(deletedComponent);
+                }
+                else
+                {
+                    this->repaint(this->getEventBounds(deletedComponent).getSmallestIntegerContainer());
+                }
+
                 sequenceMap.erase(note);
             }
         }
@@ -565,40 +849,12 @@ void PianoRoll::onRemoveMidiEvent(const MidiEvent &event)
 
 void PianoRoll::onAddClip(const Clip &clip)
 {
-    const SequenceMap *referenceMap = nullptr;
-    const auto *track = clip.getPattern()->getTrack();
-
-    forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-    {
-        // Found a sequence map for the same track
-        referenceMap = c.second.get();
-        break;
-    }
-
-    if (referenceMap == nullptr)
+    // The clip is only loaded here if it's visible, otherwise
+    // it will be loaded later, when scrolled into view
+    if (this->loadTrack(clip.getPattern()->getTrack()))
     {
-        jassertfalse;
-        return;
-    }
-
-    auto sequenceMap = new SequenceMap();
-    this->patternMap[clip] = UniquePointer<SequenceMap>(sequenceMap);
-
-    for (const auto &e : *referenceMap)
-    {
-        // reference the same note as neighbor components:
-        const auto &note = e.second.get()->getNote();
-        auto component = new NoteComponent(*this, note, clip);
-        (*sequenceMap)[note] = UniquePointer<NoteComponent>(component);
-        this->addAndMakeVisible(component);
-
-        const bool isActive = component->belongsTo(this->activeTrack, this->activeClip);
-        component->setActive(isActive);
-
-        this->batchRepaintList.add(component);
+        this->repaint(this->viewport.getViewArea());
     }
-
-    this->triggerAsyncUpdate();
 }
 
 void PianoRoll::onChangeClip(const Clip &clip, const Clip &newClip)
@@ -608,7 +864,16 @@ void PianoRoll::onChangeClip(const Clip &clip, const Clip &newClip)
         this->activeClip = newClip;
     }
 
-    if (auto *sequenceMap = this->patternMap[clip].release())
+    const auto found = this->patternMap.find(clip);
+    if (found == this->patternMap.end())
+    {
+        // Not loaded yet, but might have been moved into view
+        if (this->loadTrack(newClip.getPattern()->getTrack()))
+        {
+            this->repaint(this->viewport.getViewArea());
+        }
+    }
+    else if (auto *sequenceMap = found.value().release())
     {
         // Set new key for existing sequence map
         this->patternMap.erase(clip);
@@ -617,7 +882,16 @@ void PianoRoll::onChangeClip(const Clip &clip, const Clip &newClip)
         // And update all components within it, as their beats should change
         for (const auto &e : *sequenceMap)
         {
-            this->batchRepaintList.add(e.second.get());
+            auto *component = e.second.get();
+            this->removeFromNotesIndex(component, component->getNote(), clip);
+            this->addToNotesIndex(component, component->getNote(), newClip);
+            this->batchRepaintList.add(component);
+        }
+
+        // The clip might have moved more of its notes into the loaded range:
+        if (this->isClipInLoadedRange(newClip))
+        {
+            this->loadClip(newClip);
         }
 
         if (newClip == this->activeClip)
@@ -636,6 +910,11 @@ void PianoRoll::onRemoveClip(const Clip &clip)
 
     if (this->patternMap.contains(clip))
     {
+        for (const auto &e : *this->patternMap[clip].get())
+        {
+            this->removeFromNotesIndex(e.second.get(), e.first, clip);
+        }
+
         this->patternMap.erase(clip);
     }
 
@@ -663,11 +942,11 @@ void PianoRoll::onAddTrack(MidiTrack *const track)
 
     this->loadTrack(track);
 
-    for (int j = 0; j < track->getSequence()->size(); ++j)
+    if (dynamic_cast<const KeySignaturesSequence *>(track->getSequence()))
     {
-        const MidiEvent *const event = track->getSequence()->getUnchecked(j);
-        if (event->isTypeOf(MidiEvent::Type::KeySignature))
+        for (int j = 0; j < track->getSequence()->size(); ++j)
         {
+            const MidiEvent *const event = track->getSequence()->getUnchecked(j);
             const KeySignatureEvent &key = static_cast<const KeySignatureEvent &>(*event);
             this->updateBackgroundCacheFor(key);
         }
@@ -686,11 +965,11 @@ void PianoRoll::onRemoveTrack(MidiTrack *const track)
     this->hideHelpers();
     this->hideAllGhostNotes(); // Avoids crash
 
-    for (int i = 0; i < track->getSequence()->size(); ++i)
+    if (dynamic_cast<const KeySignaturesSequence *>(track->getSequence()))
     {
-        const auto *event = track->getSequence()->getUnchecked(i);
-        if (event->isTypeOf(MidiEvent::Type::KeySignature))
+        for (int i = 0; i < track->getSequence()->size(); ++i)
         {
+            const auto *event = track->getSequence()->getUnchecked(i);
             const KeySignatureEvent &key = static_cast<const KeySignatureEvent &>(*event);
             this->removeBackgroundCacheFor(key);
         }
@@ -701,6 +980,11 @@ void PianoRoll::onRemoveTrack(MidiTrack *const track)
         const auto &clip = *track->getPattern()->getUnchecked(i);
         if (this->patternMap.contains(clip))
         {
+            for (const auto &e : *this->patternMap[clip].get())
+            {
+                this->removeFromNotesIndex(e.second.get(), e.first, clip);
+            }
+
             this->patternMap.erase(clip);
         }
     }
@@ -711,6 +995,7 @@ void PianoRoll::onRemoveTrack(MidiTrack *const track)
 void PianoRoll::onReloadProjectContent(const Array<MidiTrack *> &tracks)
 {
     this->reloadRollContent();
+    HybridRoll::onReloadProjectContent(tracks);
 }
 
 void PianoRoll::onChangeProjectBeatRange(float firstBeat, float lastBeat)
@@ -736,28 +1021,44 @@ void PianoRoll::onChangeViewEditableScope(MidiTrack *const activeTrack,
 
     this->selection.deselectAll();
 
+    // only the previously active and the new active clips need to be updated:
+    auto *previousMap = this->findActiveSequenceMap();
+    if (previousMap != nullptr && !(this->activeClip == activeClip))
+    {
+        for (const auto &e : *previousMap)
+        {
+            this->updateNoteComponentActivity(e.second.get(), false);
+        }
+    }
+
     this->activeTrack = activeTrack;
     this->activeClip = activeClip;
 
+    this->loadActiveClip();
+
     int focusMinKey = INT_MAX;
     int focusMaxKey = 0;
     float focusMinBeat = FLT_MAX;
     float focusMaxBeat = -FLT_MAX;
 
-    forEachEventComponent(this->patternMap, e)
+    if (auto *activeMap = this->findActiveSequenceMap())
     {
-        auto *nc = e.second.get();
-        const bool isActive = nc->belongsTo(this->activeTrack, this->activeClip);
-        const auto key = nc->getKey() + activeClip.getKey();
-        nc->setActive(isActive, true);
-
-        if (shouldFocus && isActive)
+        for (const auto &e : *activeMap)
         {
-            focusMinKey = jmin(focusMinKey, key);
-            focusMaxKey = jmax(focusMaxKey, key);
-            focusMinBeat = jmin(focusMinBeat, nc->getBeat());
-            focusMaxBeat = jmax(focusMaxBeat, nc->getBeat() + nc->getLength());
+            auto *nc = e.second.get();
+            const auto key = nc->getKey() + activeClip.getKey();
+            this->updateNoteComponentActivity(nc, true);
+
+            if (shouldFocus)
+            {
+                focusMinKey = jmin(focusMinKey, key);
+                focusMaxKey = jmax(focusMaxKey, key);
+                focusMinBeat = jmin(focusMinBeat, nc->getBeat());
+                focusMaxBeat = jmax(focusMaxBeat, nc->getBeat() + nc->getLength());
+            }
         }
+
+        this->applyEditModeUpdates();
     }
 
     // FIXME: zoom empty tracks properly
@@ -787,38 +1088,77 @@ void PianoRoll::selectEventsInRange(float startBeat, float endBeat, bool shouldC
         this->selection.deselectAll();
     }
 
-    forEachEventComponent(this->patternMap, e)
+    auto *activeMap = this->findActiveSequenceMap();
+    if (activeMap == nullptr)
+    {
+        return;
+    }
+
+    // the sequence is sorted by beat, so only the notes in range are visited
+    const auto *sequence = this->activeTrack->getSequence();
+    const float clipStartBeat = startBeat - this->activeClip.getBeat();
+    const float clipEndBeat = endBeat - this->activeClip.getBeat();
+
+    int low = 0;
+    int high = sequence->size();
+    while (low < high)
+    {
+        const int mid = (low + high) / 2;
+        if (sequence->getUnchecked(mid)->getBeat() < clipStartBeat)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    for (int i = low; i < sequence->size(); ++i)
     {
-        auto *component = e.second.get();
-        if (component->isActive() &&
-            (component->getNote().getBeat() + component->getClip().getBeat()) >= startBeat &&
-            (component->getNote().getBeat() + component->getClip().getBeat()) < endBeat)
+        const auto *event = sequence->getUnchecked(i);
+        if (event->getBeat() >= clipEndBeat)
         {
-            this->selection.addToSelection(component);
+            break;
+        }
+
+        if (event->isTypeOf(MidiEvent::Type::Note))
+        {
+            const auto &note = static_cast<const Note &>(*event);
+            const auto found = activeMap->find(note);
+            if (found != activeMap->end())
+            {
+                this->selection.addToSelection(found->second.get());
+            }
         }
     }
 }
 
 void PianoRoll::findLassoItemsInArea(Array<SelectableComponent *> &itemsFound, const Rectangle<int> &rectangle)
 {
-    forEachEventComponent(this->patternMap, e)
+    // only the active clip's notes are selectable
+    auto *activeMap = this->findActiveSequenceMap();
+    if (activeMap == nullptr)
     {
-        const auto component = e.second.get();
-        component->setSelected(false);
+        return;
     }
 
-    for (const auto component : this->selection)
-    {
-        component->setSelected(true);
-    }
-    
-    forEachEventComponent(this->patternMap, e)
+    // no need to update the selected state of every component here,
+    // since the lasso updates it for the changed items only
+    const float startBeat = this->getBarByXPosition(rectangle.getX()) * float(BEATS_PER_BAR);
+    const float endBeat = this->getBarByXPosition(rectangle.getRight()) * float(BEATS_PER_BAR);
+
+    int minKey = 0, maxKey = 0;
+    this->getKeysRangeByYPositions(rectangle.getY(), rectangle.getBottom(), minKey, maxKey);
+
+    Array<NoteComponent *> candidates;
+    this->notesIndex.findNotes(candidates, startBeat, endBeat, minKey, maxKey);
+
+    for (auto *component : candidates)
     {
-        const auto component = e.second.get();
-        if (rectangle.intersects(component->getBounds()) && component->isActive())
+        if (component->isActive() && rectangle.intersects(component->getBounds()))
         {
-            component->setSelected(true);
-            itemsFound.addIfNotAlreadyThere(component);
+            itemsFound.add(component);
         }
     }
 }
@@ -844,6 +1184,17 @@ void PianoRoll::mouseDown(const MouseEvent &e)
         return;
     }
     
+    // the inactive notes are not components, so the roll checks
+    // if the quick layer selection click has hit one of them:
+    if (e.eventComponent == this &&
+        (e.mods.isAltDown() || e.mods.isRightButtonDown()))
+    {
+        if (auto *nc = this->findInactiveNoteAt(e.position))
+        {
+            nc->switchActiveSegmentToSelected(e.mods.isAnyModifierKeyDown());
+        }
+    }
+
     if (! this->isUsingSpaceDraggingMode())
     {
         this->setInterceptsMouseClicks(true, false);
@@ -1136,12 +1487,17 @@ void PianoRoll::resized()
         return;
     }
 
+    PIANOROLL_FRAME_TIMER("PianoRoll::resized")
+
     HYBRID_ROLL_BULK_REPAINT_START
 
-    forEachEventComponent(this->patternMap, e)
+    if (auto *activeMap = this->findActiveSequenceMap())
     {
-        const auto component = e.second.get();
-        component->setFloatBounds(this->getEventBounds(component));
+        for (const auto &e : *activeMap)
+        {
+            const auto component = e.second.get();
+            component->setFloatBounds(this->getEventBounds(component));
+        }
     }
 
     for (const auto component : this->ghostNotes)
@@ -1162,6 +1518,8 @@ void PianoRoll::resized()
 
 void PianoRoll::paint(Graphics &g)
 {
+    PIANOROLL_FRAME_TIMER("PianoRoll::paint")
+
     const auto *keysSequence = this->project.getTimeline()->getKeySignatures()->getSequence();
     const int paintStartX = this->viewport.getViewPositionX();
     const int paintEndX = paintStartX + this->viewport.getViewWidth();
@@ -1169,7 +1527,7 @@ void PianoRoll::paint(Graphics &g)
     static const float paintOffsetY = float(HYBRID_ROLL_HEADER_HEIGHT);
 
     int prevBarX = paintStartX;
-    const HighlightingScheme *prevScheme = nullptr;
+    HighlightingScheme *prevScheme = nullptr;
     const int y = this->viewport.getViewPositionY();
     const int h = this->viewport.getViewHeight();
 
@@ -1187,14 +1545,15 @@ void PianoRoll::paint(Graphics &g)
         }
 #endif
 
-        const auto *s = (prevScheme == nullptr) ? this->backgroundsCache.getUnchecked(index) : prevScheme;
-        const FillType fillType(s->getUnchecked(this->rowHeight), AffineTransform::translation(0.f, paintOffsetY));
+        auto *s = (prevScheme == nullptr) ? this->backgroundsCache.getUnchecked(index) : prevScheme;
+        const FillType fillType(this->getBackgroundCacheFor(s), AffineTransform::translation(0.f, paintOffsetY));
         g.setFillType(fillType);
 
         if (barX >= paintEndX)
         {
             g.fillRect(prevBarX, y, barX - prevBarX, h);
             HybridRoll::paint(g);
+            this->paintInactiveNotes(g);
             return;
         }
         else if (barX >= paintStartX)
@@ -1208,11 +1567,104 @@ void PianoRoll::paint(Graphics &g)
 
     if (prevBarX < paintEndX)
     {
-        const auto *s = (prevScheme == nullptr) ? this->defaultHighlighting.get() : prevScheme;
-        const FillType fillType(s->getUnchecked(this->rowHeight), AffineTransform::translation(0.f, paintOffsetY));
+        auto *s = (prevScheme == nullptr) ? this->defaultHighlighting.get() : prevScheme;
+        const FillType fillType(this->getBackgroundCacheFor(s), AffineTransform::translation(0.f, paintOffsetY));
         g.setFillType(fillType);
         g.fillRect(prevBarX, y, paintEndX - prevBarX, h);
         HybridRoll::paint(g);
+        this->paintInactiveNotes(g);
+    }
+}
+
+void PianoRoll::paintInactiveNotes(Graphics &g) const
+{
+    const auto paintBounds = g.getClipBounds();
+    const float paintEndBeat = this->getBarByXPosition(paintBounds.getRight()) * float(BEATS_PER_BAR);
+    const auto baseColour = findDefaultColour(ColourIDs::Roll::noteFill);
+
+    Array<Rectangle<float>> visibleNotes;
+
+    for (const auto &c : this->patternMap)
+    {
+        const auto &clip = c.first;
+        if (clip == this->activeClip || c.second->size() == 0)
+        {
+            continue;
+        }
+
+        const auto *track = clip.getPattern()->getTrack();
+        const auto *sequence = track->getSequence();
+
+        // the notes are sorted by beat, so it is enough
+        // to collect them up to the end of the painted area
+        visibleNotes.clearQuick();
+        for (int i = 0; i < sequence->size(); ++i)
+        {
+            const auto *event = sequence->getUnchecked(i);
+            if (!event->isTypeOf(MidiEvent::Type::Note))
+            {
+                continue;
+            }
+
+            const auto &note = static_cast<const Note &>(*event);
+            const float beat = note.getBeat() + clip.getBeat();
+            if (beat > paintEndBeat)
+            {
+                break;
+            }
+
+            const auto bounds = this->getEventBounds(note.getKey() + clip.getKey(),
+                beat, note.getLength());
+
+            if (bounds.intersects(paintBounds.toFloat()))
+            {
+                visibleNotes.add(bounds);
+            }
+        }
+
+        if (visibleNotes.isEmpty())
+        {
+            continue;
+        }
+
+        // the same colours as NoteComponent::updateColours() uses for inactive notes
+        const auto colour = track->getTrackColour()
+            .interpolatedWith(baseColour, 0.35f).brighter(0.55f).withAlpha(0.3f);
+
+        // the same shapes as NoteComponent::paint() draws,
+        // except for the volume bar, which is hidden for inactive notes
+        g.setColour(colour);
+        for (const auto &r : visibleNotes)
+        {
+            const float w = r.getWidth() - .5f;
+            const float h = r.getHeight();
+            g.fillRect(r.getX() + 0.5f, r.getY() + h / 6.f, 0.5f, h / 1.5f);
+            if (w >= 1.25f)
+            {
+                g.fillRect(r.getX() + w - 0.75f, r.getY() + h / 6.f, 0.5f, h / 1.5f);
+                g.fillRect(r.getX() + 0.75f, r.getY() + 1.f, w - 1.25f, h - 2.f);
+            }
+        }
+
+        g.setColour(colour.brighter(0.125f).withMultipliedAlpha(1.45f));
+        for (const auto &r : visibleNotes)
+        {
+            const float w = r.getWidth() - .5f;
+            if (w >= 2.25f)
+            {
+                g.fillRect(r.getX() + 1.25f, roundf(r.getY()), w - 2.25f, 1.f);
+            }
+        }
+
+        g.setColour(colour.darker(0.175f).withMultipliedAlpha(1.45f));
+        for (const auto &r : visibleNotes)
+        {
+            const float w = r.getWidth() - .5f;
+            if (w >= 2.25f)
+            {
+                g.fillRect(r.getX() + 1.25f, roundf(r.getBottom() - 1), w - 2.25f, 1.f);
+            }
+        }
     }
 }
 
@@ -1247,35 +1699,38 @@ void PianoRoll::continueCuttingEvents(const MouseEvent &event)
         this->knifeToolHelper->setEndPosition(event.position);
         this->knifeToolHelper->updateBounds();
 
+        auto *activeMap = this->findActiveSequenceMap();
+        if (activeMap == nullptr)
+        {
+            return;
+        }
+
         bool addsPoint;
         Point<float> intersection;
-        forEachEventComponent(this->patternMap, e)
+        for (const auto &e : *activeMap)
         {
             addsPoint = false;
             auto *nc = e.second.get();
-            if (nc->isActive())
-            {
-                const int h2 = nc->getHeight() / 2;
-                const Line<float> noteLine(nc->getPosition().translated(0, h2).toFloat(),
-                    nc->getPosition().translated(nc->getWidth(), h2).toFloat());
+            const int h2 = nc->getHeight() / 2;
+            const Line<float> noteLine(nc->getPosition().translated(0, h2).toFloat(),
+                nc->getPosition().translated(nc->getWidth(), h2).toFloat());
 
-                if (this->knifeToolHelper->getLine().intersects(noteLine, intersection))
-                {
-                    const float relativeCutBeat = this->getRoundBeatByXPosition(int(intersection.getX()))
-                        - this->activeClip.getBeat() - nc->getBeat();
+            if (this->knifeToolHelper->getLine().intersects(noteLine, intersection))
+            {
+                const float relativeCutBeat = this->getRoundBeatByXPosition(int(intersection.getX()))
+                    - this->activeClip.getBeat() - nc->getBeat();
  
-                    if (relativeCutBeat > 0.f && relativeCutBeat < nc->getLength())
-                    {
-                        addsPoint = true;
-                        this->knifeToolHelper->addOrUpdateCutPoint(nc, relativeCutBeat);
-                    }
-                }
-
-                if (!addsPoint)
+                if (relativeCutBeat > 0.f && relativeCutBeat < nc->getLength())
                 {
-                    this->knifeToolHelper->removeCutPointIfExists(nc->getNote());
+                    addsPoint = true;
+                    this->knifeToolHelper->addOrUpdateCutPoint(nc, relativeCutBeat);
                 }
             }
+
+            if (!addsPoint)
+            {
+                this->knifeToolHelper->removeCutPointIfExists(nc->getNote());
+            }
         }
     }
 }
@@ -1375,6 +1830,9 @@ void PianoRoll::updateChildrenBounds()
     }
 #endif
 
+    // The viewport is zoomed or resized, so more notes might have come into view:
+    this->loadVisibleClipsIfNeeded();
+
     HybridRoll::updateChildrenBounds();
 }
 
@@ -1392,6 +1850,9 @@ void PianoRoll::updateChildrenPositions()
     }
 #endif
 
+    // The viewport is scrolled, so more notes might have come into view:
+    this->loadVisibleClipsIfNeeded();
+
     HybridRoll::updateChildrenPositions();
 }
 
@@ -1459,9 +1920,8 @@ void PianoRoll::updateBackgroundCacheFor(const KeySignatureEvent &key)
     int duplicateSchemeIndex = this->binarySearchForHighlightingScheme(&key);
     if (duplicateSchemeIndex < 0)
     {
-        UniquePointer<HighlightingScheme> scheme(new HighlightingScheme(key.getRootKey(), key.getScale()));
-        scheme->setRows(this->renderBackgroundCacheFor(scheme.get()));
-        this->backgroundsCache.addSorted(*this->defaultHighlighting, scheme.release());
+        auto *scheme = new HighlightingScheme(key.getRootKey(), key.getScale());
+        this->backgroundsCache.addSorted(*this->defaultHighlighting, scheme);
     }
 
 #if DEBUG
@@ -1508,19 +1968,20 @@ void PianoRoll::removeBackgroundCacheFor(const KeySignatureEvent &key)
 #endif
 }
 
-Array<Image> PianoRoll::renderBackgroundCacheFor(const HighlightingScheme *const scheme) const
+// Only the current row height's pattern is rendered, when first painted,
+// instead of all the possible row heights for every key signature on load
+const Image PianoRoll::getBackgroundCacheFor(HighlightingScheme *const scheme)
 {
-    Array<Image> result;
-    const auto &theme = HelioTheme::getCurrentTheme();
-    for (int j = 0; j < PIANOROLL_MIN_ROW_HEIGHT; ++j)
-    {
-        result.add({});
-    }
-    for (int j = PIANOROLL_MIN_ROW_HEIGHT; j <= PIANOROLL_MAX_ROW_HEIGHT; ++j)
+    auto image = scheme->getUnchecked(this->rowHeight);
+    if (image.isNull())
     {
-        result.add(PianoRoll::renderRowsPattern(theme, scheme->getScale(), scheme->getRootKey(), j));
+        image = PianoRoll::renderRowsPattern(HelioTheme::getCurrentTheme(),
+            scheme->getScale(), scheme->getRootKey(), this->rowHeight);
+
+        scheme->setRows(this->rowHeight, image);
     }
-    return result;
+
+    return image;
 }
 
 // pre-rendered tiles are used in paint() method to fill the background,
@@ -1605,7 +2066,10 @@ Image PianoRoll::renderRowsPattern(const HelioTheme &theme,
 }
 
 PianoRoll::HighlightingScheme::HighlightingScheme(int rootKey, const Scale::Ptr scale) noexcept :
-    rootKey(rootKey), scale(scale) {}
+    rootKey(rootKey), scale(scale)
+{
+    this->rows.resize(PIANOROLL_MAX_ROW_HEIGHT + 1);
+}
 
 int PianoRoll::binarySearchForHighlightingScheme(const KeySignatureEvent *const target) const noexcept
 {
@@ -39,6 +39,7 @@ class Scale;
 #include "HelioTheme.h"
 #include "NoteResizerLeft.h"
 #include "NoteResizerRight.h"
+#include "NoteComponentsIndex.h"
 #include "Note.h"
 #include "Clip.h"
 
@@ -181,7 +182,18 @@ private:
 private:
 
     void reloadRollContent();
-    void loadTrack(const MidiTrack *const track);
+    bool loadTrack(const MidiTrack *const track);
+    void loadClip(const Clip &clip);
+    void loadActiveClip();
+
+    // Note components are only created for the notes within the viewport
+    // (plus the margin of one screen on both sides) and for the active clip,
+    // the rest of them are loaded as soon as they scroll into that range:
+    Range<float> loadedBeatRange;
+    Range<float> getVisibleBeatRange() const;
+    bool isClipInLoadedRange(const Clip &clip) const;
+    bool isNoteInLoadedRange(const Note &note, const Clip &clip) const;
+    void loadVisibleClipsIfNeeded();
 
     void updateChildrenBounds() override;
     void updateChildrenPositions() override;
@@ -233,8 +245,8 @@ private:
 
         const Scale::Ptr getScale() const noexcept { return this->scale; }
         const int getRootKey() const noexcept { return this->rootKey; }
-        const Image getUnchecked(int i) const noexcept { return this->rows.getUnchecked(i); }
-        void setRows(Array<Image> val) noexcept { this->rows = val; }
+        const Image getUnchecked(int i) const noexcept { return this->rows[i]; }
+        void setRows(int i, Image val) noexcept { this->rows.set(i, val); }
 
     private:
         Scale::Ptr scale;
@@ -245,7 +257,7 @@ private:
 
     void updateBackgroundCacheFor(const KeySignatureEvent &key);
     void removeBackgroundCacheFor(const KeySignatureEvent &key);
-    Array<Image> renderBackgroundCacheFor(const HighlightingScheme *const scheme) const;
+    const Image getBackgroundCacheFor(HighlightingScheme *const scheme);
     static Image renderRowsPattern(const HelioTheme &, const Scale::Ptr, int root, int height);
     OwnedArray<HighlightingScheme> backgroundsCache;
     UniquePointer<HighlightingScheme> defaultHighlighting;
@@ -271,6 +283,24 @@ private:
     using SequenceMap = FlatHashMap<Note, UniquePointer<NoteComponent>, MidiEventHash>;
     using PatternMap = FlatHashMap<Clip, UniquePointer<SequenceMap>, ClipHash>;
     PatternMap patternMap;
+    NoteComponent *loadNote(SequenceMap &sequenceMap, const Note &note, const Clip &clip);
+
+    // Only the notes of the active clip are the roll's child components;
+    // all other note components are never added to the roll or resized,
+    // they only keep the note references, and the roll paints their notes
+    // in one batched pass over the visible area:
+    void updateNoteComponentActivity(NoteComponent *nc, bool isActive);
+    SequenceMap *findActiveSequenceMap() const;
+    NoteComponent *findInactiveNoteAt(const Point<float> &position) const;
+    void paintInactiveNotes(Graphics &g) const;
+
+    // all note components by their positions in the roll, for hit-testing and lasso;
+    // it is updated along with the pattern map, using the notes' and clips' parameters
+    // at the moment of the update, since the components refer to the changed ones:
+    NoteComponentsIndex notesIndex;
+    void addToNotesIndex(NoteComponent *nc, const Note &note, const Clip &clip);
+    void removeFromNotesIndex(NoteComponent *nc, const Note &note, const Clip &clip);
+    void getKeysRangeByYPositions(int y1, int y2, int &outMinKey, int &outMaxKey) const noexcept;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PianoRoll);
 };